@@ -41,6 +41,15 @@ struct TrackMetadata
     QString mbid;  // MusicBrainz ID
 };
 
+// One tracklist of an album, e.g. a language version, a disc or a bonus EP
+struct TrackListCandidate
+{
+    QString name;               // Caption or sub-heading, may be empty
+    QList<TrackMetadata> tracks;
+    QString releaseId;          // MusicBrainz release of a release group, if it is one
+    QList<int> discTrackCounts; // Tracks per disc, also known for a release whose tracks were not listed
+};
+
 struct AlbumMetadata
 {
     QString album;
@@ -52,6 +61,7 @@ struct AlbumMetadata
     QString sourceUrl;
     SourceType source{SourceType::Wikipedia};
     QList<TrackMetadata> tracks;
+    QList<TrackListCandidate> candidates; // Every tracklist found; tracks holds the one in use
 };
 
 } // namespace Tagger
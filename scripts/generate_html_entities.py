@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Regenerates src/sources/htmlentities.cpp from the HTML5 named character
+reference list (the WHATWG entities.json, as shipped in html.entities)."""
+
+import html.entities
+import os
+
+OUTPUT = os.path.join(os.path.dirname(__file__), "..", "src", "sources", "htmlentities.cpp")
+
+
+def c_string(data: bytes) -> str:
+    # Octal escapes never swallow the following character
+    return '"' + "".join(chr(b) if 0x20 <= b < 0x7F and chr(b) not in '"\\?' else "\\%03o" % b for b in data) + '"'
+
+
+def main():
+    entries = sorted((name.encode(), value.encode()) for name, value in html.entities.html5.items())
+
+    lines = [
+        "// Generated by scripts/generate_html_entities.py - do not edit.",
+        "",
+        '#include "htmlentities.h"',
+        "",
+        "#include <algorithm>",
+        "",
+        "namespace {",
+        "struct Entity",
+        "{",
+        "    const char* name; // Without the '&'; names that require it end in ';'",
+        "    const char* utf8;",
+        "};",
+        "",
+        "// Sorted by name (byte order) for binary search",
+        "constexpr Entity Entities[] = {",
+    ]
+    lines += ["    {%s, %s}," % (c_string(name), c_string(value)) for name, value in entries]
+    lines += [
+        "};",
+        "",
+        "const Entity* findEntity(QByteArrayView name)",
+        "{",
+        "    const auto less = [](const Entity& entity, QByteArrayView key) {",
+        "        return QByteArrayView(entity.name).compare(key) < 0;",
+        "    };",
+        "    const Entity* end = std::end(Entities);",
+        "    const Entity* it = std::lower_bound(std::begin(Entities), end, name, less);",
+        "    return it != end && QByteArrayView(it->name) == name ? it : nullptr;",
+        "}",
+        "} // namespace",
+        "",
+        "namespace HtmlEntities {",
+        "QByteArrayView lookup(QByteArrayView name)",
+        "{",
+        "    const Entity* entity = findEntity(name);",
+        "    return entity ? QByteArrayView(entity->utf8) : QByteArrayView();",
+        "}",
+        "",
+        "qsizetype matchLegacy(QByteArrayView text, QByteArrayView& utf8)",
+        "{",
+        "    // Entities valid without ';' are at most six characters long",
+        "    for(qsizetype length = std::min<qsizetype>(text.size(), 6); length >= 2; --length) {",
+        "        if(const Entity* entity = findEntity(text.first(length))) {",
+        "            utf8 = entity->utf8;",
+        "            return length;",
+        "        }",
+        "    }",
+        "    return 0;",
+        "}",
+        "} // namespace HtmlEntities",
+        "",
+    ]
+
+    with open(OUTPUT, "w", encoding="ascii", newline="\n") as out:
+        out.write("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
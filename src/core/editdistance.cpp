@@ -0,0 +1,123 @@
+#include "editdistance.h"
+
+#include <algorithm>
+
+namespace {
+constexpr qsizetype WordBits = 64;
+
+struct Column
+{
+    std::uint64_t positive{~std::uint64_t{0}}; // Vertical deltas of +1
+    std::uint64_t negative{0};                 // Vertical deltas of -1
+};
+} // namespace
+
+EditDistance::EditDistance(QStringView pattern)
+    : m_length{pattern.size()}
+    , m_blocks{std::max<qsizetype>((pattern.size() + WordBits - 1) / WordBits, 1)}
+    , m_absent(m_blocks, 0)
+{
+    for(const QChar c : pattern) {
+        m_units.append(c.unicode());
+    }
+    std::sort(m_units.begin(), m_units.end());
+    m_units.resize(std::unique(m_units.begin(), m_units.end()) - m_units.begin());
+
+    m_masks.resize(m_units.size() * m_blocks);
+    std::fill(m_masks.begin(), m_masks.end(), 0);
+    for(qsizetype i = 0; i < pattern.size(); ++i) {
+        const auto* unit = std::lower_bound(m_units.cbegin(), m_units.cend(), pattern[i].unicode());
+        const qsizetype index = (unit - m_units.cbegin()) * m_blocks + i / WordBits;
+        m_masks[index] |= std::uint64_t{1} << (i % WordBits);
+    }
+}
+
+const std::uint64_t* EditDistance::masks(char16_t unit) const
+{
+    const auto* found = std::lower_bound(m_units.cbegin(), m_units.cend(), unit);
+    if(found == m_units.cend() || *found != unit) {
+        return m_absent.constData();
+    }
+    return m_masks.constData() + (found - m_units.cbegin()) * m_blocks;
+}
+
+qsizetype EditDistance::distance(QStringView text) const
+{
+    if(m_length == 0) {
+        return text.size();
+    }
+
+    // Row m of the edit matrix, followed along the text through the bottom bit of the last block
+    qsizetype distance = m_length;
+    const std::uint64_t last = std::uint64_t{1} << ((m_length - 1) % WordBits);
+
+    if(m_blocks == 1) {
+        Column column;
+        for(const QChar c : text) {
+            const std::uint64_t equal = *masks(c.unicode());
+            const std::uint64_t x = equal | column.negative;
+            const std::uint64_t diagonal = (((x & column.positive) + column.positive) ^ column.positive) | x;
+            std::uint64_t horizontalPositive = column.negative | ~(diagonal | column.positive);
+            std::uint64_t horizontalNegative = diagonal & column.positive;
+
+            distance += (horizontalPositive & last) != 0;
+            distance -= (horizontalNegative & last) != 0;
+
+            // Row 0 grows by one per text character
+            horizontalPositive = (horizontalPositive << 1) | 1;
+            horizontalNegative <<= 1;
+            column.positive = horizontalNegative | ~(diagonal | horizontalPositive);
+            column.negative = horizontalPositive & diagonal;
+        }
+        return distance;
+    }
+
+    QVarLengthArray<Column, 4> columns(m_blocks);
+    for(const QChar c : text) {
+        const std::uint64_t* equal = masks(c.unicode());
+        std::uint64_t positiveCarry{1};
+        std::uint64_t negativeCarry{0};
+
+        for(qsizetype block = 0; block < m_blocks; ++block) {
+            Column& column = columns[block];
+            const std::uint64_t x = equal[block] | negativeCarry;
+            const std::uint64_t diagonal
+                = (((x & column.positive) + column.positive) ^ column.positive) | x | column.negative;
+            std::uint64_t horizontalPositive = column.negative | ~(diagonal | column.positive);
+            std::uint64_t horizontalNegative = diagonal & column.positive;
+
+            // The top bit of each block feeds the next one
+            const std::uint64_t positiveIn = positiveCarry;
+            const std::uint64_t negativeIn = negativeCarry;
+            if(block + 1 < m_blocks) {
+                positiveCarry = horizontalPositive >> (WordBits - 1);
+                negativeCarry = horizontalNegative >> (WordBits - 1);
+            }
+            else {
+                distance += (horizontalPositive & last) != 0;
+                distance -= (horizontalNegative & last) != 0;
+            }
+
+            horizontalPositive = (horizontalPositive << 1) | positiveIn;
+            horizontalNegative = (horizontalNegative << 1) | negativeIn;
+            column.positive = horizontalNegative | ~(diagonal | horizontalPositive);
+            column.negative = horizontalPositive & diagonal;
+        }
+    }
+    return distance;
+}
+
+double EditDistance::similarity(QStringView text) const
+{
+    const qsizetype longer = std::max(m_length, text.size());
+    if(longer == 0) {
+        return 1.0;
+    }
+    return 1.0 - static_cast<double>(distance(text)) / static_cast<double>(longer);
+}
+
+qsizetype EditDistance::distance(QStringView a, QStringView b)
+{
+    // The shorter string as the pattern needs the fewest blocks
+    return a.size() <= b.size() ? EditDistance(a).distance(b) : EditDistance(b).distance(a);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QStringView>
+#include <QVarLengthArray>
+
+#include <cstdint>
+
+// Levenshtein distance with Myers' bit-parallel algorithm, in Hyyrö's
+// formulation. The pattern is prepared once as one bitmask per distinct
+// code unit, marking where it occurs; each code unit of a text then
+// advances a whole column of the edit matrix with a few word operations.
+// Patterns up to 64 code units fit one 64-bit word, longer ones are split
+// into blocks of words with the carries passed from block to block.
+class EditDistance
+{
+public:
+    explicit EditDistance(QStringView pattern);
+
+    [[nodiscard]] qsizetype patternLength() const { return m_length; }
+
+    // Insertions, deletions and substitutions turning the pattern into text
+    [[nodiscard]] qsizetype distance(QStringView text) const;
+    // 1 - distance / length of the longer string, 1 for two empty strings
+    [[nodiscard]] double similarity(QStringView text) const;
+
+    static qsizetype distance(QStringView a, QStringView b);
+
+private:
+    [[nodiscard]] const std::uint64_t* masks(char16_t unit) const;
+
+    qsizetype m_length;
+    qsizetype m_blocks;
+    // Inline for titles of one block, which is most of them
+    QVarLengthArray<char16_t, 64> m_units;      // Distinct code units of the pattern, sorted
+    QVarLengthArray<std::uint64_t, 64> m_masks; // m_blocks words per unit, in the order of m_units
+    QVarLengthArray<std::uint64_t, 4> m_absent; // All zero, for units the pattern lacks
+};
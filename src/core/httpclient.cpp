@@ -0,0 +1,524 @@
+#include "httpclient.h"
+#include "responsecache.h"
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QUrlQuery>
+#include <QDebug>
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+Q_LOGGING_CATEGORY(httpClientLog, "fooyin.tagger.http", QtWarningMsg)
+
+namespace {
+QString laneName(RequestScheduler::Lane lane)
+{
+    switch(lane) {
+        case RequestScheduler::Lane::Interactive:
+            return QStringLiteral("interactive");
+        case RequestScheduler::Lane::Batch:
+            return QStringLiteral("batch");
+        case RequestScheduler::Lane::Idle:
+            return QStringLiteral("idle");
+    }
+    return {};
+}
+} // namespace
+
+HttpClient::HttpClient(QObject* parent)
+    : QObject(parent)
+    , m_network(new QNetworkAccessManager(this))
+    , m_userAgent(QStringLiteral("fooyin-tagger/0.1.0 ( https://github.com/jalabulajunx/fooyin_tagger )"))
+    , m_dispatchTimer(new QTimer(this))
+{
+    m_dispatchTimer->setSingleShot(true);
+    connect(m_dispatchTimer, &QTimer::timeout, this, &HttpClient::dispatch);
+    setCacheDirectory(ResponseCache::defaultDirectory());
+}
+
+void HttpClient::setRateLimit(const QString& host, double requestsPerSecond, int burst)
+{
+    m_scheduler.setRate(host.toLower(), requestsPerSecond, burst);
+    // The queue may move sooner under the new budget
+    scheduleDispatch();
+}
+
+double HttpClient::rateLimit(const QString& host) const
+{
+    return m_scheduler.rate(host.toLower());
+}
+
+int HttpClient::queuedRequests(const QString& host) const
+{
+    return static_cast<int>(m_scheduler.queued(host.toLower()));
+}
+
+RequestScheduler::LaneStats HttpClient::laneStats(const QString& host, Lane lane) const
+{
+    return m_scheduler.laneStats(host.toLower(), lane);
+}
+
+void HttpClient::setRetryPolicy(const QString& host, const RetryPolicy& policy)
+{
+    m_retryPolicies.insert(host.toLower(), policy);
+}
+
+RetryPolicy HttpClient::retryPolicy(const QString& host) const
+{
+    return m_retryPolicies.value(host.toLower());
+}
+
+void HttpClient::setCompressionEnabled(bool enabled)
+{
+    m_compression = enabled;
+}
+
+void HttpClient::setKeepAliveEnabled(bool enabled)
+{
+    m_keepAlive = enabled;
+}
+
+void HttpClient::setUserAgent(const QString& userAgent)
+{
+    m_userAgent = userAgent;
+}
+
+void HttpClient::setCacheDirectory(const QString& directory)
+{
+    // The network manager owns the cache and deletes the previous one
+    m_cache = directory.isEmpty() ? nullptr : new ResponseCache(directory);
+    m_network->setCache(m_cache);
+}
+
+HttpRequest* HttpClient::get(const QUrl& url, QObject* requester, Lane lane)
+{
+    auto* request = new HttpRequest(this, url, requester);
+    ++m_coalescing.requests;
+
+    const QString key = transferKey(url);
+    if(const Transfer transfer = m_transfers.value(key)) {
+        join(transfer, request, lane);
+        return request;
+    }
+
+    auto transfer = std::make_shared<HttpTransfer>();
+    transfer->key = key;
+    transfer->url = url;
+    transfer->lane = lane;
+    transfer->waiters.append(request);
+    request->m_transfer = transfer;
+    m_transfers.insert(key, transfer);
+
+    if(const qint64 deadline = retryPolicy(domainKey(url)).deadlineMs; deadline > 0) {
+        transfer->deadline.setRemainingTime(deadline);
+        const std::weak_ptr<HttpTransfer> pending = transfer;
+        QTimer::singleShot(deadline, this, [this, pending]() {
+            if(const Transfer expired = pending.lock()) {
+                expire(expired);
+            }
+        });
+    }
+
+    // Answered from disk, so the server never sees it
+    if(m_cache && m_cache->isFresh(url)) {
+        transfer->waitingForCache = true;
+        m_fromCache.append(transfer);
+    }
+    else {
+        transfer->ticket = m_scheduler.enqueue(domainKey(url), lane);
+        m_queued.insert(transfer->ticket, transfer);
+    }
+
+    scheduleDispatch();
+    return request;
+}
+
+void HttpClient::join(const Transfer& transfer, HttpRequest* request, Lane lane)
+{
+    transfer->waiters.append(request);
+    request->m_transfer = transfer;
+
+    if(transfer->reply) {
+        ++m_coalescing.joinedInFlight;
+        // Started once the event loop runs, like any other request, with what has arrived so far
+        QTimer::singleShot(0, request, [request]() {
+            if(request->m_started || !request->m_transfer) {
+                return;
+            }
+            request->start();
+            if(!request->m_transfer->received.isEmpty()) {
+                emit request->readyRead();
+            }
+        });
+    }
+    else {
+        ++m_coalescing.joinedQueued;
+        // Someone is waiting for a batch or idle request now: move it up to the more urgent lane
+        if(transfer->ticket != 0 && lane < transfer->lane) {
+            m_scheduler.cancel(transfer->ticket);
+            m_queued.remove(transfer->ticket);
+            transfer->lane = lane;
+            transfer->ticket = m_scheduler.enqueue(domainKey(transfer->url), lane);
+            m_queued.insert(transfer->ticket, transfer);
+            scheduleDispatch();
+        }
+    }
+
+    qCDebug(httpClientLog).noquote()
+        << QStringLiteral("Coalesced request for %1 into a %2 transfer (%3 waiting), "
+                          "%4 of %5 requests saved")
+               .arg(transfer->url.toDisplayString())
+               .arg(transfer->reply ? QStringLiteral("running") : QStringLiteral("queued"))
+               .arg(transfer->waiters.size())
+               .arg(m_coalescing.saved())
+               .arg(m_coalescing.requests);
+}
+
+void HttpClient::leave(const Transfer& transfer, HttpRequest* request)
+{
+    transfer->waiters.removeIf([request](const QPointer<HttpRequest>& waiter) {
+        return !waiter || waiter == request;
+    });
+    if(!transfer->waiters.isEmpty()) {
+        return;
+    }
+
+    if(m_transfers.value(transfer->key) == transfer) {
+        m_transfers.remove(transfer->key);
+    }
+    if(transfer->ticket != 0) {
+        m_scheduler.cancel(transfer->ticket);
+        m_queued.remove(transfer->ticket);
+        transfer->ticket = 0;
+    }
+    m_fromCache.removeAll(transfer);
+    transfer->waitingForCache = false;
+
+    if(QNetworkReply* reply = transfer->reply; reply && !reply->isFinished()) {
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+QString HttpClient::domainKey(const QUrl& url)
+{
+    return url.host().toLower();
+}
+
+QString HttpClient::transferKey(const QUrl& url) const
+{
+    // Spellings of the same resource: scheme and host case, default port, fragment, dot segments, query order
+    QUrl normalized = url.adjusted(QUrl::RemoveFragment | QUrl::NormalizePathSegments);
+    const QString scheme = normalized.scheme();
+    if((scheme == QLatin1String("https") && normalized.port() == 443)
+       || (scheme == QLatin1String("http") && normalized.port() == 80)) {
+        normalized.setPort(-1);
+    }
+    if(normalized.hasQuery()) {
+        QUrlQuery query(normalized);
+        auto items = query.queryItems(QUrl::FullyEncoded);
+        std::stable_sort(items.begin(), items.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        query.setQueryItems(items);
+        normalized.setQuery(query);
+    }
+
+    // The only header that varies between requests
+    return QStringLiteral("GET %1\nUser-Agent: %2").arg(normalized.toString(QUrl::FullyEncoded), m_userAgent);
+}
+
+void HttpClient::dispatch()
+{
+    const QList<Transfer> fromCache = std::exchange(m_fromCache, {});
+    for(const Transfer& transfer : fromCache) {
+        send(transfer);
+    }
+
+    // Transfers nobody waits for any more have left the scheduler, so every ticket is live
+    const QList<RequestScheduler::Ready> ready = m_scheduler.takeReady();
+    for(const auto& next : ready) {
+        logSend(next);
+        if(const Transfer transfer = m_queued.take(next.ticket)) {
+            send(transfer);
+        }
+    }
+
+    scheduleDispatch();
+}
+
+void HttpClient::scheduleDispatch()
+{
+    const qint64 wait = m_fromCache.isEmpty() ? m_scheduler.nextReadyIn() : 0;
+    if(wait >= 0) {
+        m_dispatchTimer->start(static_cast<int>(wait));
+    }
+    else {
+        m_dispatchTimer->stop();
+    }
+}
+
+void HttpClient::logSend(const RequestScheduler::Ready& ready) const
+{
+    const double limit = m_scheduler.rate(ready.host);
+    if(limit <= 0 || !httpClientLog().isDebugEnabled()) {
+        return;
+    }
+
+    const RequestScheduler::LaneStats stats = m_scheduler.laneStats(ready.host, ready.lane);
+    qCDebug(httpClientLog).noquote()
+        << QStringLiteral("Rate limit: %1 %2 request waited %3 ms (p50 %4, p90 %5, p99 %6), "
+                          "%7 queued, %8 req/s of %9")
+               .arg(ready.host)
+               .arg(laneName(ready.lane))
+               .arg(ready.waitedMs)
+               .arg(stats.waitP50Ms)
+               .arg(stats.waitP90Ms)
+               .arg(stats.waitP99Ms)
+               .arg(m_scheduler.queued(ready.host))
+               .arg(m_scheduler.effectiveRate(ready.host), 0, 'f', 2)
+               .arg(limit, 0, 'f', 2);
+}
+
+void HttpClient::logTransfer(const HttpTransfer& transfer, const HttpResponse& response) const
+{
+    if(!httpClientLog().isDebugEnabled()) {
+        return;
+    }
+
+    const qint64 body = transfer.received.size();
+    const double ratio = body > 0 ? 100.0 * static_cast<double>(response.wireBytes) / static_cast<double>(body) : 100.0;
+    qCDebug(httpClientLog).noquote()
+        << QStringLiteral("Transfer: %1 %2, %3 bytes on the wire for %4 (%5%), %6, %7 ms; "
+                          "%8 transfers, %9 of %10 bytes, %11 ms in total")
+               .arg(transfer.url.toDisplayString())
+               .arg(response.statusCode)
+               .arg(response.wireBytes)
+               .arg(body)
+               .arg(ratio, 0, 'f', 1)
+               .arg(response.http2 ? QStringLiteral("HTTP/2") : QStringLiteral("HTTP/1.1"))
+               .arg(response.elapsedMs)
+               .arg(m_transferStats.transfers)
+               .arg(m_transferStats.wireBytes)
+               .arg(m_transferStats.bodyBytes)
+               .arg(m_transferStats.elapsedMs);
+}
+
+void HttpClient::send(const Transfer& transfer)
+{
+    transfer->ticket = 0;
+    transfer->waitingForCache = false;
+    ++transfer->attempts;
+    ++m_coalescing.transfers;
+    transfer->wireBytes = 0;
+    transfer->elapsed.start();
+
+    QNetworkRequest networkRequest(transfer->url);
+    networkRequest.setHeader(QNetworkRequest::UserAgentHeader, m_userAgent);
+    networkRequest.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+    // Negotiated through ALPN, so only over TLS; plain HTTP stays on HTTP/1.1
+    networkRequest.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    // Qt offers every encoding it can decode and decompresses transparently, unless the header is set here
+    if(!m_compression) {
+        networkRequest.setRawHeader("Accept-Encoding", "identity");
+    }
+    // Connections stay open in the network manager's per-host pool unless asked to close
+    if(!m_keepAlive) {
+        networkRequest.setRawHeader("Connection", "close");
+    }
+
+    QNetworkReply* reply = m_network->get(networkRequest);
+    transfer->reply = reply;
+
+    // Waiters may cancel themselves, or each other, from their handlers: only those still waiting hear more
+    connect(reply, &QNetworkReply::readyRead, this, [transfer, reply]() {
+        transfer->received += reply->readAll();
+        // Error pages are not streamed to anyone; the transfer fails or is retried
+        if(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() >= 400) {
+            return;
+        }
+        const QList<QPointer<HttpRequest>> waiters = transfer->waiters;
+        for(const auto& waiter : waiters) {
+            if(waiter && waiter->m_transfer == transfer) {
+                waiter->start();
+                emit waiter->readyRead();
+            }
+        }
+    });
+    connect(reply, &QNetworkReply::downloadProgress, this, [transfer](qint64 received, qint64 total) {
+        // Counts what came off the socket, before decompression
+        transfer->wireBytes = received;
+        const QList<QPointer<HttpRequest>> waiters = transfer->waiters;
+        for(const auto& waiter : waiters) {
+            if(waiter && waiter->m_transfer == transfer) {
+                waiter->start();
+                emit waiter->downloadProgress(received, total);
+            }
+        }
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, transfer]() { finish(transfer); });
+
+    const QList<QPointer<HttpRequest>> waiters = transfer->waiters;
+    for(const auto& waiter : waiters) {
+        if(waiter && waiter->m_transfer == transfer) {
+            waiter->start();
+        }
+    }
+}
+
+void HttpClient::finish(const Transfer& transfer)
+{
+    QNetworkReply* reply = transfer->reply;
+    transfer->received += reply->readAll();
+    reply->deleteLater();
+
+    const bool fromCache = reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool();
+    const qint64 wireBytes = transfer->wireBytes > 0 ? transfer->wireBytes : transfer->received.size();
+    const bool http2 = reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool();
+    if(!fromCache) {
+        ++m_transferStats.transfers;
+        m_transferStats.http2 += http2 ? 1 : 0;
+        m_transferStats.wireBytes += wireBytes;
+        m_transferStats.bodyBytes += transfer->received.size();
+        m_transferStats.elapsedMs += transfer->elapsed.elapsed();
+    }
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if(reply->error() != QNetworkReply::NoError) {
+        HttpError error;
+        error.kind = status >= 400 ? HttpError::Kind::Http : HttpError::Kind::Network;
+        error.code = reply->error();
+        error.statusCode = status;
+        error.message = reply->errorString();
+        error.attempts = transfer->attempts;
+        if(!retry(transfer, error, reply->rawHeader("Retry-After"))) {
+            fail(transfer, error);
+        }
+        return;
+    }
+
+    // Requests made from here on get a transfer of their own
+    if(m_transfers.value(transfer->key) == transfer) {
+        m_transfers.remove(transfer->key);
+    }
+    const QList<QPointer<HttpRequest>> waiters = std::exchange(transfer->waiters, {});
+
+    if(m_cache) {
+        m_cache->recordResponse(transfer->url, fromCache);
+        if(httpClientLog().isDebugEnabled()) {
+            const ResponseCache::Stats stats = m_cache->stats();
+            qCDebug(httpClientLog) << "Response cache: hits" << stats.hits << "revalidated" << stats.revalidations
+                                   << "misses" << stats.misses;
+        }
+    }
+
+    HttpResponse response;
+    response.statusCode = status;
+    response.fromCache = fromCache;
+    response.headers = reply->rawHeaderPairs();
+    response.elapsedMs = transfer->elapsed.elapsed();
+    if(!fromCache) {
+        response.wireBytes = wireBytes;
+        response.http2 = http2;
+        logTransfer(*transfer, response);
+    }
+    for(const auto& waiter : waiters) {
+        if(waiter && waiter->m_transfer == transfer) {
+            waiter->finish(response);
+        }
+    }
+}
+
+bool HttpClient::retry(const Transfer& transfer, const HttpError& error, const QByteArray& retryAfter)
+{
+    const QString host = domainKey(transfer->url);
+    const RetryPolicy policy = m_retryPolicies.value(host);
+    if(transfer->attempts >= policy.maxAttempts || !policy.shouldRetry(error)) {
+        return false;
+    }
+
+    const std::optional<qint64> asked = RetryPolicy::parseRetryAfter(retryAfter, QDateTime::currentDateTimeUtc());
+    const qint64 delay
+        = asked ? *asked : policy.backoffMs(transfer->attempts, QRandomGenerator::global()->generateDouble());
+    if(!transfer->deadline.isForever() && transfer->deadline.remainingTime() <= delay) {
+        return false;
+    }
+
+    // Another attempt sends the body from its start, which those who took some of it already would read twice
+    const auto streamed = [](const QPointer<HttpRequest>& waiter) { return waiter && waiter->m_read > 0; };
+    if(std::all_of(transfer->waiters.cbegin(), transfer->waiters.cend(), streamed)) {
+        return false;
+    }
+
+    // The server is struggling with all of our requests, not just this one
+    m_scheduler.holdOff(host, delay);
+
+    transfer->reply = nullptr;
+    transfer->received.clear();
+    transfer->ticket = m_scheduler.enqueue(host, transfer->lane);
+    m_queued.insert(transfer->ticket, transfer);
+    scheduleDispatch();
+
+    // Whoever streamed part of the body gets the failure; the others wait for the next attempt
+    QList<QPointer<HttpRequest>> failed;
+    std::copy_if(transfer->waiters.cbegin(), transfer->waiters.cend(), std::back_inserter(failed), streamed);
+    transfer->waiters.removeIf(streamed);
+    for(const auto& waiter : std::as_const(failed)) {
+        if(waiter && waiter->m_transfer == transfer) {
+            waiter->finish(error);
+        }
+    }
+
+    qCDebug(httpClientLog).noquote()
+        << QStringLiteral("Retrying %1 in %2 ms (%3 %4, attempt %5 of %6), %7 held off")
+               .arg(transfer->url.toDisplayString())
+               .arg(delay)
+               .arg(error.statusCode)
+               .arg(error.message)
+               .arg(transfer->attempts + 1)
+               .arg(policy.maxAttempts)
+               .arg(host);
+    return true;
+}
+
+void HttpClient::fail(const Transfer& transfer, const HttpError& error)
+{
+    if(m_transfers.value(transfer->key) == transfer) {
+        m_transfers.remove(transfer->key);
+    }
+    const QList<QPointer<HttpRequest>> waiters = std::exchange(transfer->waiters, {});
+    for(const auto& waiter : waiters) {
+        if(waiter && waiter->m_transfer == transfer) {
+            waiter->finish(error);
+        }
+    }
+}
+
+void HttpClient::expire(const Transfer& transfer)
+{
+    if(transfer->waiters.isEmpty()) {
+        return;
+    }
+
+    if(transfer->ticket != 0) {
+        m_scheduler.cancel(transfer->ticket);
+        m_queued.remove(transfer->ticket);
+        transfer->ticket = 0;
+    }
+    m_fromCache.removeAll(transfer);
+    if(QNetworkReply* reply = transfer->reply; reply && !reply->isFinished()) {
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+
+    HttpError error;
+    error.code = QNetworkReply::TimeoutError;
+    error.message = tr("No answer within %1 s").arg(retryPolicy(domainKey(transfer->url)).deadlineMs / 1000.0);
+    error.attempts = transfer->attempts;
+    fail(transfer, error);
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "httprequest.h"
+#include "requestscheduler.h"
+#include "retrypolicy.h"
+
+#include <QHash>
+#include <QList>
+#include <QLoggingCategory>
+#include <QObject>
+#include <QUrl>
+
+#include <memory>
+
+// Debug output of every request, from the client and the sources that use it.
+// Off unless enabled, e.g. with QT_LOGGING_RULES="fooyin.tagger.http.debug=true".
+Q_DECLARE_LOGGING_CATEGORY(httpClientLog)
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QTimer;
+class ResponseCache;
+
+// Shared HTTP client for all metadata sources.
+// Sends a descriptive User-Agent (required by MusicBrainz and Wikimedia).
+class HttpClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Lane = RequestScheduler::Lane;
+
+    struct CoalescingStats
+    {
+        quint64 requests{0};       // get() calls
+        quint64 transfers{0};      // Transfers started for them
+        quint64 joinedQueued{0};   // Requests that joined a queued transfer
+        quint64 joinedInFlight{0}; // Requests that joined a running transfer
+
+        // Requests that did not need a transfer of their own
+        [[nodiscard]] quint64 saved() const { return joinedQueued + joinedInFlight; }
+    };
+
+    struct TransferStats
+    {
+        quint64 transfers{0}; // Answered over the network, errors included
+        quint64 http2{0};     // Of those, over HTTP/2
+        qint64 wireBytes{0};  // Bodies as received, before decompression
+        qint64 bodyBytes{0};  // Bodies after decompression
+        qint64 elapsedMs{0};  // Wall time from leaving the queue to the last byte, summed
+    };
+
+    explicit HttpClient(QObject* parent = nullptr);
+
+    // Budget of requests to host; requestsPerSecond <= 0 removes the limit.
+    // Each host has its own, so requests to others never wait behind it.
+    void setRateLimit(const QString& host, double requestsPerSecond, int burst = 1);
+    [[nodiscard]] double rateLimit(const QString& host) const;
+    // Requests to host still waiting for their slot, in every lane
+    [[nodiscard]] int queuedRequests(const QString& host) const;
+    // Queue depth and wait percentiles of one lane of host
+    [[nodiscard]] RequestScheduler::LaneStats laneStats(const QString& host, Lane lane) const;
+
+    // Applies to requests made from now on. While a retry waits, the whole host is held off.
+    void setRetryPolicy(const QString& host, const RetryPolicy& policy);
+    [[nodiscard]] RetryPolicy retryPolicy(const QString& host) const;
+
+    // Offers gzip and deflate, and brotli or zstd where Qt was built with them. On by default.
+    void setCompressionEnabled(bool enabled);
+    [[nodiscard]] bool compressionEnabled() const { return m_compression; }
+    // Reuses connections to a host between requests. On by default. HTTP/2 is used where TLS negotiates it.
+    void setKeepAliveEnabled(bool enabled);
+    [[nodiscard]] bool keepAliveEnabled() const { return m_keepAlive; }
+
+    void setUserAgent(const QString& userAgent);
+    [[nodiscard]] QString userAgent() const { return m_userAgent; }
+
+    // Moves the response cache to directory; an empty path disables caching.
+    // Requests the cache can answer from disk skip the queue.
+    void setCacheDirectory(const QString& directory);
+    // nullptr while caching is disabled
+    [[nodiscard]] ResponseCache* cache() const { return m_cache; }
+
+    // Queues a GET request in its lane of the host's domain. The returned
+    // request is a child of requester and starts once the event loop runs,
+    // so its signals can be connected first. Identical GETs (same normalized
+    // URL and headers) queued or in flight at the same time share one transfer.
+    HttpRequest* get(const QUrl& url, QObject* requester, Lane lane = Lane::Interactive);
+
+    [[nodiscard]] CoalescingStats coalescingStats() const { return m_coalescing; }
+    // What fetches over the network cost; httpClientLog tells what each one did
+    [[nodiscard]] TransferStats transferStats() const { return m_transferStats; }
+
+private:
+    friend class HttpRequest;
+
+    using Transfer = std::shared_ptr<HttpTransfer>;
+
+    [[nodiscard]] static QString domainKey(const QUrl& url);
+    // Identifies the transfer a GET of url would make
+    [[nodiscard]] QString transferKey(const QUrl& url) const;
+    void join(const Transfer& transfer, HttpRequest* request, Lane lane);
+    // Drops the transfer once request was the last one waiting for it
+    void leave(const Transfer& transfer, HttpRequest* request);
+    void dispatch();
+    void scheduleDispatch();
+    void send(const Transfer& transfer);
+    void finish(const Transfer& transfer);
+    // Queues the transfer again if its host's policy allows another attempt
+    bool retry(const Transfer& transfer, const HttpError& error, const QByteArray& retryAfter);
+    void fail(const Transfer& transfer, const HttpError& error);
+    // Fails the transfer when its deadline passes while it is queued or running
+    void expire(const Transfer& transfer);
+    void logSend(const RequestScheduler::Ready& ready) const;
+    void logTransfer(const HttpTransfer& transfer, const HttpResponse& response) const;
+
+    QNetworkAccessManager* m_network;
+    ResponseCache* m_cache{nullptr};
+    QString m_userAgent;
+    bool m_compression{true};
+    bool m_keepAlive{true};
+    RequestScheduler m_scheduler;
+    QHash<QString, Transfer> m_transfers; // Queued or running, by transfer key
+    QHash<quint64, Transfer> m_queued;    // Keyed by scheduler ticket
+    QList<Transfer> m_fromCache;          // Fresh in the cache, started on the next dispatch
+    QHash<QString, RetryPolicy> m_retryPolicies;
+    CoalescingStats m_coalescing;
+    TransferStats m_transferStats;
+    QTimer* m_dispatchTimer;
+};
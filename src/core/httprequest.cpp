@@ -0,0 +1,81 @@
+#include "httprequest.h"
+#include "httpclient.h"
+
+#include <utility>
+
+QByteArray HttpResponse::header(QByteArrayView name) const
+{
+    for(const auto& [headerName, value] : headers) {
+        if(QByteArrayView(headerName).compare(name, Qt::CaseInsensitive) == 0) {
+            return value;
+        }
+    }
+    return {};
+}
+
+HttpRequest::HttpRequest(HttpClient* client, const QUrl& url, QObject* requester)
+    : QObject(requester)
+    , m_client(client)
+    , m_url(url)
+{
+}
+
+HttpRequest::~HttpRequest()
+{
+    release();
+}
+
+QByteArray HttpRequest::readAvailable()
+{
+    if(!m_transfer) {
+        return {};
+    }
+
+    const QByteArray& received = m_transfer->received;
+    QByteArray chunk = received.mid(m_read);
+    m_read = received.size();
+    return chunk;
+}
+
+void HttpRequest::cancel()
+{
+    release();
+    deleteLater();
+}
+
+void HttpRequest::start()
+{
+    if(!std::exchange(m_started, true)) {
+        emit started();
+    }
+}
+
+void HttpRequest::finish(HttpResponse response)
+{
+    response.url = m_url;
+    response.body = m_transfer->received.mid(m_read);
+    m_transfer.reset();
+    deleteLater();
+
+    start();
+    emit succeeded(response);
+}
+
+void HttpRequest::finish(HttpError error)
+{
+    error.url = m_url;
+    m_transfer.reset();
+    deleteLater();
+
+    start();
+    emit failed(error);
+}
+
+void HttpRequest::release()
+{
+    if(std::shared_ptr<HttpTransfer> transfer = std::exchange(m_transfer, nullptr)) {
+        if(m_client) {
+            m_client->leave(transfer, this);
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "requestscheduler.h"
+
+#include <QByteArray>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QList>
+#include <QNetworkReply>
+#include <QObject>
+#include <QPointer>
+#include <QUrl>
+
+#include <memory>
+
+class HttpClient;
+class HttpRequest;
+
+// A request that finished with a 2xx status
+struct HttpResponse
+{
+    QUrl url; // As requested, before any redirect
+    int statusCode{0};
+    bool fromCache{false};
+    QByteArray body; // Whatever was not taken with HttpRequest::readAvailable()
+    QList<QNetworkReply::RawHeaderPair> headers;
+    qint64 wireBytes{0}; // Body size as received, before decompression; 0 from the cache
+    qint64 elapsedMs{0}; // From leaving the queue to the last byte
+    bool http2{false};
+
+    // Case-insensitive; empty if the header was not sent
+    [[nodiscard]] QByteArray header(QByteArrayView name) const;
+};
+
+// A request that did not
+struct HttpError
+{
+    enum class Kind
+    {
+        Network, // No usable answer: connection, TLS, timeout
+        Http     // The server answered with an error status
+    };
+
+    Kind kind{Kind::Network};
+    QNetworkReply::NetworkError code{QNetworkReply::UnknownNetworkError};
+    int statusCode{0};
+    QString message;
+    QUrl url;
+    int attempts{1}; // Transfers made before giving up, retries included
+};
+
+// One network transfer shared by every HttpRequest for the same GET.
+// Internal to HttpClient, which creates it for the first request and
+// drops it when the last one waiting for it is cancelled.
+struct HttpTransfer
+{
+    QString key; // Normalized URL and headers
+    QUrl url;
+    RequestScheduler::Lane lane{RequestScheduler::Lane::Interactive};
+    quint64 ticket{0};             // Scheduler ticket while queued
+    bool waitingForCache{false};   // Queued to be answered from the cache
+    QPointer<QNetworkReply> reply; // Owned by the client's network manager
+    QByteArray received;           // Everything read from reply so far
+    int attempts{0};               // Transfers started, retries included
+    qint64 wireBytes{0};           // Received so far, before decompression
+    QElapsedTimer elapsed;         // Since the current attempt left the queue
+    QDeadlineTimer deadline{QDeadlineTimer::Forever};
+    QList<QPointer<HttpRequest>> waiters;
+};
+
+// One GET request made through HttpClient::get().
+// The request is a child of the object that made it, and its signals reach
+// only that object. It ends with exactly one of succeeded() or failed(),
+// after which it deletes itself; keep it in a QPointer.
+class HttpRequest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~HttpRequest() override;
+
+    [[nodiscard]] QUrl url() const { return m_url; }
+    [[nodiscard]] bool isQueued() const { return m_transfer && !m_transfer->reply; }
+
+    // Takes the body received so far, for parsing while the download runs.
+    // A request that took some is not retried, as the next attempt would
+    // send that part again; it fails instead.
+    QByteArray readAvailable();
+
+    // Drops the request from the queue, or stops waiting for its transfer,
+    // which only ends once no other request shares it. No signals follow.
+    // Destroying the requester does the same.
+    void cancel();
+
+signals:
+    // Left the queue; the transfer is running
+    void started();
+    void readyRead();
+    void downloadProgress(qint64 received, qint64 total);
+
+    void succeeded(const HttpResponse& response);
+    // Failures the host's RetryPolicy retries are not reported, only the last attempt's
+    void failed(const HttpError& error);
+
+private:
+    friend class HttpClient;
+
+    HttpRequest(HttpClient* client, const QUrl& url, QObject* requester);
+
+    // Emits started() unless it already has
+    void start();
+    // Ends the request with the shared outcome of its transfer
+    void finish(HttpResponse response);
+    void finish(HttpError error);
+    // Stops waiting for the transfer, without signals
+    void release();
+
+    QPointer<HttpClient> m_client;
+    QUrl m_url;
+    std::shared_ptr<HttpTransfer> m_transfer;
+    qsizetype m_read{0}; // Bytes of the transfer taken with readAvailable()
+    bool m_started{false};
+};
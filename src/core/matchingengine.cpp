@@ -0,0 +1,454 @@
+#include "matchingengine.h"
+#include "editdistance.h"
+#include "trackfeatures.h"
+#include "titlebatch.h"
+#include "transliteration.h"
+
+#include <QRegularExpression>
+#include <QStringList>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+
+namespace {
+// Durations further apart than this, and than a fifth of the longer one, are different recordings
+constexpr int MinDurationGap = 20;
+constexpr double DurationGapShare = 0.2;
+
+constexpr double TitleWeight = 0.7;
+constexpr double DurationWeight = 0.3;
+
+// Title similarity is the mean of Jaro-Winkler and the word set channel
+constexpr double JaroWinklerShare = 0.5;
+
+// Sounding alike in romanization is weaker evidence than the same spelling
+constexpr double PhoneticKeyWeight = 0.9;
+
+// Among equally good pairings, prefer keeping tracks in the same position
+constexpr double PositionBonus = 1e-6;
+
+// Difference at which two durations stop being the same recording
+double durationGap(int a, int b, int tolerance)
+{
+    return std::max({static_cast<double>(MinDurationGap), DurationGapShare * std::max(a, b),
+                     static_cast<double>(tolerance) + 1.0});
+}
+
+QString normalize(const QString& title, bool dropBrackets)
+{
+    // "01 - Title", "1. Title", "03_Title", "02 Title"
+    static const QRegularExpression trackNumber(QStringLiteral(R"(^\s*(?:\d{1,3}\s*[-._)]|0\d\s)\s*)"));
+    const qsizetype start = trackNumber.match(title).capturedLength();
+
+    QString normalized;
+    normalized.reserve(title.size() - start);
+    int depth{0};
+    for(qsizetype i = start; i < title.size(); ++i) {
+        const QChar c = title.at(i);
+        if(dropBrackets && (c == QLatin1Char('(') || c == QLatin1Char('[') || c == QLatin1Char('{'))) {
+            ++depth;
+        }
+        else if(dropBrackets && (c == QLatin1Char(')') || c == QLatin1Char(']') || c == QLatin1Char('}'))) {
+            depth = std::max(depth - 1, 0);
+        }
+        else if(depth > 0) {
+            continue;
+        }
+        else if(c.isLetterOrNumber() || c.isMark()) {
+            normalized += c.toCaseFolded();
+            continue;
+        }
+
+        // Quotes, punctuation and brackets separate words like spaces do
+        if(!normalized.isEmpty() && !normalized.endsWith(QLatin1Char(' '))) {
+            normalized += QLatin1Char(' ');
+        }
+    }
+
+    if(normalized.endsWith(QLatin1Char(' '))) {
+        normalized.chop(1);
+    }
+    return normalized;
+}
+
+// Each title's words as their ranks among all distinct words, sorted and without repeats.
+// Rank order is alphabetical order, and rank lists merge with integer compares.
+QList<QList<int>> rankWords(const QList<QStringList>& titles, QStringList& vocabulary)
+{
+    vocabulary.clear();
+    for(const QStringList& words : titles) {
+        vocabulary.append(words);
+    }
+    vocabulary.sort();
+    vocabulary.removeDuplicates();
+
+    QList<QList<int>> ranked;
+    ranked.reserve(titles.size());
+    for(const QStringList& words : titles) {
+        QList<int> ranks;
+        ranks.reserve(words.size());
+        for(const QString& word : words) {
+            ranks.append(static_cast<int>(std::lower_bound(vocabulary.cbegin(), vocabulary.cend(), word)
+                                          - vocabulary.cbegin()));
+        }
+        std::sort(ranks.begin(), ranks.end());
+        ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+        ranked.append(ranks);
+    }
+    return ranked;
+}
+
+// Token set ratio on ranked word lists. With the shared words joined as s,
+// and each title as s followed by its own remaining words, the best of
+// comparing s with either title and the two titles with each other. The
+// titles share s as a prefix, so only the remaining words need an edit
+// distance.
+double wordSetRatio(const QList<int>& a, const QList<int>& b, const QStringList& vocabulary)
+{
+    if(a.isEmpty() || b.isEmpty()) {
+        return 0.0;
+    }
+
+    qsizetype sharedLength{0};
+    QVarLengthArray<char16_t, 128> onlyA;
+    QVarLengthArray<char16_t, 128> onlyB;
+    auto appendWord = [&vocabulary](QVarLengthArray<char16_t, 128>& words, int rank) {
+        if(!words.isEmpty()) {
+            words.append(u' ');
+        }
+        const QString& word = vocabulary[rank];
+        words.append(reinterpret_cast<const char16_t*>(word.constData()), word.size());
+    };
+
+    qsizetype i{0};
+    qsizetype j{0};
+    while(i < a.size() || j < b.size()) {
+        if(i < a.size() && j < b.size() && a[i] == b[j]) {
+            sharedLength += (sharedLength > 0 ? 1 : 0) + vocabulary[a[i]].size();
+            ++i;
+            ++j;
+        }
+        else if(j == b.size() || (i < a.size() && a[i] < b[j])) {
+            appendWord(onlyA, a[i++]);
+        }
+        else {
+            appendWord(onlyB, b[j++]);
+        }
+    }
+
+    // One title has no words the other lacks
+    if(onlyA.isEmpty() || onlyB.isEmpty()) {
+        return 1.0;
+    }
+
+    const qsizetype separator = sharedLength > 0 ? 1 : 0;
+    const auto lengthA = static_cast<double>(sharedLength + separator + onlyA.size());
+    const auto lengthB = static_cast<double>(sharedLength + separator + onlyB.size());
+    const auto shared = static_cast<double>(sharedLength);
+    const auto distance = static_cast<double>(EditDistance::distance(QStringView{onlyA.constData(), onlyA.size()},
+                                                                     QStringView{onlyB.constData(), onlyB.size()}));
+
+    return std::max({shared / lengthA, shared / lengthB, 1.0 - distance / std::max(lengthA, lengthB)});
+}
+} // namespace
+
+QList<MatchingEngine::Match> MatchingEngine::match(const QList<Track>& local, const QList<Track>& fetched) const
+{
+    TrackFeatures features;
+    features.reserve(local.size());
+    for(const auto& track : local) {
+        features.append(track.title, track.durationSeconds, track.trackNumber, 0, {});
+    }
+    return match(features, fetched);
+}
+
+QList<MatchingEngine::Match> MatchingEngine::match(const TrackFeatures& local, const QList<Track>& fetched) const
+{
+    const qsizetype rows = local.size();
+    const qsizetype cols = fetched.size();
+    const QList<int>& durations = local.durations();
+    const QList<int>& trackNumbers = local.trackNumbers();
+
+    QList<QString> fetchedTitles;
+    QList<QString> fetchedKeys;
+    QList<bool> fetchedIndic;
+    fetchedTitles.reserve(cols);
+    fetchedKeys.reserve(cols);
+    fetchedIndic.reserve(cols);
+    for(const auto& track : fetched) {
+        const QString title = normalizeTitle(track.title);
+        fetchedTitles.append(title);
+        fetchedKeys.append(Transliteration::phoneticKey(title));
+        fetchedIndic.append(Transliteration::hasIndicLetters(title));
+    }
+
+    // Titles in Tamil, Telugu or Devanagari script share no letters with romanized ones; their phonetic keys may
+    const QList<bool>& localIndic = local.indicTitles();
+    const bool crossScript = localIndic.contains(true) || fetchedIndic.contains(true);
+
+    // Local titles, then local file names, then fetched titles
+    QList<QStringList> words = local.words();
+    words.append(local.fileNameWords());
+    for(const auto& track : fetched) {
+        words.append(titleWords(track.title));
+    }
+    QStringList vocabulary;
+    const QList<QList<int>> rankedWords = rankWords(words, vocabulary);
+
+    QList<double> scores(rows * cols, 0.0);
+    QList<double> similarities(rows * cols, 0.0);
+
+    // Each local title is scored against all fetched ones at once
+    const TitleBatch batch(fetchedTitles);
+    QList<bool> skip(cols);
+    QList<double> rowSimilarities;
+
+    for(qsizetype i = 0; i < rows; ++i) {
+        const QString& title = local.normalizedTitles()[i];
+        const QList<int>& titleRanks = rankedWords[i];
+        const QList<int>& fileNameRanks = rankedWords[rows + i];
+        std::optional<EditDistance> key;
+        if(crossScript) {
+            key.emplace(local.phoneticKeys()[i]);
+        }
+        for(qsizetype j = 0; j < cols; ++j) {
+            skip[j] = durationsExclude(durations[i], fetched[j].durationSeconds);
+        }
+        if(title.isEmpty()) {
+            rowSimilarities.fill(0.0, cols);
+        }
+        else {
+            batch.jaroWinkler(title, rowSimilarities, skip);
+        }
+
+        for(qsizetype j = 0; j < cols; ++j) {
+            if(skip[j]) {
+                continue;
+            }
+            const QList<int>& fetchedRanks = rankedWords[2 * rows + j];
+            double wordSet = wordSetRatio(titleRanks, fetchedRanks, vocabulary);
+            // A file named after the song can make up for a placeholder title tag
+            if(!fileNameRanks.isEmpty() && wordSet < 1.0) {
+                wordSet = std::max(wordSet, wordSetRatio(fileNameRanks, fetchedRanks, vocabulary));
+            }
+            double similarity = JaroWinklerShare * rowSimilarities[j] + (1.0 - JaroWinklerShare) * wordSet;
+            if(key && localIndic[i] != fetchedIndic[j]) {
+                similarity = std::max(similarity, PhoneticKeyWeight * key->similarity(fetchedKeys[j]));
+            }
+            const double pairScore = score(durations[i], fetched[j].durationSeconds, similarity);
+            similarities[i * cols + j] = similarity;
+
+            const bool samePosition = trackNumbers[i] > 0 && fetched[j].trackNumber > 0
+                                        ? trackNumbers[i] == fetched[j].trackNumber
+                                        : i == j;
+            scores[i * cols + j] = pairScore > 0.0 && samePosition ? pairScore + PositionBonus : pairScore;
+        }
+    }
+
+    const QList<int> assigned = solve(scores, rows, cols);
+
+    QList<Match> matches(rows);
+    for(qsizetype i = 0; i < rows; ++i) {
+        const int j = assigned[i];
+        if(j < 0) {
+            continue;
+        }
+        Match& match = matches[i];
+        match.index = j;
+        match.titleSimilarity = similarities[i * cols + j];
+        match.confidence = std::min(score(durations[i], fetched[j].durationSeconds, match.titleSimilarity), 1.0);
+        match.durationMatches = durations[i] > 0 && fetched[j].durationSeconds > 0
+                             && std::abs(durations[i] - fetched[j].durationSeconds) <= m_durationTolerance;
+    }
+    return matches;
+}
+
+QStringList MatchingEngine::titleWords(const QString& title)
+{
+    return normalize(title, false).split(QLatin1Char(' '), Qt::SkipEmptyParts);
+}
+
+double MatchingEngine::wordSetSimilarity(const QString& a, const QString& b)
+{
+    QStringList vocabulary;
+    const QList<QList<int>> ranked = rankWords({titleWords(a), titleWords(b)}, vocabulary);
+    return wordSetRatio(ranked[0], ranked[1], vocabulary);
+}
+
+QString MatchingEngine::normalizeTitle(const QString& title)
+{
+    QString normalized = normalize(title, true);
+    // A title that is nothing but an aside, like "(Interlude)"
+    if(normalized.isEmpty()) {
+        normalized = normalize(title, false);
+    }
+    return normalized;
+}
+
+double MatchingEngine::jaroWinkler(QStringView a, QStringView b)
+{
+    if(a == b) {
+        return 1.0;
+    }
+    if(a.isEmpty() || b.isEmpty()) {
+        return 0.0;
+    }
+
+    const qsizetype window = std::max<qsizetype>(std::max(a.size(), b.size()) / 2 - 1, 0);
+    QVarLengthArray<bool, 128> aMatched(a.size(), false);
+    QVarLengthArray<bool, 128> bMatched(b.size(), false);
+
+    qsizetype matches{0};
+    for(qsizetype i = 0; i < a.size(); ++i) {
+        const qsizetype from = std::max<qsizetype>(i - window, 0);
+        const qsizetype to = std::min(i + window + 1, b.size());
+        for(qsizetype j = from; j < to; ++j) {
+            if(!bMatched[j] && a[i] == b[j]) {
+                aMatched[i] = true;
+                bMatched[j] = true;
+                ++matches;
+                break;
+            }
+        }
+    }
+    if(matches == 0) {
+        return 0.0;
+    }
+
+    // Matched characters that are out of order, counted in pairs
+    qsizetype transpositions{0};
+    qsizetype j{0};
+    for(qsizetype i = 0; i < a.size(); ++i) {
+        if(!aMatched[i]) {
+            continue;
+        }
+        while(!bMatched[j]) {
+            ++j;
+        }
+        if(a[i] != b[j]) {
+            ++transpositions;
+        }
+        ++j;
+    }
+
+    const auto m = static_cast<double>(matches);
+    const double jaro = (m / static_cast<double>(a.size()) + m / static_cast<double>(b.size())
+                         + (m - static_cast<double>(transpositions) / 2.0) / m)
+                      / 3.0;
+
+    // Winkler: up to four characters of common prefix count extra
+    qsizetype prefix{0};
+    while(prefix < std::min<qsizetype>({a.size(), b.size(), 4}) && a[prefix] == b[prefix]) {
+        ++prefix;
+    }
+    return jaro + static_cast<double>(prefix) * 0.1 * (1.0 - jaro);
+}
+
+QList<int> MatchingEngine::solve(const QList<double>& scores, qsizetype rows, qsizetype cols)
+{
+    QList<int> assigned(rows, -1);
+    if(rows == 0 || cols == 0) {
+        return assigned;
+    }
+
+    // The algorithm below wants no more rows than columns; solve the transposed matrix otherwise
+    const bool transposed = rows > cols;
+    const qsizetype n = transposed ? cols : rows;
+    const qsizetype m = transposed ? rows : cols;
+    auto cost = [&](qsizetype i, qsizetype j) {
+        // Minimises cost, 1-indexed
+        const double score = transposed ? scores[(j - 1) * cols + (i - 1)] : scores[(i - 1) * cols + (j - 1)];
+        return -score;
+    };
+
+    // Hungarian algorithm with potentials, O(n² m): every row in turn is
+    // added along the cheapest augmenting path through the columns
+    constexpr double Infinity = std::numeric_limits<double>::infinity();
+    QList<double> u(n + 1, 0.0);
+    QList<double> v(m + 1, 0.0);
+    QList<qsizetype> owner(m + 1, 0); // Row holding each column, 0 for none
+    QList<qsizetype> way(m + 1, 0);
+    QList<double> minCost(m + 1);
+    QList<bool> visited(m + 1);
+
+    for(qsizetype i = 1; i <= n; ++i) {
+        owner[0] = i;
+        qsizetype column{0};
+        std::fill(minCost.begin(), minCost.end(), Infinity);
+        std::fill(visited.begin(), visited.end(), false);
+
+        do {
+            visited[column] = true;
+            const qsizetype row = owner[column];
+            double delta{Infinity};
+            qsizetype next{0};
+            for(qsizetype j = 1; j <= m; ++j) {
+                if(visited[j]) {
+                    continue;
+                }
+                const double reduced = cost(row, j) - u[row] - v[j];
+                if(reduced < minCost[j]) {
+                    minCost[j] = reduced;
+                    way[j] = column;
+                }
+                if(minCost[j] < delta) {
+                    delta = minCost[j];
+                    next = j;
+                }
+            }
+            for(qsizetype j = 0; j <= m; ++j) {
+                if(visited[j]) {
+                    u[owner[j]] += delta;
+                    v[j] -= delta;
+                }
+                else {
+                    minCost[j] -= delta;
+                }
+            }
+            column = next;
+        } while(owner[column] != 0);
+
+        // Flip the augmenting path
+        do {
+            const qsizetype previous = way[column];
+            owner[column] = owner[previous];
+            column = previous;
+        } while(column != 0);
+    }
+
+    for(qsizetype j = 1; j <= m; ++j) {
+        if(owner[j] == 0) {
+            continue;
+        }
+        const qsizetype row = transposed ? j - 1 : owner[j] - 1;
+        const qsizetype col = transposed ? owner[j] - 1 : j - 1;
+        // Pairs nothing was found for only fill up the assignment
+        if(scores[row * cols + col] > 0.0) {
+            assigned[row] = static_cast<int>(col);
+        }
+    }
+    return assigned;
+}
+
+double MatchingEngine::score(int localDuration, int fetchedDuration, double titleSimilarity) const
+{
+    if(localDuration <= 0 || fetchedDuration <= 0) {
+        return titleSimilarity;
+    }
+
+    // Full marks within the tolerance, falling to none where the durations rule the pair out
+    const int diff = std::abs(localDuration - fetchedDuration);
+    const double gap = durationGap(localDuration, fetchedDuration, m_durationTolerance);
+    const double durationScore = diff <= m_durationTolerance
+                                   ? 1.0
+                                   : std::max(0.0, 1.0 - (diff - m_durationTolerance) / (gap - m_durationTolerance));
+    return TitleWeight * titleSimilarity + DurationWeight * durationScore;
+}
+
+bool MatchingEngine::durationsExclude(int a, int b) const
+{
+    return a > 0 && b > 0 && std::abs(a - b) > durationGap(a, b, m_durationTolerance);
+}
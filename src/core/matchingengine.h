@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+class TrackFeatures;
+
+// Pairs local tracks with the tracks of a fetched album.
+// Titles are normalized once per track (for local tracks ahead of time, in
+// their TrackFeatures), then every local track is scored against every
+// fetched one. Title similarity has two channels: Jaro-Winkler on the
+// titles without their bracketed asides, computed a row at a time by a
+// TitleBatch, and a word set comparison with the asides kept, so that
+// "(Reprise)" or "(Female Version)" still tells otherwise equal titles
+// apart and reordered or extra words cost little. A title in Tamil, Telugu
+// or Devanagari script and a romanized one are compared by their phonetic
+// keys instead (see Transliteration). That is weighed with how close the
+// durations are where both are known. Pairs whose durations are
+// too far apart to be the same recording are ruled out without comparing
+// titles. The pairing with the highest total score over all tracks is then
+// found with the Hungarian algorithm, so one early pick cannot take the
+// partner a later track needed, as it could when walking the tracks in
+// order. Among equally good pairings, tracks keep their track number, or
+// else their position.
+class MatchingEngine
+{
+public:
+    struct Track
+    {
+        QString title;
+        int durationSeconds{0}; // 0 if unknown
+        int trackNumber{0};     // 0 if unknown
+    };
+
+    struct Match
+    {
+        int index{-1};          // Fetched track paired with the local one, -1 for none
+        double confidence{0.0}; // Score of the pair, 0 to 1
+        double titleSimilarity{0.0};
+        bool durationMatches{false}; // Both durations known and within the tolerance
+    };
+
+    // Durations this far apart, or further, still count as the same track
+    void setDurationTolerance(int seconds) { m_durationTolerance = seconds; }
+    [[nodiscard]] int durationTolerance() const { return m_durationTolerance; }
+
+    // One entry per local track
+    [[nodiscard]] QList<Match> match(const QList<Track>& local, const QList<Track>& fetched) const;
+    // The same with the local tracks' titles already normalized and split, as prepared on loading them
+    [[nodiscard]] QList<Match> match(const TrackFeatures& local, const QList<Track>& fetched) const;
+
+    // Lowercase, without leading track numbers, bracketed asides, quotes and punctuation
+    static QString normalizeTitle(const QString& title);
+    // Lowercase words of a title, asides included
+    static QStringList titleWords(const QString& title);
+    static double jaroWinkler(QStringView a, QStringView b);
+    // Token set ratio of the words of two titles, asides included, from edit distances (0 to 1).
+    // Titles whose words all appear in the other score 1.
+    static double wordSetSimilarity(const QString& a, const QString& b);
+
+    // Maximum-score assignment on a rows × cols matrix stored row by row.
+    // Returns the column given to each row, -1 where the row is left out or
+    // only a pair scoring 0 was left for it.
+    static QList<int> solve(const QList<double>& scores, qsizetype rows, qsizetype cols);
+
+private:
+    // Title similarity, weighed with how close the durations are where both are known
+    [[nodiscard]] double score(int localDuration, int fetchedDuration, double titleSimilarity) const;
+    // Durations known on both sides and too far apart for the same recording
+    [[nodiscard]] bool durationsExclude(int a, int b) const;
+
+    int m_durationTolerance{3};
+};
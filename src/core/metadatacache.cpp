@@ -0,0 +1,384 @@
+#include "metadatacache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDebug>
+
+#include <limits>
+
+namespace {
+constexpr char FileMagic[4] = {'F', 'T', 'M', 'C'};
+constexpr quint64 FormatVersion = 2;
+constexpr auto FileSuffix = ".album";
+
+// Appends varints to a byte buffer and interns strings into the table
+class Writer
+{
+public:
+    void varint(quint64 value)
+    {
+        while(value >= 0x80) {
+            m_data.append(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        m_data.append(static_cast<char>(value));
+    }
+
+    void number(qint64 value)
+    {
+        // Zigzag, so that small negative numbers stay short too
+        varint((static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63));
+    }
+
+    void string(const QString& text)
+    {
+        if(text.isEmpty()) {
+            varint(0);
+            return;
+        }
+        const auto it = m_indices.constFind(text);
+        if(it != m_indices.cend()) {
+            varint(it.value());
+            return;
+        }
+        const auto index = static_cast<quint64>(m_strings.size()) + 1;
+        m_indices.insert(text, index);
+        m_strings.append(text);
+        varint(index);
+    }
+
+    [[nodiscard]] const QByteArray& data() const { return m_data; }
+    [[nodiscard]] const QStringList& strings() const { return m_strings; }
+
+private:
+    QByteArray m_data;
+    QHash<QString, quint64> m_indices;
+    QStringList m_strings;
+};
+
+// Reads what Writer wrote; every read fails once the data runs out or is malformed
+class Reader
+{
+public:
+    explicit Reader(QByteArrayView data)
+        : m_data(data)
+    {
+    }
+
+    bool varint(quint64& value)
+    {
+        value = 0;
+        for(int shift = 0; shift < 64; shift += 7) {
+            if(m_pos >= m_data.size()) {
+                return false;
+            }
+            const auto byte = static_cast<quint8>(m_data[m_pos++]);
+            value |= static_cast<quint64>(byte & 0x7F) << shift;
+            if(!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool number(int& value)
+    {
+        quint64 raw{0};
+        if(!varint(raw)) {
+            return false;
+        }
+        const auto decoded = static_cast<qint64>((raw >> 1) ^ (~(raw & 1) + 1));
+        if(decoded < std::numeric_limits<int>::min() || decoded > std::numeric_limits<int>::max()) {
+            return false;
+        }
+        value = static_cast<int>(decoded);
+        return true;
+    }
+
+    bool count(qsizetype& value)
+    {
+        // Every counted item takes at least one byte, which bounds allocations on corrupt input
+        quint64 raw{0};
+        if(!varint(raw) || raw > static_cast<quint64>(m_data.size() - m_pos)) {
+            return false;
+        }
+        value = static_cast<qsizetype>(raw);
+        return true;
+    }
+
+    bool bytes(QByteArrayView& value, qsizetype size)
+    {
+        if(size > m_data.size() - m_pos) {
+            return false;
+        }
+        value = m_data.sliced(m_pos, size);
+        m_pos += size;
+        return true;
+    }
+
+    bool readTable()
+    {
+        qsizetype size{0};
+        if(!count(size)) {
+            return false;
+        }
+        m_strings.reserve(size);
+        for(qsizetype i = 0; i < size; ++i) {
+            qsizetype length{0};
+            QByteArrayView utf8;
+            if(!count(length) || !bytes(utf8, length)) {
+                return false;
+            }
+            m_strings.append(QString::fromUtf8(utf8));
+        }
+        return true;
+    }
+
+    bool string(QString& value)
+    {
+        quint64 index{0};
+        if(!varint(index) || index > static_cast<quint64>(m_strings.size())) {
+            return false;
+        }
+        value = index == 0 ? QString{} : m_strings[static_cast<qsizetype>(index) - 1];
+        return true;
+    }
+
+    [[nodiscard]] bool atEnd() const { return m_pos == m_data.size(); }
+
+private:
+    QByteArrayView m_data;
+    qsizetype m_pos{0};
+    QStringList m_strings;
+};
+
+void writeTrack(Writer& writer, const Tagger::TrackMetadata& track)
+{
+    writer.string(track.title);
+    writer.string(track.artist);
+    writer.string(track.album);
+    writer.string(track.albumArtist);
+    writer.string(track.lyricist);
+    writer.string(track.composer);
+    writer.string(track.musicDirector);
+    writer.string(track.isrc);
+    writer.string(track.mbid);
+    writer.number(track.trackNumber);
+    writer.number(track.totalTracks);
+    writer.number(track.discNumber);
+    writer.number(track.totalDiscs);
+    writer.number(track.year);
+    writer.number(track.durationSeconds);
+}
+
+bool readTrack(Reader& reader, Tagger::TrackMetadata& track)
+{
+    return reader.string(track.title) && reader.string(track.artist) && reader.string(track.album)
+        && reader.string(track.albumArtist) && reader.string(track.lyricist) && reader.string(track.composer)
+        && reader.string(track.musicDirector) && reader.string(track.isrc) && reader.string(track.mbid)
+        && reader.number(track.trackNumber) && reader.number(track.totalTracks) && reader.number(track.discNumber)
+        && reader.number(track.totalDiscs) && reader.number(track.year) && reader.number(track.durationSeconds);
+}
+
+void writeTracks(Writer& writer, const QList<Tagger::TrackMetadata>& tracks)
+{
+    writer.varint(static_cast<quint64>(tracks.size()));
+    for(const auto& track : tracks) {
+        writeTrack(writer, track);
+    }
+}
+
+bool readTracks(Reader& reader, QList<Tagger::TrackMetadata>& tracks)
+{
+    qsizetype size{0};
+    if(!reader.count(size)) {
+        return false;
+    }
+    tracks.resize(size);
+    for(auto& track : tracks) {
+        if(!readTrack(reader, track)) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+MetadataCache::MetadataCache(const QString& directory)
+{
+    setDirectory(directory);
+}
+
+QString MetadataCache::defaultDirectory()
+{
+    // Next to the HTTP response cache
+    return QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation)
+         + QStringLiteral("/fooyin/tagger/metadata-cache");
+}
+
+void MetadataCache::setDirectory(const QString& directory)
+{
+    m_directory = directory;
+    if(!m_directory.isEmpty()) {
+        QDir().mkpath(m_directory);
+    }
+}
+
+QString MetadataCache::filePath(Tagger::SourceType source, const QString& key) const
+{
+    const QByteArray id = QByteArray::number(static_cast<int>(source)) + '\n' + key.toUtf8();
+    return m_directory + QLatin1Char('/')
+         + QString::fromLatin1(QCryptographicHash::hash(id, QCryptographicHash::Sha1).toHex())
+         + QLatin1String(FileSuffix);
+}
+
+std::optional<Tagger::AlbumMetadata> MetadataCache::lookup(Tagger::SourceType source, const QString& key,
+                                                           const QString& revision) const
+{
+    if(!isEnabled()) {
+        return {};
+    }
+
+    QFile file(filePath(source, key));
+    if(!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    std::optional<Entry> entry = decode(file.readAll());
+    if(!entry || entry->source != source || entry->key != key || entry->revision != revision) {
+        return {};
+    }
+    return std::move(entry->metadata);
+}
+
+void MetadataCache::store(Tagger::SourceType source, const QString& key, const QString& revision,
+                          const Tagger::AlbumMetadata& metadata)
+{
+    if(!isEnabled() || revision.isEmpty()) {
+        return;
+    }
+
+    QSaveFile file(filePath(source, key));
+    if(!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Metadata cache: cannot write" << file.fileName() << file.errorString();
+        return;
+    }
+    file.write(encode({source, key, revision, metadata}));
+    if(!file.commit()) {
+        qWarning() << "Metadata cache: cannot write" << file.fileName() << file.errorString();
+    }
+}
+
+void MetadataCache::clear()
+{
+    if(!isEnabled()) {
+        return;
+    }
+
+    QDir dir(m_directory);
+    const QStringList files = dir.entryList({QStringLiteral("*") + QLatin1String(FileSuffix)}, QDir::Files);
+    for(const QString& file : files) {
+        dir.remove(file);
+    }
+}
+
+QByteArray MetadataCache::encode(const Entry& entry)
+{
+    // The body is written first so that the string table is complete when the header goes out
+    Writer body;
+    const Tagger::AlbumMetadata& album = entry.metadata;
+
+    body.string(entry.key);
+    body.string(entry.revision);
+
+    body.string(album.album);
+    body.string(album.albumArtist);
+    body.string(album.musicDirector);
+    body.string(album.country);
+    body.string(album.releaseId);
+    body.string(album.sourceUrl);
+    body.number(album.year);
+    body.number(static_cast<int>(album.source));
+
+    writeTracks(body, album.tracks);
+    body.varint(static_cast<quint64>(album.candidates.size()));
+    for(const auto& candidate : album.candidates) {
+        body.string(candidate.name);
+        writeTracks(body, candidate.tracks);
+        body.string(candidate.releaseId);
+        body.varint(static_cast<quint64>(candidate.discTrackCounts.size()));
+        for(const int count : candidate.discTrackCounts) {
+            body.number(count);
+        }
+    }
+
+    Writer header;
+    header.varint(FormatVersion);
+    header.varint(static_cast<quint64>(entry.source));
+    header.varint(static_cast<quint64>(body.strings().size()));
+    QByteArray data = QByteArray(FileMagic, sizeof(FileMagic)) + header.data();
+    for(const QString& string : body.strings()) {
+        const QByteArray utf8 = string.toUtf8();
+        Writer length;
+        length.varint(static_cast<quint64>(utf8.size()));
+        data += length.data() + utf8;
+    }
+    return data + body.data();
+}
+
+std::optional<MetadataCache::Entry> MetadataCache::decode(const QByteArray& data)
+{
+    if(!data.startsWith(QByteArrayView(FileMagic, sizeof(FileMagic)))) {
+        return {};
+    }
+
+    Reader reader(QByteArrayView(data).sliced(sizeof(FileMagic)));
+    quint64 version{0};
+    quint64 source{0};
+    if(!reader.varint(version) || version != FormatVersion || !reader.varint(source)
+       || source > static_cast<quint64>(Tagger::SourceType::GNUDB) || !reader.readTable()) {
+        return {};
+    }
+
+    Entry entry;
+    entry.source = static_cast<Tagger::SourceType>(source);
+    Tagger::AlbumMetadata& album = entry.metadata;
+
+    int albumSource{0};
+    if(!reader.string(entry.key) || !reader.string(entry.revision) || !reader.string(album.album)
+       || !reader.string(album.albumArtist) || !reader.string(album.musicDirector) || !reader.string(album.country)
+       || !reader.string(album.releaseId) || !reader.string(album.sourceUrl) || !reader.number(album.year)
+       || !reader.number(albumSource) || albumSource < 0 || albumSource > static_cast<int>(Tagger::SourceType::GNUDB)
+       || !readTracks(reader, album.tracks)) {
+        return {};
+    }
+    album.source = static_cast<Tagger::SourceType>(albumSource);
+
+    qsizetype candidates{0};
+    if(!reader.count(candidates)) {
+        return {};
+    }
+    album.candidates.resize(candidates);
+    for(auto& candidate : album.candidates) {
+        qsizetype discs{0};
+        if(!reader.string(candidate.name) || !readTracks(reader, candidate.tracks)
+           || !reader.string(candidate.releaseId) || !reader.count(discs)) {
+            return {};
+        }
+        candidate.discTrackCounts.resize(discs);
+        for(int& count : candidate.discTrackCounts) {
+            if(!reader.number(count)) {
+                return {};
+            }
+        }
+    }
+
+    if(!reader.atEnd()) {
+        return {};
+    }
+    return entry;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <tagger/tagger_common.h>
+
+#include <QByteArray>
+
+#include <optional>
+
+// Second-level cache of parsed albums, so that reopening an album skips
+// both the download and the parse. Entries are keyed by source and URL
+// and tagged with the revision they were parsed from (a Wikipedia revid,
+// or the ETag of a MusicBrainz reply); a lookup with any other revision
+// misses.
+//
+// Each entry is one small file in a compact, versioned binary form:
+//
+//   "FTMC" varint:version varint:source
+//   varint:count { varint:length utf8 }...   string table, index 0 is ""
+//   varint:key varint:revision               string indices
+//   album fields, tracks, candidates         strings as indices, numbers as zigzag varints
+//
+// Repeated strings (album, artists, composers) are stored once. Files of
+// another version are treated as misses and replaced on the next store.
+class MetadataCache
+{
+public:
+    explicit MetadataCache(const QString& directory = {});
+
+    // An empty path disables the cache
+    void setDirectory(const QString& directory);
+    [[nodiscard]] QString directory() const { return m_directory; }
+    [[nodiscard]] bool isEnabled() const { return !m_directory.isEmpty(); }
+
+    [[nodiscard]] std::optional<Tagger::AlbumMetadata> lookup(Tagger::SourceType source, const QString& key,
+                                                              const QString& revision) const;
+    void store(Tagger::SourceType source, const QString& key, const QString& revision,
+               const Tagger::AlbumMetadata& metadata);
+    void clear();
+
+    struct Entry
+    {
+        Tagger::SourceType source{Tagger::SourceType::Wikipedia};
+        QString key;
+        QString revision;
+        Tagger::AlbumMetadata metadata;
+    };
+
+    static QByteArray encode(const Entry& entry);
+    static std::optional<Entry> decode(const QByteArray& data);
+
+    // <config>/fooyin/tagger/metadata-cache
+    static QString defaultDirectory();
+
+private:
+    [[nodiscard]] QString filePath(Tagger::SourceType source, const QString& key) const;
+
+    QString m_directory;
+};
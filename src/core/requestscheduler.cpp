@@ -0,0 +1,247 @@
+#include "requestscheduler.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <utility>
+
+namespace {
+// Keeps refills that land exactly on a whole token or millisecond from missing it by rounding
+constexpr double TokenEpsilon = 1e-9;
+
+constexpr auto laneIndex(RequestScheduler::Lane lane)
+{
+    return static_cast<std::size_t>(lane);
+}
+} // namespace
+
+RequestScheduler::RequestScheduler(Clock clock)
+    : m_clock(std::move(clock))
+{
+    if(!m_clock) {
+        auto timer = std::make_shared<QElapsedTimer>();
+        timer->start();
+        m_clock = [timer]() {
+            return timer->elapsed();
+        };
+    }
+}
+
+void RequestScheduler::setRate(const QString& host, double requestsPerSecond, int burst)
+{
+    Host& state = m_hosts[host];
+    const qint64 now = m_clock();
+    const bool wasLimited = state.ratePerMs > 0;
+    state.tokens = tokensAt(state, now);
+    state.refilledAt = now;
+    state.ratePerMs = requestsPerSecond > 0 ? requestsPerSecond / 1000.0 : 0.0;
+    state.burst = qMax(1, burst);
+    // A host that was not limited so far starts with a full bucket
+    state.tokens = wasLimited ? qMin(state.tokens, state.burst) : state.burst;
+}
+
+double RequestScheduler::rate(const QString& host) const
+{
+    return m_hosts.value(host).ratePerMs * 1000.0;
+}
+
+int RequestScheduler::burst(const QString& host) const
+{
+    return static_cast<int>(m_hosts.value(host).burst);
+}
+
+void RequestScheduler::holdOff(const QString& host, qint64 ms)
+{
+    Host& state = m_hosts[host];
+    const qint64 until = m_clock() + qMax<qint64>(0, ms);
+    if(until <= state.heldOffUntil) {
+        return;
+    }
+
+    state.heldOffUntil = until;
+    if(state.ratePerMs > 0) {
+        // Refills from one token at the end of the hold-off
+        state.tokens = 1.0;
+        state.refilledAt = until;
+    }
+}
+
+qint64 RequestScheduler::heldOffFor(const QString& host) const
+{
+    return qMax<qint64>(0, m_hosts.value(host).heldOffUntil - m_clock());
+}
+
+quint64 RequestScheduler::enqueue(const QString& host, Lane lane)
+{
+    Host& state = m_hosts[host];
+    const quint64 ticket = ++m_lastTicket;
+    state.lanes[laneIndex(lane)].queue.append({ticket, m_clock()});
+    m_ticketHosts.insert(ticket, host);
+    return ticket;
+}
+
+bool RequestScheduler::cancel(quint64 ticket)
+{
+    const auto hostIt = m_ticketHosts.constFind(ticket);
+    if(hostIt == m_ticketHosts.cend()) {
+        return false;
+    }
+
+    Host& state = m_hosts[hostIt.value()];
+    m_ticketHosts.erase(hostIt);
+    for(LaneState& lane : state.lanes) {
+        if(lane.queue.removeIf([ticket](const Queued& queued) { return queued.ticket == ticket; }) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QList<RequestScheduler::Ready> RequestScheduler::takeReady()
+{
+    QList<Ready> ready;
+    const qint64 now = m_clock();
+
+    for(auto it = m_hosts.begin(); it != m_hosts.end(); ++it) {
+        Host& state = it.value();
+        if(now < state.heldOffUntil) {
+            continue;
+        }
+
+        const bool limited = state.ratePerMs > 0;
+        if(limited) {
+            state.tokens = tokensAt(state, now);
+            state.refilledAt = now;
+        }
+
+        for(std::size_t index = 0; index < state.lanes.size(); ++index) {
+            LaneState& lane = state.lanes[index];
+            // Whatever is left of the other lanes waits for the next token
+            const bool idle = index == laneIndex(Lane::Idle);
+            if(idle && !idleSlot(state)) {
+                continue;
+            }
+            const double needed = idle ? state.burst : 1.0;
+            while(!lane.queue.isEmpty() && (!limited || state.tokens >= needed - TokenEpsilon)) {
+                const Queued queued = lane.queue.takeFirst();
+                if(limited) {
+                    state.tokens -= 1.0;
+                }
+
+                const qint64 waited = now - queued.queuedAt;
+                if(lane.waits.size() < WaitHistory) {
+                    lane.waits.append(waited);
+                }
+                else {
+                    lane.waits[lane.nextWait] = waited;
+                }
+                lane.nextWait = (lane.nextWait + 1) % WaitHistory;
+                ++lane.sent;
+
+                state.recentSends.append(now);
+                m_ticketHosts.remove(queued.ticket);
+                ready.append({queued.ticket, it.key(), static_cast<Lane>(index), waited});
+            }
+        }
+
+        state.recentSends.removeIf([now](qint64 sent) { return now - sent > RateWindowMs; });
+    }
+
+    return ready;
+}
+
+qint64 RequestScheduler::nextReadyIn() const
+{
+    const qint64 now = m_clock();
+    qint64 next{-1};
+
+    for(const Host& state : m_hosts) {
+        const bool hasQueued = std::any_of(state.lanes.cbegin(), state.lanes.cend(),
+                                           [](const LaneState& lane) { return !lane.queue.isEmpty(); });
+        if(!hasQueued) {
+            continue;
+        }
+
+        // Only idle requests left: they wait for a full bucket
+        const double needed = idleSlot(state) ? state.burst : 1.0;
+        qint64 wait = qMax<qint64>(0, state.heldOffUntil - now);
+        if(state.ratePerMs > 0 && wait == 0) {
+            const double missing = needed - tokensAt(state, now);
+            if(missing > TokenEpsilon) {
+                wait = static_cast<qint64>(std::ceil(missing / state.ratePerMs - TokenEpsilon));
+            }
+        }
+        next = next < 0 ? wait : qMin(next, wait);
+    }
+
+    return next;
+}
+
+qsizetype RequestScheduler::queued(const QString& host) const
+{
+    const auto it = m_hosts.constFind(host);
+    if(it == m_hosts.cend()) {
+        return 0;
+    }
+    return std::accumulate(it->lanes.cbegin(), it->lanes.cend(), qsizetype{0},
+                           [](qsizetype sum, const LaneState& lane) { return sum + lane.queue.size(); });
+}
+
+RequestScheduler::LaneStats RequestScheduler::laneStats(const QString& host, Lane lane) const
+{
+    const auto it = m_hosts.constFind(host);
+    if(it == m_hosts.cend()) {
+        return {};
+    }
+
+    const LaneState& state = it->lanes[laneIndex(lane)];
+    LaneStats stats;
+    stats.queued = state.queue.size();
+    stats.sent = state.sent;
+    stats.waitP50Ms = percentile(state.waits, 50);
+    stats.waitP90Ms = percentile(state.waits, 90);
+    stats.waitP99Ms = percentile(state.waits, 99);
+    return stats;
+}
+
+double RequestScheduler::effectiveRate(const QString& host) const
+{
+    const auto it = m_hosts.constFind(host);
+    if(it == m_hosts.cend()) {
+        return 0.0;
+    }
+
+    const qint64 now = m_clock();
+    const auto sends = std::count_if(it->recentSends.cbegin(), it->recentSends.cend(),
+                                     [now](qint64 sent) { return now - sent <= RateWindowMs; });
+    return static_cast<double>(sends) * 1000.0 / RateWindowMs;
+}
+
+bool RequestScheduler::idleSlot(const Host& host)
+{
+    return host.lanes[laneIndex(Lane::Interactive)].queue.isEmpty()
+        && host.lanes[laneIndex(Lane::Batch)].queue.isEmpty();
+}
+
+double RequestScheduler::tokensAt(const Host& host, qint64 now)
+{
+    if(host.ratePerMs <= 0) {
+        return host.burst;
+    }
+    return qMin(host.burst, host.tokens + static_cast<double>(now - host.refilledAt) * host.ratePerMs);
+}
+
+qint64 RequestScheduler::percentile(QList<qint64> values, int percent)
+{
+    if(values.isEmpty()) {
+        return 0;
+    }
+
+    // Nearest rank
+    std::sort(values.begin(), values.end());
+    const auto rank = static_cast<qsizetype>(std::ceil(percent / 100.0 * static_cast<double>(values.size())));
+    return values[qBound<qsizetype>(0, rank - 1, values.size() - 1)];
+}
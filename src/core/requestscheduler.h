@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include <array>
+#include <functional>
+
+// Decides when queued HTTP requests may be sent, from a token bucket per host.
+// It only hands out tickets; HttpClient keeps the requests and a timer for nextReadyIn().
+class RequestScheduler
+{
+public:
+    // Lanes of one host, from first to last. They all draw from the host's bucket.
+    enum class Lane
+    {
+        Interactive, // What the user is waiting for
+        Batch,
+        // Speculative prefetches: only sent from a full bucket with both other lanes empty,
+        // so a request made right after one may wait up to one refill interval
+        Idle
+    };
+
+    // Milliseconds on any monotonic clock, so that tests can move time by hand
+    using Clock = std::function<qint64()>;
+
+    struct Ready
+    {
+        quint64 ticket{0};
+        QString host;
+        Lane lane{Lane::Interactive};
+        qint64 waitedMs{0};
+    };
+
+    struct LaneStats
+    {
+        qsizetype queued{0};
+        quint64 sent{0};
+        // Over the last WaitHistory requests sent from the lane
+        qint64 waitP50Ms{0};
+        qint64 waitP90Ms{0};
+        qint64 waitP99Ms{0};
+    };
+
+    static constexpr qsizetype WaitHistory = 256;
+    static constexpr qint64 RateWindowMs = 10000;
+
+    // Uses a steady clock of its own when none is given
+    explicit RequestScheduler(Clock clock = {});
+
+    // The bucket refills at requestsPerSecond up to burst tokens, and each
+    // request sent takes one; requestsPerSecond <= 0 removes the limit.
+    // burst is how many requests may go out back to back after the host has been idle.
+    void setRate(const QString& host, double requestsPerSecond, int burst = 1);
+    [[nodiscard]] double rate(const QString& host) const;
+    [[nodiscard]] int burst(const QString& host) const;
+
+    // Sends nothing more to host for ms milliseconds, then resumes at its
+    // rate with a single token, so the queue does not burst out at once
+    void holdOff(const QString& host, qint64 ms);
+    // Milliseconds left of a hold-off, 0 if there is none
+    [[nodiscard]] qint64 heldOffFor(const QString& host) const;
+
+    quint64 enqueue(const QString& host, Lane lane);
+    bool cancel(quint64 ticket);
+
+    // Takes a token for every request that may be sent now, interactive
+    // lanes first, and returns them in the order to send them
+    QList<Ready> takeReady();
+    // Milliseconds until takeReady() returns something, -1 if nothing is queued
+    [[nodiscard]] qint64 nextReadyIn() const;
+
+    [[nodiscard]] qsizetype queued(const QString& host) const;
+    [[nodiscard]] LaneStats laneStats(const QString& host, Lane lane) const;
+    // Requests per second actually sent to host over the last RateWindowMs
+    [[nodiscard]] double effectiveRate(const QString& host) const;
+
+private:
+    struct Queued
+    {
+        quint64 ticket{0};
+        qint64 queuedAt{0};
+    };
+
+    struct LaneState
+    {
+        QList<Queued> queue;
+        QList<qint64> waits; // Ring of the last WaitHistory waits
+        qsizetype nextWait{0};
+        quint64 sent{0};
+    };
+
+    struct Host
+    {
+        double ratePerMs{0};
+        double burst{1};
+        double tokens{1};
+        qint64 refilledAt{0};
+        qint64 heldOffUntil{0};
+        std::array<LaneState, 3> lanes;
+        QList<qint64> recentSends;
+    };
+
+    // Nothing but idle requests may be waiting for the host
+    [[nodiscard]] static bool idleSlot(const Host& host);
+    [[nodiscard]] static double tokensAt(const Host& host, qint64 now);
+    [[nodiscard]] static qint64 percentile(QList<qint64> values, int percent);
+
+    Clock m_clock;
+    QHash<QString, Host> m_hosts;
+    QHash<quint64, QString> m_ticketHosts;
+    quint64 m_lastTicket{0};
+};
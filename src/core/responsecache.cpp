@@ -0,0 +1,375 @@
+#include "responsecache.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QNetworkRequest>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDebug>
+
+#include <algorithm>
+
+namespace {
+constexpr quint32 FileMagic = 0x46544843; // "FTHC"
+constexpr quint16 FileVersion = 1;
+constexpr auto FileSuffix = ".cache";
+
+constexpr qint64 DefaultMaximumSize = 100 * 1024 * 1024;
+constexpr int DefaultFreshForSecs = 24 * 60 * 60;
+
+qint64 nowMs()
+{
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+// Drops the directives that would make Qt revalidate an entry we still consider fresh
+QByteArray withoutRevalidation(const QByteArray& cacheControl)
+{
+    QList<QByteArray> kept;
+    for(const QByteArray& directive : cacheControl.split(',')) {
+        const QByteArray lower = directive.trimmed().toLower();
+        if(lower != "no-cache" && lower != "must-revalidate" && !lower.startsWith("max-age")) {
+            kept.append(directive.trimmed());
+        }
+    }
+    return kept.join(", ");
+}
+} // namespace
+
+ResponseCache::ResponseCache(const QString& directory, QObject* parent)
+    : QAbstractNetworkCache(parent)
+    , m_directory(directory)
+    , m_maximumSize(DefaultMaximumSize)
+    , m_freshForSecs(DefaultFreshForSecs)
+{
+    QDir().mkpath(m_directory);
+    scan();
+}
+
+QString ResponseCache::defaultDirectory()
+{
+    // Fooyin keeps its configuration in <generic config>/fooyin
+    return QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation)
+         + QStringLiteral("/fooyin/tagger/http-cache");
+}
+
+void ResponseCache::setMaximumSize(qint64 bytes)
+{
+    m_maximumSize = qMax<qint64>(0, bytes);
+    evict();
+}
+
+void ResponseCache::setFreshFor(int seconds)
+{
+    m_freshForSecs = qMax(0, seconds);
+}
+
+bool ResponseCache::isFresh(const QUrl& url) const
+{
+    const auto it = m_entries.constFind(key(url));
+    return it != m_entries.cend() && nowMs() < it->storedAt + m_freshForSecs * 1000LL;
+}
+
+void ResponseCache::recordResponse(const QUrl& url, bool fromCache)
+{
+    const bool revalidated = m_revalidated.remove(url);
+    if(!fromCache) {
+        ++m_stats.misses;
+    }
+    else if(revalidated) {
+        ++m_stats.revalidations;
+    }
+    else {
+        ++m_stats.hits;
+    }
+}
+
+QNetworkCacheMetaData ResponseCache::metaData(const QUrl& url)
+{
+    if(!m_entries.contains(key(url))) {
+        return {};
+    }
+
+    Record record;
+    if(!readRecord(filePath(url), ReadMode::MetaData, record)) {
+        dropEntry(key(url));
+        return {};
+    }
+
+    // Qt serves an entry without asking the server only until its expiration date
+    QNetworkCacheMetaData metaData = record.metaData;
+    const QDateTime freshUntil = QDateTime::fromMSecsSinceEpoch(record.storedAt + m_freshForSecs * 1000LL, Qt::UTC);
+    if(!metaData.expirationDate().isValid() || metaData.expirationDate() < freshUntil) {
+        metaData.setExpirationDate(freshUntil);
+    }
+
+    if(freshUntil > QDateTime::currentDateTimeUtc()) {
+        QNetworkCacheMetaData::RawHeaderList headers = metaData.rawHeaders();
+        for(auto& [name, value] : headers) {
+            if(name.compare("Cache-Control", Qt::CaseInsensitive) == 0) {
+                value = withoutRevalidation(value);
+            }
+        }
+        metaData.setRawHeaders(headers);
+    }
+
+    return metaData;
+}
+
+void ResponseCache::updateMetaData(const QNetworkCacheMetaData& metaData)
+{
+    // A 304: the stored body is current again
+    const QUrl url = metaData.url();
+    Record record;
+    if(!m_entries.contains(key(url)) || !readRecord(filePath(url), ReadMode::Everything, record)) {
+        return;
+    }
+
+    record.storedAt = nowMs();
+    record.metaData = metaData;
+    if(writeRecord(url, record)) {
+        m_revalidated.insert(url);
+    }
+}
+
+QIODevice* ResponseCache::data(const QUrl& url)
+{
+    const QString entryKey = key(url);
+    if(!m_entries.contains(entryKey)) {
+        return nullptr;
+    }
+
+    Record record;
+    if(!readRecord(filePath(url), ReadMode::Everything, record)) {
+        dropEntry(entryKey);
+        return nullptr;
+    }
+    touch(entryKey);
+
+    // The caller takes ownership
+    auto* buffer = new QBuffer;
+    buffer->setData(record.body);
+    buffer->open(QIODevice::ReadOnly);
+    return buffer;
+}
+
+bool ResponseCache::remove(const QUrl& url)
+{
+    // Also used to cancel a download that is being stored
+    for(auto it = m_inserting.begin(); it != m_inserting.end(); ++it) {
+        if(it.value().url() == url) {
+            delete it.key();
+            m_inserting.erase(it);
+            return true;
+        }
+    }
+
+    const QString entryKey = key(url);
+    if(!m_entries.contains(entryKey)) {
+        return false;
+    }
+    dropEntry(entryKey);
+    return true;
+}
+
+QIODevice* ResponseCache::prepare(const QNetworkCacheMetaData& metaData)
+{
+    if(!metaData.isValid() || !metaData.url().isValid() || !metaData.saveToDisk()) {
+        return nullptr;
+    }
+
+    const QVariant status = metaData.attributes().value(QNetworkRequest::HttpStatusCodeAttribute);
+    if(status.isValid() && status.toInt() != 200) {
+        return nullptr;
+    }
+
+    // Bodies that would push most other entries out are not worth keeping
+    for(const auto& [name, value] : metaData.rawHeaders()) {
+        if(name.compare("Content-Length", Qt::CaseInsensitive) == 0 && value.toLongLong() > m_maximumSize * 3 / 4) {
+            return nullptr;
+        }
+    }
+
+    auto* buffer = new QBuffer;
+    buffer->open(QIODevice::ReadWrite);
+    m_inserting.insert(buffer, metaData);
+    return buffer;
+}
+
+void ResponseCache::insert(QIODevice* device)
+{
+    const auto it = m_inserting.constFind(device);
+    if(it == m_inserting.cend()) {
+        return;
+    }
+
+    Record record;
+    record.storedAt = nowMs();
+    record.metaData = it.value();
+    record.body = static_cast<QBuffer*>(device)->data();
+    m_inserting.erase(it);
+    delete device;
+
+    writeRecord(record.metaData.url(), record);
+    evict();
+}
+
+void ResponseCache::clear()
+{
+    qDeleteAll(m_inserting.keyBegin(), m_inserting.keyEnd());
+    m_inserting.clear();
+
+    const QStringList keys = m_entries.keys();
+    for(const QString& entryKey : keys) {
+        dropEntry(entryKey);
+    }
+    m_revalidated.clear();
+}
+
+void ResponseCache::scan()
+{
+    const QDir dir(m_directory);
+    const QFileInfoList files
+        = dir.entryInfoList({QStringLiteral("*") + QLatin1String(FileSuffix)}, QDir::Files | QDir::NoDotAndDotDot);
+
+    for(const QFileInfo& info : files) {
+        Record record;
+        if(!readRecord(info.filePath(), ReadMode::Header, record)) {
+            QFile::remove(info.filePath());
+            continue;
+        }
+
+        Entry entry;
+        entry.size = info.size();
+        entry.storedAt = record.storedAt;
+        entry.lastUsed = info.lastModified().toMSecsSinceEpoch();
+        m_entries.insert(info.fileName(), entry);
+        m_size += entry.size;
+        m_lastUseTime = qMax(m_lastUseTime, entry.lastUsed);
+    }
+
+    qDebug() << "Response cache:" << m_entries.size() << "entries," << m_size / 1024 << "KiB in" << m_directory;
+    evict();
+}
+
+QString ResponseCache::key(const QUrl& url)
+{
+    const QByteArray normalized = url.adjusted(QUrl::RemoveFragment).toEncoded();
+    return QString::fromLatin1(QCryptographicHash::hash(normalized, QCryptographicHash::Sha1).toHex())
+         + QLatin1String(FileSuffix);
+}
+
+QString ResponseCache::filePath(const QUrl& url) const
+{
+    return m_directory + QLatin1Char('/') + key(url);
+}
+
+bool ResponseCache::readRecord(const QString& path, ReadMode mode, Record& record)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic{0};
+    quint16 version{0};
+    stream >> magic >> version >> record.storedAt;
+    if(magic != FileMagic || version != FileVersion) {
+        return false;
+    }
+
+    if(mode != ReadMode::Header) {
+        stream >> record.metaData;
+    }
+    if(mode == ReadMode::Everything) {
+        stream >> record.body;
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+bool ResponseCache::writeRecord(const QUrl& url, const Record& record)
+{
+    QSaveFile file(filePath(url));
+    if(!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Response cache: cannot write" << file.fileName() << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << FileMagic << FileVersion << record.storedAt << record.metaData << record.body;
+    if(stream.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "Response cache: cannot write" << file.fileName() << file.errorString();
+        return false;
+    }
+
+    const QString entryKey = key(url);
+    Entry& entry = m_entries[entryKey];
+    m_size -= entry.size;
+    entry.size = QFileInfo(filePath(url)).size();
+    entry.storedAt = record.storedAt;
+    m_size += entry.size;
+    touch(entryKey);
+    return true;
+}
+
+void ResponseCache::touch(const QString& entryKey)
+{
+    const auto it = m_entries.find(entryKey);
+    if(it == m_entries.end()) {
+        return;
+    }
+    it->lastUsed = nextUseTime();
+
+    // The modification time carries the LRU order over to the next session
+    QFile file(m_directory + QLatin1Char('/') + entryKey);
+    if(file.open(QIODevice::ReadOnly)) {
+        file.setFileTime(QDateTime::fromMSecsSinceEpoch(it->lastUsed, Qt::UTC), QFileDevice::FileModificationTime);
+    }
+}
+
+void ResponseCache::dropEntry(const QString& entryKey)
+{
+    const auto it = m_entries.constFind(entryKey);
+    if(it != m_entries.cend()) {
+        m_size -= it->size;
+        m_entries.erase(it);
+    }
+    QFile::remove(m_directory + QLatin1Char('/') + entryKey);
+}
+
+void ResponseCache::evict()
+{
+    if(m_size <= m_maximumSize) {
+        return;
+    }
+
+    QList<QPair<qint64, QString>> byUse;
+    byUse.reserve(m_entries.size());
+    for(auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        byUse.append({it->lastUsed, it.key()});
+    }
+    std::sort(byUse.begin(), byUse.end());
+
+    for(const auto& [lastUsed, entryKey] : std::as_const(byUse)) {
+        if(m_size <= m_maximumSize) {
+            break;
+        }
+        dropEntry(entryKey);
+        ++m_stats.evictions;
+    }
+}
+
+qint64 ResponseCache::nextUseTime()
+{
+    // Strictly increasing, so uses within the same millisecond keep their order
+    m_lastUseTime = qMax(nowMs(), m_lastUseTime + 1);
+    return m_lastUseTime;
+}
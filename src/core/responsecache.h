@@ -0,0 +1,105 @@
+#pragma once
+
+#include <QAbstractNetworkCache>
+#include <QHash>
+#include <QSet>
+#include <QUrl>
+
+// Persistent HTTP response cache for the metadata sources.
+// Installed on HttpClient's QNetworkAccessManager, which stores every
+// cacheable body together with its ETag and Last-Modified headers and
+// revalidates stale entries with If-None-Match/If-Modified-Since, so an
+// unchanged page costs a 304 instead of a full download.
+//
+// Entries younger than freshFor() are served without contacting the
+// server at all, whatever the server's own Cache-Control says: album
+// pages and releases rarely change, and MusicBrainz allows one request
+// per second. The directory is bounded by maximumSize(); the least
+// recently used entries are evicted first, across restarts.
+class ResponseCache : public QAbstractNetworkCache
+{
+    Q_OBJECT
+
+public:
+    struct Stats
+    {
+        quint64 hits{0};          // Served from disk without a request
+        quint64 revalidations{0}; // Served from disk after a 304
+        quint64 misses{0};        // Downloaded in full
+        quint64 evictions{0};
+    };
+
+    explicit ResponseCache(const QString& directory, QObject* parent = nullptr);
+
+    [[nodiscard]] QString directory() const { return m_directory; }
+
+    void setMaximumSize(qint64 bytes);
+    [[nodiscard]] qint64 maximumSize() const { return m_maximumSize; }
+
+    // 0 revalidates every entry on use
+    void setFreshFor(int seconds);
+    [[nodiscard]] int freshFor() const { return m_freshForSecs; }
+
+    // True if a request for url will be answered from disk without a request
+    [[nodiscard]] bool isFresh(const QUrl& url) const;
+
+    // Called by HttpClient once a reply for url has finished
+    void recordResponse(const QUrl& url, bool fromCache);
+    [[nodiscard]] Stats stats() const { return m_stats; }
+
+    // <config>/fooyin/tagger/http-cache
+    static QString defaultDirectory();
+
+    QNetworkCacheMetaData metaData(const QUrl& url) override;
+    void updateMetaData(const QNetworkCacheMetaData& metaData) override;
+    QIODevice* data(const QUrl& url) override;
+    bool remove(const QUrl& url) override;
+    [[nodiscard]] qint64 cacheSize() const override { return m_size; }
+    QIODevice* prepare(const QNetworkCacheMetaData& metaData) override;
+    void insert(QIODevice* device) override;
+
+public slots:
+    void clear() override;
+
+private:
+    struct Entry
+    {
+        qint64 size{0};
+        qint64 storedAt{0}; // ms since epoch of the last download or 304
+        qint64 lastUsed{0}; // ms since epoch, kept in the file's mtime
+    };
+
+    struct Record
+    {
+        qint64 storedAt{0};
+        QNetworkCacheMetaData metaData;
+        QByteArray body;
+    };
+
+    enum class ReadMode
+    {
+        Header,
+        MetaData,
+        Everything
+    };
+
+    void scan();
+    [[nodiscard]] QString filePath(const QUrl& url) const;
+    [[nodiscard]] static QString key(const QUrl& url);
+    static bool readRecord(const QString& path, ReadMode mode, Record& record);
+    bool writeRecord(const QUrl& url, const Record& record);
+    void touch(const QString& key);
+    void dropEntry(const QString& key);
+    void evict();
+    qint64 nextUseTime();
+
+    QString m_directory;
+    qint64 m_maximumSize;
+    int m_freshForSecs;
+    qint64 m_size{0};
+    qint64 m_lastUseTime{0};
+    QHash<QString, Entry> m_entries;            // Keyed by file name
+    QHash<QIODevice*, QNetworkCacheMetaData> m_inserting;
+    QSet<QUrl> m_revalidated;                   // Refreshed by a 304, not yet reported
+    Stats m_stats;
+};
@@ -0,0 +1,58 @@
+#include "retrypolicy.h"
+
+#include <QLocale>
+#include <QTimeZone>
+
+#include <cmath>
+
+bool RetryPolicy::shouldRetry(const HttpError& error) const
+{
+    if(error.kind == HttpError::Kind::Http) {
+        return retryStatuses.contains(error.statusCode);
+    }
+    if(!retryNetworkErrors) {
+        return false;
+    }
+
+    // Worth another try; refused connections, bad hosts and TLS errors are not
+    switch(error.code) {
+        case QNetworkReply::RemoteHostClosedError:
+        case QNetworkReply::TimeoutError:
+        case QNetworkReply::TemporaryNetworkFailureError:
+        case QNetworkReply::NetworkSessionFailedError:
+        case QNetworkReply::ProxyTimeoutError:
+            return true;
+        default:
+            return false;
+    }
+}
+
+qint64 RetryPolicy::backoffMs(int attempt, double random) const
+{
+    const double exponential = static_cast<double>(baseDelayMs) * std::pow(2.0, qMax(0, attempt - 1));
+    const double capped = qMin(exponential, static_cast<double>(maxDelayMs));
+    return static_cast<qint64>(capped * (1.0 - qBound(0.0, jitter, 1.0) * random));
+}
+
+std::optional<qint64> RetryPolicy::parseRetryAfter(const QByteArray& value, const QDateTime& now)
+{
+    const QByteArray trimmed = value.trimmed();
+    if(trimmed.isEmpty()) {
+        return {};
+    }
+
+    bool isNumber{false};
+    const qint64 seconds = trimmed.toLongLong(&isNumber);
+    if(isNumber) {
+        return seconds >= 0 ? std::optional<qint64>{seconds * 1000} : std::nullopt;
+    }
+
+    // "Sun, 06 Nov 1994 08:49:37 GMT", the only date format servers may send
+    const QDateTime parsed
+        = QLocale::c().toDateTime(QString::fromLatin1(trimmed), QStringLiteral("ddd, dd MMM yyyy hh:mm:ss 'GMT'"));
+    if(!parsed.isValid()) {
+        return {};
+    }
+    const QDateTime date(parsed.date(), parsed.time(), QTimeZone::utc());
+    return qMax<qint64>(0, now.msecsTo(date));
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "httprequest.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+
+#include <optional>
+
+// How HttpClient retries failed requests to one host.
+// A request is retried when the server is overloaded or the connection
+// broke, after an exponential backoff with jitter, or after as long as the
+// server asked for in Retry-After. The defaults never retry.
+struct RetryPolicy
+{
+    int maxAttempts{1};            // Transfers per request, the first one included
+    qint64 baseDelayMs{1000};      // Backoff before the first retry, doubled for each one after
+    qint64 maxDelayMs{60000};      // Backoff never grows beyond this
+    double jitter{0.5};            // Fraction of the backoff taken off at random
+    qint64 deadlineMs{0};          // Give up this long after the request was made; 0 waits forever
+    QList<int> retryStatuses{429, 502, 503, 504};
+    bool retryNetworkErrors{true}; // Dropped connections and timeouts
+
+    [[nodiscard]] bool shouldRetry(const HttpError& error) const;
+    // Backoff before retry number attempt (1 for the first retry); random is in [0, 1)
+    [[nodiscard]] qint64 backoffMs(int attempt, double random) const;
+
+    // Retry-After as delay-seconds or an HTTP date; nullopt if absent or malformed
+    [[nodiscard]] static std::optional<qint64> parseRetryAfter(const QByteArray& value, const QDateTime& now);
+};
@@ -0,0 +1,240 @@
+#include "taggingmanager.h"
+#include "httpclient.h"
+#include "sources/musicbrainzsource.h"
+#include "sources/wikipediasource.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QDebug>
+
+#ifdef HAVE_TAGLIB
+#include <taglib/fileref.h>
+#include <taglib/tpropertymap.h>
+#endif
+
+#include <utility>
+
+namespace {
+struct WriteOutcome
+{
+    int succeeded{0};
+    int failed{0};
+};
+
+#ifdef HAVE_TAGLIB
+TagLib::String toTagLib(const QString& text)
+{
+    return {text.toStdString(), TagLib::String::UTF8};
+}
+
+void setProperty(TagLib::PropertyMap& properties, const char* key, const QString& value)
+{
+    if(!value.isEmpty()) {
+        properties.replace(key, TagLib::StringList(toTagLib(value)));
+    }
+}
+
+bool writeTags(const QString& filepath, const Tagger::TrackMetadata& track,
+               const TaggingManager::TagWriteOptions& options)
+{
+    TagLib::FileRef file(QFile::encodeName(filepath).constData());
+    if(file.isNull() || !file.file()) {
+        qWarning() << "Cannot open" << filepath << "for tagging";
+        return false;
+    }
+
+    TagLib::PropertyMap properties = file.file()->properties();
+    if(options.writeTitle) {
+        setProperty(properties, "TITLE", track.title);
+    }
+    if(options.writeArtist) {
+        setProperty(properties, "ARTIST", track.artist);
+    }
+    if(options.writeAlbum) {
+        setProperty(properties, "ALBUM", track.album);
+        setProperty(properties, "ALBUMARTIST", track.albumArtist);
+    }
+    if(options.writeLyrics) {
+        setProperty(properties, "LYRICIST", track.lyricist);
+    }
+    if(options.writeComposer) {
+        // Film soundtracks credit the music director rather than a composer
+        setProperty(properties, "COMPOSER", track.composer.isEmpty() ? track.musicDirector : track.composer);
+    }
+    if(options.writeYear && track.year > 0) {
+        setProperty(properties, "DATE", QString::number(track.year));
+    }
+    if(options.writeTrackNumber && track.trackNumber > 0) {
+        setProperty(properties, "TRACKNUMBER",
+                    track.totalTracks > 0 ? QStringLiteral("%1/%2").arg(track.trackNumber).arg(track.totalTracks)
+                                          : QString::number(track.trackNumber));
+        if(track.totalDiscs > 1) {
+            setProperty(properties, "DISCNUMBER", QStringLiteral("%1/%2").arg(track.discNumber).arg(track.totalDiscs));
+        }
+    }
+
+    file.file()->setProperties(properties);
+    if(!file.save()) {
+        qWarning() << "Failed to save tags to" << filepath;
+        return false;
+    }
+    return true;
+}
+#else
+bool writeTags(const QString& filepath, const Tagger::TrackMetadata& /*track*/,
+               const TaggingManager::TagWriteOptions& /*options*/)
+{
+    qWarning() << "Built without TagLib, cannot tag" << filepath;
+    return false;
+}
+#endif
+} // namespace
+
+TaggingManager::TaggingManager(QObject* parent)
+    : QObject(parent)
+    , m_httpClient(new HttpClient(this))
+{
+    addSource(new WikipediaSource(m_httpClient, this));
+    addSource(new MusicBrainzSource(m_httpClient, this));
+}
+
+void TaggingManager::addSource(MetadataSource* source)
+{
+    m_sources.insert(source->type(), source);
+
+    connect(source, &MetadataSource::fetchStarted, this, &TaggingManager::fetchStarted);
+    connect(source, &MetadataSource::fetchProgress, this, &TaggingManager::fetchProgress);
+    connect(source, &MetadataSource::fetchCompleted, this, &TaggingManager::fetchCompleted);
+    connect(source, &MetadataSource::fetchFailed, this, &TaggingManager::fetchFailed);
+    connect(source, &MetadataSource::searchResults, this, &TaggingManager::searchResults);
+}
+
+MetadataSource* TaggingManager::source(Tagger::SourceType type) const
+{
+    return m_sources.value(type, nullptr);
+}
+
+void TaggingManager::fetchFromUrl(Tagger::SourceType type, const QString& url)
+{
+    MetadataSource* metadataSource = source(type);
+    if(!metadataSource || !metadataSource->supportsUrlInput()) {
+        emit fetchFailed(tr("This source cannot fetch from a URL"));
+        return;
+    }
+    metadataSource->fetchFromUrl(url);
+}
+
+void TaggingManager::searchAlbum(Tagger::SourceType type, const QString& artist, const QString& album)
+{
+    MetadataSource* metadataSource = source(type);
+    if(!metadataSource || !metadataSource->supportsSearch()) {
+        emit fetchFailed(tr("This source does not support searching"));
+        return;
+    }
+    metadataSource->searchAlbum(artist, album);
+}
+
+void TaggingManager::cancelFetch()
+{
+    for(MetadataSource* metadataSource : std::as_const(m_sources)) {
+        metadataSource->cancel();
+    }
+}
+
+void TaggingManager::setLocalTrackCount(int count)
+{
+    for(MetadataSource* metadataSource : std::as_const(m_sources)) {
+        metadataSource->setLocalTrackCount(count);
+    }
+}
+
+TrackFeatures TaggingManager::trackFeatures(const Fooyin::TrackList& tracks)
+{
+    TrackFeatures features;
+    features.reserve(static_cast<qsizetype>(tracks.size()));
+    for(const auto& track : tracks) {
+        const QString fileName = QFileInfo(track.filepath()).completeBaseName();
+        // Untagged files often carry the title in their name
+        const QString title = track.title().isEmpty() ? fileName : track.title();
+        features.append(title, static_cast<int>(track.duration() / 1000), track.trackNumber().toInt(),
+                        track.discNumber().toInt(), fileName);
+    }
+    return features;
+}
+
+QList<Tagger::MatchResult> TaggingManager::matchTracks(const Fooyin::TrackList& tracks, const TrackFeatures& features,
+                                                       const Tagger::AlbumMetadata& metadata) const
+{
+    QList<MatchingEngine::Track> fetched;
+    fetched.reserve(metadata.tracks.size());
+    for(const auto& track : metadata.tracks) {
+        fetched.append({track.title, track.durationSeconds, track.trackNumber});
+    }
+
+    const bool fits = features.size() == static_cast<qsizetype>(tracks.size());
+    const TrackFeatures recomputed = fits ? TrackFeatures{} : trackFeatures(tracks);
+    const QList<MatchingEngine::Match> matches = m_engine.match(fits ? features : recomputed, fetched);
+
+    QList<Tagger::MatchResult> results;
+    results.reserve(matches.size());
+    for(qsizetype i = 0; i < matches.size(); ++i) {
+        const auto& track = tracks.at(static_cast<std::size_t>(i));
+        const MatchingEngine::Match& match = matches[i];
+
+        Tagger::MatchResult result;
+        result.trackIndex = static_cast<int>(i);
+        result.targetFilepath = track.filepath();
+        result.targetTitle = track.title();
+
+        if(match.index >= 0) {
+            result.metadataIndex = match.index;
+            result.sourceMetadata = metadata.tracks[match.index];
+            result.confidence = match.confidence;
+            if(match.titleSimilarity >= 0.9) {
+                result.matchReason = match.durationMatches ? tr("Title and duration match") : tr("Title match");
+            }
+            else {
+                result.matchReason = match.durationMatches ? tr("Duration match") : tr("Similar title");
+            }
+        }
+        result.selected = result.isValid() && result.confidence >= m_confidenceThreshold;
+        results.append(result);
+    }
+
+    return results;
+}
+
+void TaggingManager::applyTags(const QList<Tagger::MatchResult>& results, const TagWriteOptions& options)
+{
+    QList<Tagger::MatchResult> toWrite;
+    for(const auto& result : results) {
+        if(result.selected && result.isValid() && !result.targetFilepath.isEmpty()) {
+            toWrite.append(result);
+        }
+    }
+
+    QtConcurrent::run(QThreadPool::globalInstance(),
+                      [this, toWrite, options]() {
+                          WriteOutcome outcome;
+                          const auto total = static_cast<int>(toWrite.size());
+                          for(int i = 0; i < total; ++i) {
+                              const auto& result = toWrite[i];
+                              if(writeTags(result.targetFilepath, result.sourceMetadata, options)) {
+                                  ++outcome.succeeded;
+                              }
+                              else {
+                                  ++outcome.failed;
+                              }
+                              QMetaObject::invokeMethod(
+                                  this, [this, i, total]() { emit tagWriteProgress(i + 1, total); },
+                                  Qt::QueuedConnection);
+                          }
+                          return outcome;
+                      })
+        .then(this, [this](const WriteOutcome& outcome) {
+            qDebug() << "Tags written:" << outcome.succeeded << "succeeded," << outcome.failed << "failed";
+            emit tagWriteCompleted(outcome.succeeded, outcome.failed);
+        });
+}
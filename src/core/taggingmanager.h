@@ -0,0 +1,80 @@
+#pragma once
+
+#include "matchingengine.h"
+#include "trackfeatures.h"
+#include "models/matchresult.h"
+
+#include <tagger/tagger_common.h>
+
+#include <core/track.h>
+
+#include <QList>
+#include <QMap>
+#include <QObject>
+
+class HttpClient;
+class MetadataSource;
+
+// Central coordinator between the tagger UI, the metadata sources and the files.
+// Owns one source per SourceType and passes on what they report.
+class TaggingManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct TagWriteOptions
+    {
+        bool writeTitle{true};
+        bool writeArtist{true};
+        bool writeAlbum{true};
+        bool writeLyrics{true}; // Lyricist
+        bool writeYear{true};
+        bool writeComposer{true};
+        bool writeTrackNumber{true};
+    };
+
+    explicit TaggingManager(QObject* parent = nullptr);
+
+    void fetchFromUrl(Tagger::SourceType source, const QString& url);
+    void searchAlbum(Tagger::SourceType source, const QString& artist, const QString& album);
+    void cancelFetch();
+
+    // Number of tracks being tagged, which sources use to guess which results will be wanted
+    void setLocalTrackCount(int count);
+
+    // What matching needs of each track, in the order of tracks; worth keeping for as long as the tracks are
+    [[nodiscard]] static TrackFeatures trackFeatures(const Fooyin::TrackList& tracks);
+
+    // One result per local track, in the order of tracks; unmatched tracks have no metadata index.
+    // features are those of tracks, recomputed if they do not fit them
+    [[nodiscard]] QList<Tagger::MatchResult> matchTracks(const Fooyin::TrackList& tracks, const TrackFeatures& features,
+                                                         const Tagger::AlbumMetadata& metadata) const;
+    [[nodiscard]] const MatchingEngine& matchingEngine() const { return m_engine; }
+
+    // Matches below this confidence (0 to 1) are not selected for writing
+    void setConfidenceThreshold(double threshold) { m_confidenceThreshold = threshold; }
+    [[nodiscard]] double confidenceThreshold() const { return m_confidenceThreshold; }
+    void setDurationTolerance(int seconds) { m_engine.setDurationTolerance(seconds); }
+
+    // Writes the selected, valid results with TagLib on a worker thread;
+    // progress and the outcome arrive through the signals
+    void applyTags(const QList<Tagger::MatchResult>& results, const TagWriteOptions& options);
+
+signals:
+    void fetchStarted();
+    void fetchProgress(int percent);
+    void fetchCompleted(const Tagger::AlbumMetadata& metadata);
+    void fetchFailed(const QString& error);
+    void searchResults(const QList<Tagger::AlbumMetadata>& results);
+    void tagWriteProgress(int current, int total);
+    void tagWriteCompleted(int successCount, int failCount);
+
+private:
+    [[nodiscard]] MetadataSource* source(Tagger::SourceType type) const;
+    void addSource(MetadataSource* source);
+
+    HttpClient* m_httpClient;
+    QMap<Tagger::SourceType, MetadataSource*> m_sources;
+    MatchingEngine m_engine;
+    double m_confidenceThreshold{0.6};
+};
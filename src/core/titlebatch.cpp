@@ -0,0 +1,213 @@
+#include "titlebatch.h"
+#include "matchingengine.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define TAGGER_TITLEBATCH_SSE2
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define TAGGER_TITLEBATCH_AVX2
+#endif
+#endif
+
+namespace {
+using Masks = std::uint64_t[TitleBatch::SlotWidth];
+
+constexpr qsizetype ChunkWidth = 16; // Code units per mask chunk
+
+std::uint64_t lowBits(qsizetype count)
+{
+    return count >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << count) - 1;
+}
+
+// For each query character, the positions of the slot holding the same code unit.
+// Only the first chunks chunks of 16 code units are compared.
+using MaskFunction = void (*)(QStringView query, const char16_t* slot, qsizetype chunks, Masks& masks);
+
+#ifdef TAGGER_TITLEBATCH_SSE2
+void sse2Masks(QStringView query, const char16_t* slot, qsizetype chunks, Masks& masks)
+{
+    __m128i units[TitleBatch::SlotWidth / 8];
+    for(qsizetype k = 0; k < chunks * 2; ++k) {
+        units[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(slot + k * 8));
+    }
+
+    for(qsizetype i = 0; i < query.size(); ++i) {
+        const __m128i c = _mm_set1_epi16(static_cast<short>(query[i].unicode()));
+        std::uint64_t mask{0};
+        for(qsizetype k = 0; k < chunks; ++k) {
+            // Narrow the 16-bit compare results to bytes so one movemask covers 16 units
+            const __m128i equal
+                = _mm_packs_epi16(_mm_cmpeq_epi16(units[2 * k], c), _mm_cmpeq_epi16(units[2 * k + 1], c));
+            mask |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(equal))) << (k * ChunkWidth);
+        }
+        masks[i] = mask;
+    }
+}
+#endif
+
+#ifdef TAGGER_TITLEBATCH_AVX2
+__attribute__((target("avx2"))) void avx2Masks(QStringView query, const char16_t* slot, qsizetype chunks,
+                                                Masks& masks)
+{
+    __m256i units[TitleBatch::SlotWidth / ChunkWidth];
+    for(qsizetype k = 0; k < chunks; ++k) {
+        units[k] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(slot + k * ChunkWidth));
+    }
+
+    for(qsizetype i = 0; i < query.size(); ++i) {
+        const __m256i c = _mm256_set1_epi16(static_cast<short>(query[i].unicode()));
+        std::uint64_t mask{0};
+        qsizetype k{0};
+        for(; k + 1 < chunks; k += 2) {
+            // packs works within 128-bit lanes; the permute puts the units back in order
+            const __m256i packed = _mm256_packs_epi16(_mm256_cmpeq_epi16(units[k], c),
+                                                      _mm256_cmpeq_epi16(units[k + 1], c));
+            const __m256i equal = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+            mask |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm256_movemask_epi8(equal)))
+                 << (k * ChunkWidth);
+        }
+        if(k < chunks) {
+            const __m256i equal = _mm256_cmpeq_epi16(units[k], c);
+            const __m128i narrowed = _mm_packs_epi16(_mm256_castsi256_si128(equal), _mm256_extracti128_si256(equal, 1));
+            mask |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(narrowed))) << (k * ChunkWidth);
+        }
+        masks[i] = mask;
+    }
+}
+#endif
+
+// Same steps and arithmetic as MatchingEngine::jaroWinkler, on the masks of a
+// query against one slot holding a title of length size
+double slotJaroWinkler(QStringView a, const char16_t* b, qsizetype size, MaskFunction maskFunction)
+{
+    if(a.size() == size && std::equal(a.begin(), a.end(), b, [](QChar x, char16_t y) { return x.unicode() == y; })) {
+        return 1.0;
+    }
+    if(a.isEmpty() || size == 0) {
+        return 0.0;
+    }
+
+    Masks masks;
+    maskFunction(a, b, (size + ChunkWidth - 1) / ChunkWidth, masks);
+
+    const qsizetype window = std::max<qsizetype>(std::max(a.size(), size) / 2 - 1, 0);
+    std::uint64_t bFree = lowBits(size);
+    std::uint64_t aMatched{0};
+
+    qsizetype matches{0};
+    for(qsizetype i = 0; i < a.size(); ++i) {
+        const qsizetype from = std::max<qsizetype>(i - window, 0);
+        const qsizetype to = std::min(i + window + 1, size);
+        if(from >= to) {
+            continue;
+        }
+        // The first free, equal unit in the window, as the scalar scan finds it
+        const std::uint64_t candidates = masks[i] & bFree & lowBits(to) & ~lowBits(from);
+        if(candidates != 0) {
+            bFree &= ~(candidates & (~candidates + 1));
+            aMatched |= std::uint64_t{1} << i;
+            ++matches;
+        }
+    }
+    if(matches == 0) {
+        return 0.0;
+    }
+
+    qsizetype transpositions{0};
+    std::uint64_t bMatched = lowBits(size) & ~bFree;
+    for(std::uint64_t aBits = aMatched; aBits != 0; aBits &= aBits - 1) {
+        const int i = std::countr_zero(aBits);
+        const int j = std::countr_zero(bMatched);
+        bMatched &= bMatched - 1;
+        if(a[i].unicode() != b[j]) {
+            ++transpositions;
+        }
+    }
+
+    const auto m = static_cast<double>(matches);
+    const double jaro = (m / static_cast<double>(a.size()) + m / static_cast<double>(size)
+                         + (m - static_cast<double>(transpositions) / 2.0) / m)
+                      / 3.0;
+
+    qsizetype prefix{0};
+    while(prefix < std::min<qsizetype>({a.size(), size, 4}) && a[prefix].unicode() == b[prefix]) {
+        ++prefix;
+    }
+    return jaro + static_cast<double>(prefix) * 0.1 * (1.0 - jaro);
+}
+} // namespace
+
+TitleBatch::TitleBatch(const QList<QString>& titles, Kernel kernel)
+    : m_titles{titles}
+    , m_slots(titles.size() * SlotWidth, u'\0')
+    , m_kernel{isSupported(kernel) ? kernel : bestKernel()}
+{
+    for(qsizetype i = 0; i < titles.size(); ++i) {
+        if(titles[i].size() <= SlotWidth) {
+            std::copy(titles[i].utf16(), titles[i].utf16() + titles[i].size(), m_slots.begin() + i * SlotWidth);
+        }
+    }
+}
+
+TitleBatch::Kernel TitleBatch::bestKernel()
+{
+    static const Kernel best = isSupported(Kernel::Avx2) ? Kernel::Avx2
+                             : isSupported(Kernel::Sse2) ? Kernel::Sse2
+                                                         : Kernel::Scalar;
+    return best;
+}
+
+bool TitleBatch::isSupported(Kernel kernel)
+{
+    switch(kernel) {
+        case Kernel::Scalar:
+            return true;
+        case Kernel::Sse2:
+#ifdef TAGGER_TITLEBATCH_SSE2
+            return true;
+#else
+            return false;
+#endif
+        case Kernel::Avx2:
+#ifdef TAGGER_TITLEBATCH_AVX2
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+void TitleBatch::jaroWinkler(QStringView query, QList<double>& scores, const QList<bool>& skip) const
+{
+    scores.fill(0.0, m_titles.size());
+
+    MaskFunction maskFunction{nullptr};
+#ifdef TAGGER_TITLEBATCH_SSE2
+    if(m_kernel == Kernel::Sse2) {
+        maskFunction = sse2Masks;
+    }
+#endif
+#ifdef TAGGER_TITLEBATCH_AVX2
+    if(m_kernel == Kernel::Avx2) {
+        maskFunction = avx2Masks;
+    }
+#endif
+    if(query.size() > SlotWidth) {
+        maskFunction = nullptr;
+    }
+
+    for(qsizetype i = 0; i < m_titles.size(); ++i) {
+        if(skip.value(i, false)) {
+            continue;
+        }
+        const QString& title = m_titles[i];
+        scores[i] = maskFunction && title.size() <= SlotWidth
+                      ? slotJaroWinkler(query, m_slots.constData() + i * SlotWidth, title.size(), maskFunction)
+                      : MatchingEngine::jaroWinkler(query, title);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+// Titles laid out for scoring one query against all of them at once.
+// Every title is copied into a zero-padded slot of SlotWidth UTF-16 code
+// units, so a query character can be compared with a whole slot in a few
+// vector compares; which characters of the slot match is then kept as a
+// bitmask and Jaro-Winkler runs on those masks. The vector kernel is picked
+// at runtime: AVX2 where the CPU has it, SSE2 on any other x86-64, and
+// MatchingEngine::jaroWinkler one pair at a time elsewhere. Titles or
+// queries longer than a slot take the scalar path too. Every kernel gives
+// exactly the scalar result.
+class TitleBatch
+{
+public:
+    static constexpr qsizetype SlotWidth = 64;
+
+    enum class Kernel
+    {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    TitleBatch() = default;
+    // A kernel the CPU cannot run is replaced by bestKernel()
+    explicit TitleBatch(const QList<QString>& titles, Kernel kernel = bestKernel());
+
+    [[nodiscard]] qsizetype size() const { return m_titles.size(); }
+    [[nodiscard]] Kernel kernel() const { return m_kernel; }
+
+    // Fastest kernel this CPU runs
+    static Kernel bestKernel();
+    [[nodiscard]] static bool isSupported(Kernel kernel);
+
+    // Jaro-Winkler similarity of query to every title, in the order of the titles.
+    // Titles whose entry in skip is true are not compared and score 0.
+    void jaroWinkler(QStringView query, QList<double>& scores, const QList<bool>& skip = {}) const;
+
+private:
+    QList<QString> m_titles;
+    QList<char16_t> m_slots; // SlotWidth code units per title
+    Kernel m_kernel{Kernel::Scalar};
+};
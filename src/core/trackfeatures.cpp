@@ -0,0 +1,38 @@
+#include "trackfeatures.h"
+#include "matchingengine.h"
+#include "transliteration.h"
+
+void TrackFeatures::reserve(qsizetype size)
+{
+    m_titles.reserve(size);
+    m_normalizedTitles.reserve(size);
+    m_words.reserve(size);
+    m_fileNameWords.reserve(size);
+    m_phoneticKeys.reserve(size);
+    m_indicTitles.reserve(size);
+    m_durations.reserve(size);
+    m_trackNumbers.reserve(size);
+    m_discNumbers.reserve(size);
+}
+
+void TrackFeatures::append(const QString& title, int durationSeconds, int trackNumber, int discNumber,
+                           const QString& fileBaseName)
+{
+    const QString normalizedTitle = MatchingEngine::normalizeTitle(title);
+    m_titles.append(title);
+    m_normalizedTitles.append(normalizedTitle);
+    m_words.append(MatchingEngine::titleWords(title));
+    m_phoneticKeys.append(Transliteration::phoneticKey(normalizedTitle));
+    m_indicTitles.append(Transliteration::hasIndicLetters(normalizedTitle));
+
+    // Files named after their title add nothing
+    QStringList fileNameWords = MatchingEngine::titleWords(fileBaseName);
+    if(fileNameWords == m_words.constLast()) {
+        fileNameWords.clear();
+    }
+    m_fileNameWords.append(fileNameWords);
+
+    m_durations.append(durationSeconds);
+    m_trackNumbers.append(trackNumber);
+    m_discNumbers.append(discNumber);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// What matching needs to know of each local track, derived once when the
+// tracks are loaded rather than on every matching pass. Stored column by
+// column: a scorer walking one feature over all tracks reads one list.
+class TrackFeatures
+{
+public:
+    void reserve(qsizetype size);
+    // title is the tag, or the file name when the tag is empty; numbers and durations are 0 if unknown
+    void append(const QString& title, int durationSeconds, int trackNumber, int discNumber,
+                const QString& fileBaseName);
+
+    [[nodiscard]] qsizetype size() const { return m_titles.size(); }
+    [[nodiscard]] bool isEmpty() const { return m_titles.isEmpty(); }
+
+    [[nodiscard]] const QList<QString>& titles() const { return m_titles; }
+    // MatchingEngine::normalizeTitle of each title
+    [[nodiscard]] const QList<QString>& normalizedTitles() const { return m_normalizedTitles; }
+    // MatchingEngine::titleWords of each title, and of each file name where it has others
+    [[nodiscard]] const QList<QStringList>& words() const { return m_words; }
+    [[nodiscard]] const QList<QStringList>& fileNameWords() const { return m_fileNameWords; }
+    // Transliteration::phoneticKey of each normalized title, and whether it was in an Indic script
+    [[nodiscard]] const QList<QString>& phoneticKeys() const { return m_phoneticKeys; }
+    [[nodiscard]] const QList<bool>& indicTitles() const { return m_indicTitles; }
+    [[nodiscard]] const QList<int>& durations() const { return m_durations; }
+    [[nodiscard]] const QList<int>& trackNumbers() const { return m_trackNumbers; }
+    [[nodiscard]] const QList<int>& discNumbers() const { return m_discNumbers; }
+
+private:
+    QList<QString> m_titles;
+    QList<QString> m_normalizedTitles;
+    QList<QStringList> m_words;
+    QList<QStringList> m_fileNameWords;
+    QList<QString> m_phoneticKeys;
+    QList<bool> m_indicTitles;
+    QList<int> m_durations;
+    QList<int> m_trackNumbers;
+    QList<int> m_discNumbers;
+};
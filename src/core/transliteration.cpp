@@ -0,0 +1,433 @@
+#include "transliteration.h"
+
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+enum class Kind : std::uint8_t
+{
+    None,      // Kept as it is
+    Vowel,     // Independent vowel
+    Consonant, // With an inherent a, unless a vowel sign or virama follows
+    VowelSign, // Takes the place of the inherent a
+    Virama,    // Drops the inherent a
+    Nukta,     // Makes a variant of the consonant before, spelt the same here
+    Modifier,  // Anusvara, visarga and the like, closing a syllable
+    Digit
+};
+
+struct Letter
+{
+    const char* latin;
+    Kind kind;
+};
+
+constexpr char16_t Devanagari = 0x0900;
+constexpr char16_t Tamil = 0x0B80;
+constexpr char16_t Telugu = 0x0C00;
+constexpr char16_t BlockSize = 0x80;
+
+constexpr char16_t ZeroWidthNonJoiner = 0x200C;
+constexpr char16_t ZeroWidthJoiner = 0x200D;
+constexpr char16_t TamilRra = 0x0BB1;
+constexpr char16_t TamilVirama = 0x0BCD;
+
+// By offset into the block, named after the Devanagari letter there
+constexpr Letter Letters[BlockSize] = {
+    {"n", Kind::Modifier},       // 00 sign inverted candrabindu
+    {"n", Kind::Modifier},       // 01 sign candrabindu
+    {"n", Kind::Modifier},       // 02 sign anusvara
+    {"h", Kind::Modifier},       // 03 sign visarga
+    {"a", Kind::Vowel},          // 04 letter short a
+    {"a", Kind::Vowel},          // 05 letter a
+    {"a", Kind::Vowel},          // 06 letter aa
+    {"i", Kind::Vowel},          // 07 letter i
+    {"i", Kind::Vowel},          // 08 letter ii
+    {"u", Kind::Vowel},          // 09 letter u
+    {"u", Kind::Vowel},          // 0A letter uu
+    {"ri", Kind::Vowel},         // 0B letter vocalic r
+    {"li", Kind::Vowel},         // 0C letter vocalic l
+    {"e", Kind::Vowel},          // 0D letter candra e
+    {"e", Kind::Vowel},          // 0E letter short e
+    {"e", Kind::Vowel},          // 0F letter e
+    {"ai", Kind::Vowel},         // 10 letter ai
+    {"o", Kind::Vowel},          // 11 letter candra o
+    {"o", Kind::Vowel},          // 12 letter short o
+    {"o", Kind::Vowel},          // 13 letter o
+    {"au", Kind::Vowel},         // 14 letter au
+    {"k", Kind::Consonant},      // 15 letter ka
+    {"kh", Kind::Consonant},     // 16 letter kha
+    {"g", Kind::Consonant},      // 17 letter ga
+    {"gh", Kind::Consonant},     // 18 letter gha
+    {"n", Kind::Consonant},      // 19 letter nga
+    {"c", Kind::Consonant},      // 1A letter ca
+    {"ch", Kind::Consonant},     // 1B letter cha
+    {"j", Kind::Consonant},      // 1C letter ja
+    {"jh", Kind::Consonant},     // 1D letter jha
+    {"n", Kind::Consonant},      // 1E letter nya
+    {"t", Kind::Consonant},      // 1F letter tta
+    {"th", Kind::Consonant},     // 20 letter ttha
+    {"d", Kind::Consonant},      // 21 letter dda
+    {"dh", Kind::Consonant},     // 22 letter ddha
+    {"n", Kind::Consonant},      // 23 letter nna
+    {"t", Kind::Consonant},      // 24 letter ta
+    {"th", Kind::Consonant},     // 25 letter tha
+    {"d", Kind::Consonant},      // 26 letter da
+    {"dh", Kind::Consonant},     // 27 letter dha
+    {"n", Kind::Consonant},      // 28 letter na
+    {"n", Kind::Consonant},      // 29 letter nnna, Tamil ன
+    {"p", Kind::Consonant},      // 2A letter pa
+    {"ph", Kind::Consonant},     // 2B letter pha
+    {"b", Kind::Consonant},      // 2C letter ba
+    {"bh", Kind::Consonant},     // 2D letter bha
+    {"m", Kind::Consonant},      // 2E letter ma
+    {"y", Kind::Consonant},      // 2F letter ya
+    {"r", Kind::Consonant},      // 30 letter ra
+    {"r", Kind::Consonant},      // 31 letter rra, Tamil ற
+    {"l", Kind::Consonant},      // 32 letter la
+    {"l", Kind::Consonant},      // 33 letter lla, Tamil ள
+    {"zh", Kind::Consonant},     // 34 letter llla, Tamil ழ
+    {"v", Kind::Consonant},      // 35 letter va
+    {"sh", Kind::Consonant},     // 36 letter sha
+    {"sh", Kind::Consonant},     // 37 letter ssa
+    {"s", Kind::Consonant},      // 38 letter sa
+    {"h", Kind::Consonant},      // 39 letter ha
+    {"", Kind::None},            // 3A vowel sign oe
+    {"", Kind::None},            // 3B vowel sign ooe
+    {"", Kind::Nukta},           // 3C sign nukta
+    {"", Kind::None},            // 3D sign avagraha
+    {"a", Kind::VowelSign},      // 3E vowel sign aa
+    {"i", Kind::VowelSign},      // 3F vowel sign i
+    {"i", Kind::VowelSign},      // 40 vowel sign ii
+    {"u", Kind::VowelSign},      // 41 vowel sign u
+    {"u", Kind::VowelSign},      // 42 vowel sign uu
+    {"ri", Kind::VowelSign},     // 43 vowel sign vocalic r
+    {"ri", Kind::VowelSign},     // 44 vowel sign vocalic rr
+    {"e", Kind::VowelSign},      // 45 vowel sign candra e
+    {"e", Kind::VowelSign},      // 46 vowel sign short e
+    {"e", Kind::VowelSign},      // 47 vowel sign e
+    {"ai", Kind::VowelSign},     // 48 vowel sign ai
+    {"o", Kind::VowelSign},      // 49 vowel sign candra o
+    {"o", Kind::VowelSign},      // 4A vowel sign short o
+    {"o", Kind::VowelSign},      // 4B vowel sign o
+    {"au", Kind::VowelSign},     // 4C vowel sign au
+    {"", Kind::Virama},          // 4D sign virama
+    {"", Kind::None},            // 4E vowel sign prishthamatra e
+    {"", Kind::None},            // 4F vowel sign aw
+    {"om", Kind::Vowel},         // 50 om
+    {"", Kind::None},            // 51 stress sign udatta
+    {"", Kind::None},            // 52 stress sign anudatta
+    {"", Kind::None},            // 53 grave accent
+    {"", Kind::None},            // 54 acute accent
+    {"", Kind::None},            // 55 vowel sign candra long e
+    {"", Kind::None},            // 56 vowel sign ue
+    {"", Kind::None},            // 57 vowel sign uue
+    {"k", Kind::Consonant},      // 58 letter qa
+    {"kh", Kind::Consonant},     // 59 letter khha
+    {"g", Kind::Consonant},      // 5A letter ghha
+    {"z", Kind::Consonant},      // 5B letter za
+    {"r", Kind::Consonant},      // 5C letter dddha
+    {"rh", Kind::Consonant},     // 5D letter rha
+    {"f", Kind::Consonant},      // 5E letter fa
+    {"y", Kind::Consonant},      // 5F letter yya
+    {"ri", Kind::Vowel},         // 60 letter vocalic rr
+    {"li", Kind::Vowel},         // 61 letter vocalic ll
+    {"li", Kind::VowelSign},     // 62 vowel sign vocalic l
+    {"li", Kind::VowelSign},     // 63 vowel sign vocalic ll
+    {"", Kind::None},            // 64 danda
+    {"", Kind::None},            // 65 double danda
+    {"0", Kind::Digit},          // 66 digit zero
+    {"1", Kind::Digit},          // 67 digit one
+    {"2", Kind::Digit},          // 68 digit two
+    {"3", Kind::Digit},          // 69 digit three
+    {"4", Kind::Digit},          // 6A digit four
+    {"5", Kind::Digit},          // 6B digit five
+    {"6", Kind::Digit},          // 6C digit six
+    {"7", Kind::Digit},          // 6D digit seven
+    {"8", Kind::Digit},          // 6E digit eight
+    {"9", Kind::Digit},          // 6F digit nine
+    {"", Kind::None},            // 70 abbreviation sign
+    {"", Kind::None},            // 71 sign high spacing dot
+    {"", Kind::None},            // 72 letter candra a
+    {"", Kind::None},            // 73 letter oe
+    {"", Kind::None},            // 74 letter ooe
+    {"", Kind::None},            // 75 letter aw
+    {"", Kind::None},            // 76 letter ue
+    {"", Kind::None},            // 77 letter uue
+    {"", Kind::None},            // 78 letter marwari dda
+    {"", Kind::None},            // 79 letter zha
+    {"", Kind::None},            // 7A letter heavy ya
+    {"", Kind::None},            // 7B letter gga
+    {"", Kind::None},            // 7C letter jja
+    {"", Kind::None},            // 7D letter glottal stop
+    {"", Kind::None},            // 7E letter ddda
+    {"", Kind::None},            // 7F letter bba
+};
+
+struct Exception
+{
+    char16_t unit;
+    Letter letter;
+};
+
+// Telugu letters unlike the Devanagari one at their offset, sorted
+constexpr Exception Exceptions[] = {
+    {0x0C04, {"n", Kind::Modifier}},  // Combining anusvara above
+    {0x0C58, {"c", Kind::Consonant}}, // tsa
+    {0x0C59, {"j", Kind::Consonant}}, // dza
+    {0x0C5A, {"r", Kind::Consonant}}, // rrra
+    {0x0C5D, {"n", Kind::Modifier}},  // nakaara pollu, a vowelless n
+};
+
+struct TwoPartSign
+{
+    char16_t first;
+    char16_t second;
+    const char* latin;
+};
+
+// Vowel signs as they are written when decomposed, ொ as ெ and ா
+constexpr TwoPartSign TwoPartSigns[] = {
+    {0x0BC6, 0x0BBE, "o"},
+    {0x0BC6, 0x0BD7, "au"},
+    {0x0BC7, 0x0BBE, "o"},
+    {0x0C46, 0x0C55, "e"},
+    {0x0C46, 0x0C56, "ai"},
+};
+
+// Key letters for a to z: voiced and voiceless, c, j and s, v and w alike
+constexpr char Folded[] = "apctepkhicklmnopkrctuvvkyc";
+// Letters an h after only aspirates, or makes another letter of the same key
+constexpr char Aspirated[] = "bcdgjkpstz";
+
+enum class SoundType : std::uint8_t
+{
+    Consonant, // Modifiers included
+    Vowel,
+    Inherent, // The a a consonant carries by itself
+    Silent    // An inherent a left unspoken
+};
+
+struct Sound
+{
+    const char* latin;
+    SoundType type;
+};
+
+using Word = QVarLengthArray<Sound, 32>;
+
+const Letter* findLetter(char16_t unit)
+{
+    const bool indic = (unit >= Devanagari && unit < Devanagari + BlockSize)
+                    || (unit >= Tamil && unit < Tamil + BlockSize) || (unit >= Telugu && unit < Telugu + BlockSize);
+    if(!indic) {
+        return nullptr;
+    }
+
+    const auto* exception = std::lower_bound(std::cbegin(Exceptions), std::cend(Exceptions), unit,
+                                             [](const Exception& e, char16_t u) { return e.unit < u; });
+    if(exception != std::cend(Exceptions) && exception->unit == unit) {
+        return &exception->letter;
+    }
+    return &Letters[unit % BlockSize];
+}
+
+const char* twoPartSign(char16_t first, char16_t second)
+{
+    for(const auto& sign : TwoPartSigns) {
+        if(sign.first == first && sign.second == second) {
+            return sign.latin;
+        }
+    }
+    return nullptr;
+}
+
+bool isVowel(const Word& word, qsizetype i)
+{
+    return i >= 0 && i < word.size() && (word[i].type == SoundType::Vowel || word[i].type == SoundType::Inherent);
+}
+
+bool isConsonant(const Word& word, qsizetype i)
+{
+    return i >= 0 && i < word.size() && word[i].type == SoundType::Consonant;
+}
+
+// Hindi leaves the inherent a unspoken at the end of a word, and where it
+// sits between single consonants with vowels beyond them (VC_CV): दिलबर is
+// dilbar, not dilabara. Right to left, so that a dropped vowel keeps the
+// one before it from being dropped too, as in कमल, kamal.
+void dropSilentVowels(Word& word)
+{
+    const auto vowels = std::count_if(word.cbegin(), word.cend(), [](const Sound& sound) {
+        return sound.type == SoundType::Vowel || sound.type == SoundType::Inherent;
+    });
+    if(vowels < 2) {
+        return;
+    }
+
+    if(word.back().type == SoundType::Inherent) {
+        word.back().type = SoundType::Silent;
+    }
+    for(qsizetype i = word.size() - 2; i > 1; --i) {
+        if(word[i].type == SoundType::Inherent && isConsonant(word, i - 1) && isVowel(word, i - 2)
+           && isConsonant(word, i + 1) && isVowel(word, i + 2)) {
+            word[i].type = SoundType::Silent;
+        }
+    }
+}
+} // namespace
+
+namespace Transliteration {
+bool hasIndicLetters(QStringView text)
+{
+    return std::any_of(text.cbegin(), text.cend(), [](QChar c) {
+        const Letter* letter = findLetter(c.unicode());
+        return letter && (letter->kind == Kind::Vowel || letter->kind == Kind::Consonant);
+    });
+}
+
+QString romanize(QStringView text)
+{
+    QString romanized;
+    romanized.reserve(text.size() * 2);
+
+    Word word;
+    bool devanagari{false};
+    const auto endWord = [&]() {
+        if(devanagari) {
+            dropSilentVowels(word);
+        }
+        for(const Sound& sound : word) {
+            if(sound.type != SoundType::Silent) {
+                romanized += QLatin1String(sound.latin);
+            }
+        }
+        word.clear();
+    };
+
+    for(qsizetype i = 0; i < text.size(); ++i) {
+        const char16_t unit = text[i].unicode();
+        if(unit == ZeroWidthNonJoiner || unit == ZeroWidthJoiner) {
+            // They only choose how letters are drawn
+            continue;
+        }
+
+        const char* joined = i > 0 ? twoPartSign(text[i - 1].unicode(), unit) : nullptr;
+        if(joined && !word.isEmpty() && word.back().type == SoundType::Vowel) {
+            word.back().latin = joined;
+            continue;
+        }
+
+        const Letter* letter = findLetter(unit);
+        if(!letter || letter->kind == Kind::None) {
+            endWord();
+            romanized += text[i];
+            continue;
+        }
+
+        const bool inDevanagari = unit < Tamil;
+        if(inDevanagari != devanagari) {
+            endWord();
+            devanagari = inDevanagari;
+        }
+
+        const bool inherent = !word.isEmpty() && word.back().type == SoundType::Inherent;
+        switch(letter->kind) {
+            case Kind::Vowel:
+                word.append({letter->latin, SoundType::Vowel});
+                break;
+            case Kind::Consonant:
+                if(unit == TamilRra && i >= 2 && text[i - 1].unicode() == TamilVirama
+                   && text[i - 2].unicode() == TamilRra) {
+                    // ற்ற is spoken, and romanized, as tr
+                    word.back().latin = "t";
+                }
+                word.append({letter->latin, SoundType::Consonant});
+                word.append({"a", SoundType::Inherent});
+                break;
+            case Kind::VowelSign:
+                if(inherent) {
+                    word.removeLast();
+                }
+                word.append({letter->latin, SoundType::Vowel});
+                break;
+            case Kind::Virama:
+                if(inherent) {
+                    word.removeLast();
+                }
+                break;
+            case Kind::Modifier:
+                word.append({letter->latin, SoundType::Consonant});
+                break;
+            case Kind::Digit:
+                endWord();
+                romanized += QLatin1String(letter->latin);
+                break;
+            case Kind::Nukta:
+            case Kind::None:
+                break;
+        }
+    }
+    endWord();
+
+    return romanized;
+}
+
+QString phoneticKey(QStringView text)
+{
+    const QString romanized = romanize(text);
+
+    QString key;
+    key.reserve(romanized.size());
+    const auto append = [&key](QChar c) {
+        if(key.isEmpty() || key.back() != c) {
+            key += c;
+        }
+    };
+
+    // Last Latin letter of the current word, as written
+    char previous{0};
+    for(QChar c : romanized) {
+        if(c.isMark()) {
+            continue;
+        }
+        if(c.unicode() >= 0x80 && c.decompositionTag() == QChar::Canonical) {
+            // á, ñ, ṭ ... as their base letter
+            const QChar base = c.decomposition().at(0);
+            if(base.unicode() < 0x80) {
+                c = base;
+            }
+        }
+
+        const char16_t unit = c.toLower().unicode();
+        if(unit < u'a' || unit > u'z') {
+            if(c.isLetterOrNumber()) {
+                append(c.toCaseFolded());
+            }
+            previous = 0;
+            continue;
+        }
+
+        const auto letter = static_cast<char>(unit);
+        if(letter == 'h' && previous != 0 && std::strchr(Aspirated, previous)) {
+            // Tamil's ழ is romanized as zh about as often as l
+            if(previous == 'z') {
+                key.back() = QLatin1Char('l');
+            }
+            continue;
+        }
+        if((letter == 'e' || letter == 'o') && previous == letter) {
+            key.back() = QLatin1Char(letter == 'e' ? 'i' : 'u');
+            previous = 0;
+            continue;
+        }
+        append(QLatin1Char(Folded[letter - 'a']));
+        previous = letter;
+    }
+
+    return key;
+}
+} // namespace Transliteration
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QString>
+#include <QStringView>
+
+// Latin spellings of titles in Devanagari, Tamil and Telugu script, so that
+// "ரஞ்சிதமே" can be told to be the "Ranjithame" a romanized tracklist gives.
+// The letters are looked up in a table laid out like ICU's InterIndic one:
+// the Unicode blocks of these scripts place letters that sound alike at the
+// same offset, so one table serves all three.
+namespace Transliteration {
+// Whether text has letters of any of these scripts
+bool hasIndicLetters(QStringView text);
+
+// text with the letters of these scripts spelt in lowercase Latin letters,
+// without diacritics or vowel length, which romanized titles rarely mark.
+// Words in Devanagari drop the inherent vowels Hindi leaves unspoken.
+// Everything else is kept as it is.
+QString romanize(QStringView text);
+
+// What spellings of the same sounds have in common: text romanized, then
+// without diacritics, word breaks and doubled letters, aspiration and voicing
+// folded (th as t, d as t, j and s as c ...) and "ee", "oo" read as i, u.
+// Meant for titles already through MatchingEngine::normalizeTitle.
+QString phoneticKey(QStringView text);
+} // namespace Transliteration
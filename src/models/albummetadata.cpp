@@ -1,5 +1,12 @@
 #include "albummetadata.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <optional>
+#include <utility>
+
 // Static registration of metatypes
 static const bool registered = []() {
     qRegisterMetaType<Tagger::TrackMetadata>("Tagger::TrackMetadata");
@@ -8,3 +15,212 @@ static const bool registered = []() {
     qRegisterMetaType<Tagger::FetchStatus>("Tagger::FetchStatus");
     return true;
 }();
+
+namespace {
+constexpr int DurationToleranceSeconds = 3;
+
+// Number of local durations that can be paired with a distinct candidate
+// duration within the tolerance. Greedy pairing of both sorted lists is
+// optimal for a fixed tolerance.
+int matchingDurations(QList<int> local, QList<int> candidate)
+{
+    std::sort(local.begin(), local.end());
+    std::sort(candidate.begin(), candidate.end());
+
+    int matched{0};
+    qsizetype i{0};
+    qsizetype j{0};
+    while(i < local.size() && j < candidate.size()) {
+        if(std::abs(local[i] - candidate[j]) <= DurationToleranceSeconds) {
+            ++matched;
+            ++i;
+            ++j;
+        }
+        else if(local[i] < candidate[j]) {
+            ++i;
+        }
+        else {
+            ++j;
+        }
+    }
+    return matched;
+}
+
+// Tracks per disc of a candidate: as listed, or counted from its tracks
+QList<int> discLayout(const Tagger::TrackListCandidate& candidate)
+{
+    if(!candidate.discTrackCounts.isEmpty() || candidate.tracks.isEmpty()) {
+        return candidate.discTrackCounts;
+    }
+
+    QList<int> layout;
+    for(const auto& track : candidate.tracks) {
+        const int disc = std::max(track.discNumber, 1);
+        if(layout.size() < disc) {
+            layout.resize(disc);
+        }
+        ++layout[disc - 1];
+    }
+    return layout;
+}
+
+// Share of discs holding the same number of tracks on both sides
+double layoutScore(const QList<int>& local, const QList<int>& candidate)
+{
+    const qsizetype discs = std::max(local.size(), candidate.size());
+    int matched{0};
+    for(qsizetype i = 0; i < std::min(local.size(), candidate.size()); ++i) {
+        if(local[i] == candidate[i]) {
+            ++matched;
+        }
+    }
+    return static_cast<double>(matched) / static_cast<double>(discs);
+}
+
+double candidateScore(const Tagger::TrackListCandidate& candidate, const QList<int>& localDurations,
+                      const QList<int>& localDiscTrackCounts)
+{
+    const QList<int> layout = discLayout(candidate);
+    // Tracks that have not been fetched yet still count if their number is known
+    const bool fetched = !candidate.tracks.isEmpty();
+    const auto localCount = static_cast<double>(localDurations.size());
+    const auto candidateCount = static_cast<double>(
+        fetched ? candidate.tracks.size() : std::accumulate(layout.cbegin(), layout.cend(), qsizetype{0}));
+    const double larger = std::max({localCount, candidateCount, 1.0});
+
+    const double countScore = 1.0 - std::abs(localCount - candidateCount) / larger;
+
+    QList<int> local;
+    for(const int duration : localDurations) {
+        if(duration > 0) {
+            local.append(duration);
+        }
+    }
+    QList<int> durations;
+    for(const auto& track : candidate.tracks) {
+        if(track.durationSeconds > 0) {
+            durations.append(track.durationSeconds);
+        }
+    }
+
+    // Whichever of durations and disc layout are known on both sides add to the track count
+    std::optional<double> durationScore;
+    if(!local.isEmpty() && !durations.isEmpty()) {
+        // Durations tell versions with the same number of songs apart
+        durationScore = matchingDurations(local, durations) / larger;
+    }
+    else if(!local.isEmpty() && !fetched && candidateCount > 0) {
+        // The best its durations could do
+        durationScore = std::min(static_cast<double>(local.size()), candidateCount) / larger;
+    }
+    std::optional<double> discScore;
+    if(!localDiscTrackCounts.isEmpty() && !layout.isEmpty()) {
+        discScore = layoutScore(localDiscTrackCounts, layout);
+    }
+
+    if(durationScore && discScore) {
+        return 0.3 * countScore + 0.2 * *discScore + 0.5 * *durationScore;
+    }
+    if(durationScore) {
+        return 0.4 * countScore + 0.6 * *durationScore;
+    }
+    if(discScore) {
+        return 0.6 * countScore + 0.4 * *discScore;
+    }
+    return countScore;
+}
+
+// Share of words found in both titles
+double titleScore(const QSet<QString>& query, const QString& title)
+{
+    if(query.isEmpty()) {
+        return 0.5;
+    }
+    const QSet<QString> words = Tagger::titleWords(title);
+    const auto shared = static_cast<double>(QSet<QString>(words).intersect(query).size());
+    return shared / static_cast<double>(words.size() + query.size() - shared);
+}
+
+double trackCountScore(int count, int localCount)
+{
+    if(count <= 0 || localCount <= 0) {
+        return 0.5;
+    }
+    return static_cast<double>(std::min(count, localCount)) / std::max(count, localCount);
+}
+} // namespace
+
+namespace Tagger {
+int bestTrackListCandidate(const AlbumMetadata& album, const QList<int>& localDurations,
+                           const QList<int>& localDiscTrackCounts)
+{
+    int best{-1};
+    double bestScore{-1.0};
+
+    for(int i = 0; i < album.candidates.size(); ++i) {
+        const double score = candidateScore(album.candidates[i], localDurations, localDiscTrackCounts);
+        // Ties keep the earlier tracklist, which is usually the original release, unless only
+        // the later one has its tracks: fetching the earlier one could not do better
+        const bool tracksKnown = best >= 0 && album.candidates[best].tracks.isEmpty()
+                              && !album.candidates[i].tracks.isEmpty();
+        if(score > bestScore || (score == bestScore && tracksKnown)) {
+            best = i;
+            bestScore = score;
+        }
+    }
+
+    return best;
+}
+
+QSet<QString> titleWords(const QString& title)
+{
+    QSet<QString> words;
+    QString word;
+    for(const QChar c : title) {
+        if(c.isLetterOrNumber()) {
+            word += c.toLower();
+        }
+        else if(!word.isEmpty()) {
+            words.insert(std::exchange(word, {}));
+        }
+    }
+    if(!word.isEmpty()) {
+        words.insert(word);
+    }
+    return words;
+}
+
+QList<qsizetype> rankSearchResults(const QList<AlbumMetadata>& results, const QList<int>& trackCounts,
+                                   const QString& album, int localTrackCount)
+{
+    const QSet<QString> query = titleWords(album);
+
+    QList<double> scores;
+    QList<qsizetype> order;
+    for(qsizetype i = 0; i < results.size(); ++i) {
+        const int count = trackCounts.value(i);
+        scores.append(0.5 * titleScore(query, results[i].album) + 0.5 * trackCountScore(count, localTrackCount));
+        order.append(i);
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&scores](qsizetype a, qsizetype b) { return scores[a] > scores[b]; });
+    return order;
+}
+
+void useTrackListCandidate(AlbumMetadata& album, int index)
+{
+    if(index < 0 || index >= album.candidates.size()) {
+        return;
+    }
+
+    album.tracks = album.candidates[index].tracks;
+
+    // Use music director if available
+    for(const auto& track : album.tracks) {
+        if(!track.musicDirector.isEmpty()) {
+            album.musicDirector = track.musicDirector;
+            break;
+        }
+    }
+}
+} // namespace Tagger
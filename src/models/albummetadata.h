@@ -2,5 +2,35 @@
 
 #include <tagger/tagger_common.h>
 
+#include <QSet>
+
 // Re-export from common header for convenience
 // The actual structs are defined in tagger_common.h
+
+namespace Tagger {
+
+// Returns the index of the candidate tracklist that best fits the local
+// tracks, judged by track count, durations (in seconds, 0 if unknown) and,
+// when the files have disc numbers, tracks per disc.
+// A candidate whose tracks are not known yet is judged as if all of its
+// durations fit, so it only comes out best if fetching its tracks could
+// change the outcome.
+// Returns -1 if the album has no candidates.
+int bestTrackListCandidate(const AlbumMetadata& album, const QList<int>& localDurations,
+                           const QList<int>& localDiscTrackCounts = {});
+
+// Lowercased words of a title, ignoring punctuation
+QSet<QString> titleWords(const QString& title);
+
+// Orders search results by how likely each is the album the local tracks
+// belong to: how many title words they share with the album searched for,
+// and how close their track count (0 if unknown) is to the number of local
+// tracks. Unknown counts and an empty query score neither up nor down;
+// equal scores keep the server's order. Returns indices into results.
+QList<qsizetype> rankSearchResults(const QList<AlbumMetadata>& results, const QList<int>& trackCounts,
+                                   const QString& album, int localTrackCount);
+
+// Makes the candidate at index the album's active tracklist
+void useTrackListCandidate(AlbumMetadata& album, int index);
+
+} // namespace Tagger
@@ -78,6 +78,11 @@ void TaggerSettingsPageWidget::apply()
     m_settings->set<TaggerSettings::DefaultSource>(m_sourceCombo->currentData().toInt());
     m_settings->set<TaggerSettings::ConfidenceThreshold>(m_confidenceSpin->value());
     m_settings->set<TaggerSettings::DurationTolerance>(m_durationSpin->value());
+
+    if(m_manager) {
+        m_manager->setConfidenceThreshold(m_confidenceSpin->value() / 100.0);
+        m_manager->setDurationTolerance(m_durationSpin->value());
+    }
 }
 
 void TaggerSettingsPageWidget::reset()
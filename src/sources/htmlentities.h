@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QByteArrayView>
+
+// The HTML5 named character references (&amp;, &ndash;, &nGt; ...)
+namespace HtmlEntities {
+// Returns the UTF-8 replacement for a reference name given without the
+// leading '&' and with its ';', e.g. "ndash;". Empty if unknown.
+QByteArrayView lookup(QByteArrayView name);
+
+// Matches the legacy references that are also recognised without ';'
+// (e.g. "&amp" or "&eacute") at the start of text, which follows the '&'.
+// Returns the length of the longest match and sets utf8, or returns 0.
+qsizetype matchLegacy(QByteArrayView text, QByteArrayView& utf8);
+} // namespace HtmlEntities
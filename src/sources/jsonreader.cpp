@@ -0,0 +1,363 @@
+#include "jsonreader.h"
+
+#include <cmath>
+#include <limits>
+
+namespace {
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Consumes a run of digits and returns how many there were
+qsizetype skipDigits(QByteArrayView json, qsizetype& pos)
+{
+    const qsizetype start = pos;
+    while(pos < json.size() && isDigit(json[pos])) {
+        ++pos;
+    }
+    return pos - start;
+}
+} // namespace
+
+JsonReader::JsonReader(QByteArrayView json)
+    : m_json(json)
+{
+}
+
+JsonReader::TokenType JsonReader::next()
+{
+    if(m_type == TokenType::Error) {
+        return m_type;
+    }
+
+    skipWhitespace();
+    const bool atEnd = m_pos >= m_json.size();
+
+    switch(m_expect) {
+        case Expect::Done:
+            if(!atEnd) {
+                return fail(QStringLiteral("Unexpected data after the document"));
+            }
+            m_raw = {};
+            return m_type = TokenType::End;
+        case Expect::Value:
+            return readValue();
+        case Expect::ValueOrEnd:
+            if(!atEnd && m_json[m_pos] == ']') {
+                ++m_pos;
+                return close(']');
+            }
+            return readValue();
+        case Expect::KeyOrEnd:
+            if(!atEnd && m_json[m_pos] == '}') {
+                ++m_pos;
+                return close('}');
+            }
+            [[fallthrough]];
+        case Expect::Key:
+            if(atEnd || m_json[m_pos] != '"') {
+                return fail(QStringLiteral("Expected an object key"));
+            }
+            if(readString(TokenType::Key) == TokenType::Error) {
+                return m_type;
+            }
+            skipWhitespace();
+            if(m_pos >= m_json.size() || m_json[m_pos] != ':') {
+                return fail(QStringLiteral("Expected ':' after an object key"));
+            }
+            ++m_pos;
+            m_expect = Expect::Value;
+            return m_type;
+        case Expect::CommaOrEnd: {
+            if(atEnd) {
+                return fail(QStringLiteral("Unterminated object or array"));
+            }
+            const char c = m_json[m_pos++];
+            if(c == ',') {
+                m_expect = m_stack.back() == '{' ? Expect::Key : Expect::Value;
+                return next();
+            }
+            if(c == '}' || c == ']') {
+                return close(c);
+            }
+            return fail(QStringLiteral("Expected ',' or a closing bracket"));
+        }
+    }
+
+    return fail(QStringLiteral("Invalid reader state"));
+}
+
+void JsonReader::skip()
+{
+    if(m_type != TokenType::BeginObject && m_type != TokenType::BeginArray) {
+        return;
+    }
+
+    // Only brackets outside strings count; nothing in between is looked at
+    qsizetype depth{1};
+    while(m_pos < m_json.size()) {
+        const char c = m_json[m_pos++];
+        if(c == '"') {
+            while(m_pos < m_json.size() && m_json[m_pos] != '"') {
+                m_pos += m_json[m_pos] == '\\' ? 2 : 1;
+            }
+            if(m_pos >= m_json.size()) {
+                break;
+            }
+            ++m_pos;
+        }
+        else if(c == '{' || c == '[') {
+            ++depth;
+        }
+        else if((c == '}' || c == ']') && --depth == 0) {
+            close(c);
+            return;
+        }
+    }
+
+    fail(QStringLiteral("Unterminated object or array"));
+}
+
+QString JsonReader::string() const
+{
+    if(m_type != TokenType::Key && m_type != TokenType::String) {
+        return {};
+    }
+    return m_escaped ? unescape(m_raw) : QString::fromUtf8(m_raw);
+}
+
+double JsonReader::toDouble() const
+{
+    return m_type == TokenType::Number ? m_raw.toDouble() : 0.0;
+}
+
+int JsonReader::toInt() const
+{
+    if(m_type != TokenType::Number) {
+        return 0;
+    }
+
+    bool ok{false};
+    const int value = m_raw.toInt(&ok);
+    if(ok) {
+        return value;
+    }
+
+    // "3.0" or "1e3" still count when they are whole numbers in range
+    const double number = m_raw.toDouble();
+    if(std::trunc(number) == number && number >= std::numeric_limits<int>::min()
+       && number <= std::numeric_limits<int>::max()) {
+        return static_cast<int>(number);
+    }
+    return 0;
+}
+
+QString JsonReader::unescape(QByteArrayView raw)
+{
+    QString text;
+    text.reserve(raw.size());
+
+    qsizetype runStart{0};
+    for(qsizetype i = 0; i < raw.size(); ++i) {
+        if(raw[i] != '\\' || i + 1 >= raw.size()) {
+            continue;
+        }
+
+        text += QString::fromUtf8(raw.sliced(runStart, i - runStart));
+        const char escape = raw[++i];
+        switch(escape) {
+            case 'b':
+                text += QLatin1Char('\b');
+                break;
+            case 'f':
+                text += QLatin1Char('\f');
+                break;
+            case 'n':
+                text += QLatin1Char('\n');
+                break;
+            case 'r':
+                text += QLatin1Char('\r');
+                break;
+            case 't':
+                text += QLatin1Char('\t');
+                break;
+            case 'u':
+                // Surrogate pairs come as two escapes and end up as the two UTF-16 halves they are
+                if(i + 4 < raw.size()) {
+                    text += QChar(raw.sliced(i + 1, 4).toUShort(nullptr, 16));
+                    i += 4;
+                }
+                break;
+            default:
+                text += QLatin1Char(escape);
+                break;
+        }
+        runStart = i + 1;
+    }
+
+    text += QString::fromUtf8(raw.sliced(runStart));
+    return text;
+}
+
+JsonReader::TokenType JsonReader::readValue()
+{
+    if(m_pos >= m_json.size()) {
+        return fail(QStringLiteral("Unexpected end of input"));
+    }
+
+    switch(m_json[m_pos]) {
+        case '{':
+            ++m_pos;
+            m_stack.append('{');
+            m_expect = Expect::KeyOrEnd;
+            m_raw = {};
+            return m_type = TokenType::BeginObject;
+        case '[':
+            ++m_pos;
+            m_stack.append('[');
+            m_expect = Expect::ValueOrEnd;
+            m_raw = {};
+            return m_type = TokenType::BeginArray;
+        case '"':
+            if(readString(TokenType::String) != TokenType::Error) {
+                m_expect = afterValue();
+            }
+            return m_type;
+        case 't':
+            return readLiteral("true", TokenType::Bool);
+        case 'f':
+            return readLiteral("false", TokenType::Bool);
+        case 'n':
+            return readLiteral("null", TokenType::Null);
+        default:
+            return readNumber();
+    }
+}
+
+JsonReader::TokenType JsonReader::readString(TokenType type)
+{
+    const qsizetype start = ++m_pos;
+    m_escaped = false;
+
+    while(m_pos < m_json.size()) {
+        const char c = m_json[m_pos];
+        if(c == '"') {
+            m_raw = m_json.sliced(start, m_pos - start);
+            ++m_pos;
+            return m_type = type;
+        }
+        if(static_cast<unsigned char>(c) < 0x20) {
+            return fail(QStringLiteral("Control character in a string"));
+        }
+        if(c == '\\') {
+            m_escaped = true;
+            if(m_pos + 1 >= m_json.size()) {
+                break;
+            }
+            const char escape = m_json[m_pos + 1];
+            if(escape == 'u') {
+                bool isHex{false};
+                if(m_pos + 6 > m_json.size()) {
+                    break;
+                }
+                m_json.sliced(m_pos + 2, 4).toUShort(&isHex, 16);
+                if(!isHex) {
+                    return fail(QStringLiteral("Invalid \\u escape"));
+                }
+                m_pos += 6;
+                continue;
+            }
+            if(!QByteArrayView("\"\\/bfnrt").contains(escape)) {
+                return fail(QStringLiteral("Invalid escape sequence"));
+            }
+            m_pos += 2;
+            continue;
+        }
+        ++m_pos;
+    }
+
+    return fail(QStringLiteral("Unterminated string"));
+}
+
+JsonReader::TokenType JsonReader::readNumber()
+{
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    const qsizetype start = m_pos;
+    if(m_json[m_pos] == '-') {
+        ++m_pos;
+    }
+    if(m_pos < m_json.size() && m_json[m_pos] == '0') {
+        ++m_pos;
+    }
+    else if(skipDigits(m_json, m_pos) == 0) {
+        return fail(QStringLiteral("Unexpected character"));
+    }
+    if(m_pos < m_json.size() && m_json[m_pos] == '.') {
+        ++m_pos;
+        if(skipDigits(m_json, m_pos) == 0) {
+            return fail(QStringLiteral("Invalid number"));
+        }
+    }
+    if(m_pos < m_json.size() && (m_json[m_pos] == 'e' || m_json[m_pos] == 'E')) {
+        ++m_pos;
+        if(m_pos < m_json.size() && (m_json[m_pos] == '+' || m_json[m_pos] == '-')) {
+            ++m_pos;
+        }
+        if(skipDigits(m_json, m_pos) == 0) {
+            return fail(QStringLiteral("Invalid number"));
+        }
+    }
+
+    m_raw = m_json.sliced(start, m_pos - start);
+    m_expect = afterValue();
+    return m_type = TokenType::Number;
+}
+
+JsonReader::TokenType JsonReader::readLiteral(QByteArrayView literal, TokenType type)
+{
+    if(!m_json.sliced(m_pos).startsWith(literal)) {
+        return fail(QStringLiteral("Unexpected character"));
+    }
+
+    m_raw = m_json.sliced(m_pos, literal.size());
+    m_pos += literal.size();
+    m_expect = afterValue();
+    return m_type = type;
+}
+
+JsonReader::TokenType JsonReader::close(char bracket)
+{
+    const char open = bracket == '}' ? '{' : '[';
+    if(m_stack.isEmpty() || m_stack.back() != open) {
+        return fail(QStringLiteral("Mismatched closing bracket"));
+    }
+
+    m_stack.removeLast();
+    m_raw = {};
+    m_expect = afterValue();
+    return m_type = bracket == '}' ? TokenType::EndObject : TokenType::EndArray;
+}
+
+JsonReader::TokenType JsonReader::fail(const QString& message)
+{
+    m_error = QStringLiteral("%1 at offset %2").arg(message).arg(m_pos);
+    m_raw = {};
+    return m_type = TokenType::Error;
+}
+
+void JsonReader::skipWhitespace()
+{
+    while(m_pos < m_json.size()) {
+        const char c = m_json[m_pos];
+        if(c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+            break;
+        }
+        ++m_pos;
+    }
+}
+
+JsonReader::Expect JsonReader::afterValue() const
+{
+    return m_stack.isEmpty() ? Expect::Done : Expect::CommaOrEnd;
+}
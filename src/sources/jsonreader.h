@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QByteArrayView>
+#include <QString>
+#include <QVarLengthArray>
+
+// Forward-only pull reader over raw UTF-8 JSON.
+// Walks the buffer exactly once and hands out one token at a time as a
+// view into the input; nothing is copied or transcoded until string() or
+// a number accessor is called on the token that is wanted. skip() passes
+// over a whole object or array by scanning for its closing bracket, so
+// subtrees nobody asked for are never built.
+//
+// Structure is validated as it is read (commas, colons, nesting, literals
+// and string escapes); skipped subtrees are only checked for balanced
+// brackets and terminated strings.
+class JsonReader
+{
+public:
+    enum class TokenType
+    {
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        Key,
+        String,
+        Number,
+        Bool,
+        Null,
+        End,  // The document is complete
+        Error // Malformed input; see errorString()
+    };
+
+    explicit JsonReader(QByteArrayView json);
+
+    TokenType next();
+    [[nodiscard]] TokenType type() const { return m_type; }
+
+    // Skips the rest of the value whose first token was just read: a whole
+    // object or array after BeginObject or BeginArray, nothing otherwise
+    void skip();
+
+    // Raw text of the current token: a key or string between its quotes, still escaped, or a number
+    [[nodiscard]] QByteArrayView raw() const { return m_raw; }
+    // Key and String tokens with escapes resolved
+    [[nodiscard]] QString string() const;
+    // Number tokens; 0 for anything else, like QJsonValue
+    [[nodiscard]] double toDouble() const;
+    [[nodiscard]] int toInt() const;
+    [[nodiscard]] bool toBool() const { return m_type == TokenType::Bool && m_raw == "true"; }
+
+    [[nodiscard]] bool hasError() const { return m_type == TokenType::Error; }
+    [[nodiscard]] QString errorString() const { return m_error; }
+    [[nodiscard]] qsizetype position() const { return m_pos; }
+
+    // Unescapes the inside of a JSON string
+    static QString unescape(QByteArrayView raw);
+
+private:
+    enum class Expect
+    {
+        Value,
+        KeyOrEnd,   // After {
+        Key,        // After a comma in an object
+        ValueOrEnd, // After [
+        CommaOrEnd, // After a value inside a container
+        Done        // After the root value
+    };
+
+    TokenType readValue();
+    TokenType readString(TokenType type);
+    TokenType readNumber();
+    TokenType readLiteral(QByteArrayView literal, TokenType type);
+    TokenType close(char bracket);
+    TokenType fail(const QString& message);
+    void skipWhitespace();
+    // Where to go once a value inside the current container is complete
+    [[nodiscard]] Expect afterValue() const;
+
+    QByteArrayView m_json;
+    qsizetype m_pos{0};
+    QVarLengthArray<char, 32> m_stack; // Open brackets, '{' or '['
+    Expect m_expect{Expect::Value};
+    TokenType m_type{TokenType::End};
+    QByteArrayView m_raw;
+    bool m_escaped{false}; // The current string contains backslashes
+    QString m_error;
+};
@@ -1,7 +1,27 @@
 #include "metadatasource.h"
+#include "core/metadatacache.h"
+
+#include <QThreadPool>
 
 MetadataSource::MetadataSource(HttpClient* client, QObject* parent)
     : QObject(parent)
     , m_httpClient(client)
 {
 }
+
+QThreadPool* MetadataSource::parserPool()
+{
+    // Shared by all sources; kept small so parsing never competes with playback
+    static QThreadPool* pool = []() {
+        static QThreadPool threadPool;
+        threadPool.setMaxThreadCount(2);
+        return &threadPool;
+    }();
+    return pool;
+}
+
+MetadataCache* MetadataSource::metadataCache()
+{
+    static MetadataCache cache(MetadataCache::defaultDirectory());
+    return &cache;
+}
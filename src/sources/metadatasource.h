@@ -2,8 +2,13 @@
 
 #include <tagger/tagger_common.h>
 #include <QObject>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <type_traits>
 
 class HttpClient;
+class MetadataCache;
+class QThreadPool;
 
 class MetadataSource : public QObject
 {
@@ -25,6 +30,13 @@ public:
 
     [[nodiscard]] virtual bool isValidUrl(const QString& url) const { Q_UNUSED(url); return false; }
 
+    // Number of tracks being tagged, for sources that guess ahead which result will be wanted
+    void setLocalTrackCount(int count) { m_localTrackCount = count; }
+    [[nodiscard]] int localTrackCount() const { return m_localTrackCount; }
+
+    // Parsed albums from earlier fetches, shared by all sources
+    static MetadataCache* metadataCache();
+
 signals:
     void fetchStarted();
     void fetchProgress(int percent);
@@ -33,5 +45,30 @@ signals:
     void searchResults(const QList<Tagger::AlbumMetadata>& results);
 
 protected:
+    // Runs parse() on the parser pool, then hands its result to deliver() on
+    // this object's thread. Results of parses started before the last
+    // cancelParse() (or a newer startParse()) are dropped.
+    template<typename Parse, typename Deliver>
+    void startParse(Parse&& parse, Deliver&& deliver)
+    {
+        using Result = std::invoke_result_t<Parse>;
+
+        const quint64 generation = ++m_parseGeneration;
+        QtConcurrent::run(parserPool(), std::forward<Parse>(parse))
+            .then(this, [this, generation, deliver = std::forward<Deliver>(deliver)](const Result& result) {
+                if(generation == m_parseGeneration) {
+                    deliver(result);
+                }
+            });
+    }
+
+    void cancelParse() { ++m_parseGeneration; }
+
+    static QThreadPool* parserPool();
+
     HttpClient* m_httpClient;
+    int m_localTrackCount{0};
+
+private:
+    quint64 m_parseGeneration{0};
 };
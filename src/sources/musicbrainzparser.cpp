@@ -0,0 +1,343 @@
+#include "musicbrainzparser.h"
+#include "jsonreader.h"
+
+#include <QStringList>
+#include <QDebug>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+using TokenType = JsonReader::TokenType;
+using Disc = QList<Tagger::TrackMetadata>;
+
+// Calls read(key, type) for each member of the object just begun, with the
+// reader on the member's first token. Whatever read() leaves of an object
+// or array value is skipped.
+template<typename Read>
+void readObject(JsonReader& reader, Read read)
+{
+    while(reader.next() == TokenType::Key) {
+        const QByteArrayView key = reader.raw();
+        const TokenType type = reader.next();
+        read(key, type);
+        reader.skip();
+    }
+}
+
+// Same for each element of the array just begun
+template<typename Read>
+void readArray(JsonReader& reader, Read read)
+{
+    for(TokenType type = reader.next(); type != TokenType::EndArray && type != TokenType::Error;
+        type = reader.next()) {
+        read(type);
+        reader.skip();
+    }
+}
+
+// Artist names of an artist-credit array, one per credit
+QStringList readArtistCredit(JsonReader& reader)
+{
+    QStringList names;
+    readArray(reader, [&](TokenType type) {
+        QString name;
+        if(type == TokenType::BeginObject) {
+            readObject(reader, [&](QByteArrayView key, TokenType value) {
+                if(key == "artist" && value == TokenType::BeginObject) {
+                    readObject(reader, [&](QByteArrayView artistKey, TokenType) {
+                        if(artistKey == "name") {
+                            name = reader.string();
+                        }
+                    });
+                }
+            });
+        }
+        names.append(name);
+    });
+    return names;
+}
+
+Tagger::TrackMetadata readTrack(JsonReader& reader)
+{
+    Tagger::TrackMetadata track;
+    QStringList trackArtists;
+    QStringList recordingArtists;
+
+    readObject(reader, [&](QByteArrayView key, TokenType type) {
+        if(key == "title") {
+            // The track title, which may differ from the recording's
+            track.title = reader.string();
+        }
+        else if(key == "position") {
+            track.trackNumber = reader.toInt();
+        }
+        else if(key == "length") {
+            // Milliseconds
+            track.durationSeconds = reader.toInt() / 1000;
+        }
+        else if(key == "artist-credit" && type == TokenType::BeginArray) {
+            trackArtists = readArtistCredit(reader);
+        }
+        else if(key == "recording" && type == TokenType::BeginObject) {
+            readObject(reader, [&](QByteArrayView recordingKey, TokenType recordingType) {
+                if(recordingKey == "id") {
+                    track.mbid = reader.string();
+                }
+                else if(recordingKey == "artist-credit" && recordingType == TokenType::BeginArray) {
+                    recordingArtists = readArtistCredit(reader);
+                }
+            });
+        }
+    });
+
+    track.artist = (trackArtists.isEmpty() ? recordingArtists : trackArtists).join(QStringLiteral(", "));
+    return track;
+}
+
+struct Medium
+{
+    Disc tracks;
+    int trackCount{-1}; // As listed, which it is even when the tracks are not
+    QString format;
+};
+
+// A release of a release group
+struct Release
+{
+    QString id;
+    QString title;
+    QString country;
+    QString date;
+    QList<Medium> media;
+};
+
+QList<Medium> readMedia(JsonReader& reader)
+{
+    QList<Medium> media;
+    readArray(reader, [&](TokenType type) {
+        Medium& medium = media.emplace_back();
+        if(type != TokenType::BeginObject) {
+            return;
+        }
+        readObject(reader, [&](QByteArrayView key, TokenType value) {
+            if(key == "tracks" && value == TokenType::BeginArray) {
+                readArray(reader, [&](TokenType trackType) {
+                    medium.tracks.append(trackType == TokenType::BeginObject ? readTrack(reader)
+                                                                             : Tagger::TrackMetadata{});
+                });
+            }
+            else if(key == "track-count") {
+                medium.trackCount = reader.toInt();
+            }
+            else if(key == "format") {
+                medium.format = reader.string();
+            }
+        });
+    });
+    return media;
+}
+
+Release readRelease(JsonReader& reader)
+{
+    Release release;
+    readObject(reader, [&](QByteArrayView key, TokenType type) {
+        if(key == "id") {
+            release.id = reader.string();
+        }
+        else if(key == "title") {
+            release.title = reader.string();
+        }
+        else if(key == "country") {
+            release.country = reader.string();
+        }
+        else if(key == "date") {
+            release.date = reader.string();
+        }
+        else if(key == "media" && type == TokenType::BeginArray) {
+            release.media = readMedia(reader);
+        }
+    });
+    return release;
+}
+
+int yearOf(const QString& date)
+{
+    return date.isEmpty() ? 0 : date.left(4).toInt();
+}
+
+bool hasTracks(const QList<Medium>& media)
+{
+    return std::any_of(media.cbegin(), media.cend(), [](const Medium& medium) { return !medium.tracks.isEmpty(); });
+}
+
+// Numbers the tracks of every disc and gives them what they share with the album
+QList<Tagger::TrackMetadata> albumTracks(const Tagger::AlbumMetadata& metadata, const QList<Medium>& media)
+{
+    QList<Tagger::TrackMetadata> tracks;
+    const auto totalDiscs = static_cast<int>(media.size());
+    for(int discNum = 0; discNum < totalDiscs; ++discNum) {
+        const Disc& disc = media[discNum].tracks;
+        for(Tagger::TrackMetadata track : disc) {
+            track.album = metadata.album;
+            track.albumArtist = metadata.albumArtist;
+            track.year = metadata.year;
+            track.totalTracks = static_cast<int>(disc.size());
+            track.discNumber = discNum + 1;
+            track.totalDiscs = totalDiscs;
+            if(track.artist.isEmpty()) {
+                track.artist = metadata.albumArtist;
+            }
+            tracks.append(track);
+        }
+    }
+    return tracks;
+}
+
+// "2×CD + DVD, IN, 1976-05-14", led by the release's title if it is not the group's
+QString describeRelease(const Release& release, const QString& groupTitle)
+{
+    QStringList formats;
+    for(qsizetype i = 0; i < release.media.size();) {
+        const QString& format = release.media[i].format;
+        qsizetype same{1};
+        while(i + same < release.media.size() && release.media[i + same].format == format) {
+            ++same;
+        }
+        if(!format.isEmpty()) {
+            formats.append(same > 1 ? QStringLiteral("%1×%2").arg(same).arg(format) : format);
+        }
+        i += same;
+    }
+
+    QStringList parts;
+    if(!release.title.isEmpty() && release.title != groupTitle) {
+        parts.append(release.title);
+    }
+    if(!formats.isEmpty()) {
+        parts.append(formats.join(QStringLiteral(" + ")));
+    }
+    if(!release.country.isEmpty()) {
+        parts.append(release.country);
+    }
+    if(!release.date.isEmpty()) {
+        parts.append(release.date);
+    }
+    return parts.join(QStringLiteral(", "));
+}
+
+// Checks that nothing follows the root value and turns a reader error into the result's
+MusicBrainzParser::Result finish(JsonReader& reader, Tagger::AlbumMetadata metadata)
+{
+    if(reader.type() != TokenType::Error) {
+        reader.next();
+    }
+    if(reader.hasError()) {
+        return {{}, reader.errorString()};
+    }
+    return {std::move(metadata), {}};
+}
+} // namespace
+
+MusicBrainzParser::Result MusicBrainzParser::parseRelease(QByteArrayView json)
+{
+    Tagger::AlbumMetadata metadata;
+    metadata.source = Tagger::SourceType::MusicBrainz;
+    QList<Medium> media;
+
+    JsonReader reader(json);
+    const TokenType root = reader.next();
+    if(root == TokenType::BeginObject) {
+        readObject(reader, [&](QByteArrayView key, TokenType type) {
+            if(key == "id") {
+                metadata.releaseId = reader.string();
+            }
+            else if(key == "title") {
+                metadata.album = reader.string();
+            }
+            else if(key == "country") {
+                metadata.country = reader.string();
+            }
+            else if(key == "date") {
+                metadata.year = yearOf(reader.string());
+            }
+            else if(key == "artist-credit" && type == TokenType::BeginArray) {
+                metadata.albumArtist = readArtistCredit(reader).join(QStringLiteral(", "));
+            }
+            else if(key == "media" && type == TokenType::BeginArray) {
+                media = readMedia(reader);
+            }
+        });
+    }
+    reader.skip();
+
+    metadata.sourceUrl = QStringLiteral("https://musicbrainz.org/release/%1").arg(metadata.releaseId);
+    metadata.tracks = albumTracks(metadata, media);
+
+    Result result = finish(reader, std::move(metadata));
+    if(result.error.isEmpty()) {
+        qDebug() << "Parsed release:" << result.metadata.album << "by" << result.metadata.albumArtist << "with"
+                 << result.metadata.tracks.size() << "tracks";
+    }
+    return result;
+}
+
+MusicBrainzParser::Result MusicBrainzParser::parseReleaseGroup(QByteArrayView json)
+{
+    Tagger::AlbumMetadata metadata;
+    metadata.source = Tagger::SourceType::MusicBrainz;
+    QList<Release> releases;
+
+    JsonReader reader(json);
+    const TokenType root = reader.next();
+    if(root == TokenType::BeginObject) {
+        readObject(reader, [&](QByteArrayView key, TokenType type) {
+            if(key == "id") {
+                metadata.releaseId = reader.string();
+            }
+            else if(key == "title") {
+                metadata.album = reader.string();
+            }
+            else if(key == "first-release-date") {
+                metadata.year = yearOf(reader.string());
+            }
+            else if(key == "artist-credit" && type == TokenType::BeginArray) {
+                metadata.albumArtist = readArtistCredit(reader).join(QStringLiteral(", "));
+            }
+            else if(key == "releases" && type == TokenType::BeginArray) {
+                readArray(reader, [&](TokenType releaseType) {
+                    if(releaseType == TokenType::BeginObject) {
+                        releases.append(readRelease(reader));
+                    }
+                });
+            }
+        });
+    }
+    reader.skip();
+
+    metadata.sourceUrl = QStringLiteral("https://musicbrainz.org/release-group/%1").arg(metadata.releaseId);
+
+    // Every release is a candidate tracklist, to be weighed against the local tracks.
+    // Those listed without tracks keep their layout so they can be fetched if they fit.
+    for(const Release& release : std::as_const(releases)) {
+        Tagger::TrackListCandidate& candidate = metadata.candidates.emplace_back();
+        candidate.name = describeRelease(release, metadata.album);
+        candidate.releaseId = release.id;
+        candidate.tracks = albumTracks(metadata, release.media);
+        for(const Medium& medium : release.media) {
+            candidate.discTrackCounts.append(medium.trackCount >= 0 ? medium.trackCount
+                                                                    : static_cast<int>(medium.tracks.size()));
+        }
+        // Without local tracks to go by, the first release with tracks
+        if(metadata.tracks.isEmpty() && hasTracks(release.media)) {
+            metadata.tracks = candidate.tracks;
+        }
+    }
+
+    Result result = finish(reader, std::move(metadata));
+    if(result.error.isEmpty()) {
+        qDebug() << "Parsed release group:" << result.metadata.album << "by" << result.metadata.albumArtist << "with"
+                 << result.metadata.candidates.size() << "releases," << result.metadata.tracks.size() << "tracks";
+    }
+    return result;
+}
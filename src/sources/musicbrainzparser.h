@@ -0,0 +1,32 @@
+#pragma once
+
+#include <tagger/tagger_common.h>
+
+#include <QByteArrayView>
+#include <QString>
+
+// Extracts album and track metadata from MusicBrainz ws/2 JSON replies.
+// Release and release-group replies are read in a single forward pass
+// (see JsonReader) directly on the reply buffer; only the fields that end
+// up in AlbumMetadata and TrackMetadata are ever transcoded to QString.
+// Everything else (labels, aliases, relations) is skipped without building
+// a document.
+//
+// Members may come in any order. Track fields that depend on the album
+// (album, album artist, year, disc and track totals) are filled in once
+// the whole reply has been read.
+class MusicBrainzParser
+{
+public:
+    struct Result
+    {
+        Tagger::AlbumMetadata metadata;
+        QString error; // Set, and metadata empty, if the reply is not valid JSON
+    };
+
+    static Result parseRelease(QByteArrayView json);
+    // Every release of the group becomes a candidate tracklist, with its disc
+    // layout even if its tracks are not listed; tracks are those of the first
+    // release that lists any, until a better fit is chosen
+    static Result parseReleaseGroup(QByteArrayView json);
+};
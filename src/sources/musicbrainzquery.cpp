@@ -0,0 +1,128 @@
+#include "musicbrainzquery.h"
+
+#include "models/albummetadata.h"
+
+#include <QStringList>
+#include <QUrl>
+
+namespace {
+// Inside a quoted phrase only the quote and the escape character itself are special
+QString phrase(const QString& text)
+{
+    QString escaped = text;
+    escaped.replace(QLatin1Char('\\'), QLatin1String("\\\\"));
+    escaped.replace(QLatin1Char('"'), QLatin1String("\\\""));
+    return QLatin1Char('"') + escaped + QLatin1Char('"');
+}
+
+qsizetype encodedLength(const QString& query)
+{
+    return QUrl::toPercentEncoding(query).size();
+}
+
+// Share of words found in words
+double containment(const QSet<QString>& words, const QSet<QString>& in)
+{
+    qsizetype found{0};
+    for(const QString& word : words) {
+        if(in.contains(word)) {
+            ++found;
+        }
+    }
+    return static_cast<double>(found) / static_cast<double>(words.size());
+}
+} // namespace
+
+QString MusicBrainzQuery::clause(const Lookup& lookup)
+{
+    QStringList parts;
+    if(!lookup.artist.isEmpty()) {
+        parts.append(QStringLiteral("artist:") + phrase(lookup.artist));
+    }
+    if(!lookup.album.isEmpty()) {
+        parts.append(QStringLiteral("release:") + phrase(lookup.album));
+    }
+    return parts.join(QStringLiteral(" AND "));
+}
+
+QList<QList<qsizetype>> MusicBrainzQuery::pack(const QList<Lookup>& lookups)
+{
+    QList<QList<qsizetype>> groups;
+    QList<qsizetype> group;
+
+    for(qsizetype i = 0; i < lookups.size(); ++i) {
+        if(clause(lookups[i]).isEmpty()) {
+            continue;
+        }
+
+        QList<qsizetype> grown = group;
+        grown.append(i);
+        // A lookup too long to share a query still gets one of its own
+        if(!group.isEmpty()
+           && (grown.size() > MaxLookupsPerQuery || encodedLength(combine(lookups, grown)) > MaxQueryLength)) {
+            groups.append(group);
+            grown = {i};
+        }
+        group = grown;
+    }
+
+    if(!group.isEmpty()) {
+        groups.append(group);
+    }
+    return groups;
+}
+
+QString MusicBrainzQuery::combine(const QList<Lookup>& lookups, const QList<qsizetype>& group)
+{
+    if(group.size() == 1) {
+        return clause(lookups[group.constFirst()]);
+    }
+
+    QStringList clauses;
+    for(const qsizetype index : group) {
+        clauses.append(QLatin1Char('(') + clause(lookups[index]) + QLatin1Char(')'));
+    }
+    return clauses.join(QStringLiteral(" OR "));
+}
+
+QList<qsizetype> MusicBrainzQuery::assign(const QList<Tagger::AlbumMetadata>& results, const QList<Lookup>& lookups,
+                                          const QList<qsizetype>& group)
+{
+    QList<qsizetype> owners;
+    owners.reserve(results.size());
+
+    for(const auto& result : results) {
+        qsizetype owner{-1};
+        double best{0.0};
+        // Ties go to the earlier lookup
+        for(qsizetype i = 0; i < group.size(); ++i) {
+            const double score = fit(result, lookups[group[i]]);
+            if(score > best) {
+                owner = i;
+                best = score;
+            }
+        }
+        owners.append(owner);
+    }
+
+    return owners;
+}
+
+double MusicBrainzQuery::fit(const Tagger::AlbumMetadata& result, const Lookup& lookup)
+{
+    // Lucene also matches aliases and sort names, so a result can hold fewer of the words than it was found by
+    const QSet<QString> artist = Tagger::titleWords(lookup.artist);
+    const QSet<QString> album = Tagger::titleWords(lookup.album);
+
+    if(artist.isEmpty() && album.isEmpty()) {
+        return 0.0;
+    }
+    if(artist.isEmpty()) {
+        return containment(album, Tagger::titleWords(result.album));
+    }
+    if(album.isEmpty()) {
+        return containment(artist, Tagger::titleWords(result.albumArtist));
+    }
+    return 0.5 * containment(artist, Tagger::titleWords(result.albumArtist))
+         + 0.5 * containment(album, Tagger::titleWords(result.album));
+}
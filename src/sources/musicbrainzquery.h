@@ -0,0 +1,44 @@
+#pragma once
+
+#include <tagger/tagger_common.h>
+
+#include <QList>
+#include <QString>
+
+// Builds MusicBrainz release search queries (Lucene syntax) and packs many
+// artist/album lookups into a few requests.
+// Each lookup becomes one clause, artist:"..." AND release:"..."; clauses
+// are OR-ed together as long as the percent-encoded query stays under
+// MaxQueryLength and there are at most MaxLookupsPerQuery of them. The
+// combined result list is then handed back to the lookups it belongs to:
+// every result goes to the lookup whose words it contains best.
+class MusicBrainzQuery
+{
+public:
+    struct Lookup
+    {
+        QString artist;
+        QString album;
+    };
+
+    // Results per page, and the pages read for one combined query at most
+    static constexpr int PageSize = 25;
+    static constexpr int MaxPages = 4;
+    // Lookups share the page, so few enough that each gets a fair share of it
+    static constexpr int MaxLookupsPerQuery = 8;
+    // Percent-encoded length of the combined query; keeps the URL well under common server limits
+    static constexpr int MaxQueryLength = 1500;
+
+    // Lucene clause of one lookup; empty if it has neither artist nor album
+    static QString clause(const Lookup& lookup);
+    // Indices of lookups, split into groups that fit one combined query each
+    static QList<QList<qsizetype>> pack(const QList<Lookup>& lookups);
+    static QString combine(const QList<Lookup>& lookups, const QList<qsizetype>& group);
+    // For every result, the index into group of the lookup it belongs to, -1 if none fits
+    static QList<qsizetype> assign(const QList<Tagger::AlbumMetadata>& results, const QList<Lookup>& lookups,
+                                   const QList<qsizetype>& group);
+
+private:
+    // Share of the lookup's words found in the result, 0 to 1
+    static double fit(const Tagger::AlbumMetadata& result, const Lookup& lookup);
+};
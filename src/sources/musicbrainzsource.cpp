@@ -1,20 +1,35 @@
 #include "musicbrainzsource.h"
 #include "core/httpclient.h"
+#include "core/metadatacache.h"
+#include "core/responsecache.h"
+#include "models/albummetadata.h"
+#include "musicbrainzparser.h"
 
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
-#include <QNetworkReply>
 #include <QRegularExpression>
 #include <QUrl>
 #include <QUrlQuery>
 #include <QDebug>
 
+#include <algorithm>
+#include <utility>
+
 MusicBrainzSource::MusicBrainzSource(HttpClient* client, QObject* parent)
     : MetadataSource(client, parent)
 {
-    // Set rate limit for MusicBrainz (1 request per second)
-    m_httpClient->setRateLimit(1000);
+    // MusicBrainz allows one request per second; other hosts keep their own queues
+    const QString host = QUrl(QString::fromLatin1(API_BASE)).host();
+    m_httpClient->setRateLimit(host, 1.0);
+
+    // It answers 503 when everyone together goes over its global rate; back off and try again
+    RetryPolicy retry;
+    retry.maxAttempts = 5;
+    retry.baseDelayMs = 2000;
+    retry.maxDelayMs = 30000;
+    retry.deadlineMs = 120000;
+    m_httpClient->setRetryPolicy(host, retry);
 }
 
 bool MusicBrainzSource::isValidUrl(const QString& url) const
@@ -83,86 +98,137 @@ void MusicBrainzSource::searchAlbum(const QString& artist, const QString& album)
         return;
     }
 
+    sendRequest(RequestType::Search, buildSearchUrl(artist, album), &MusicBrainzSource::onSearchReply);
+    cancelPrefetches();
+    m_searchedAlbum = album;
+}
+
+void MusicBrainzSource::searchAlbums(const QList<MusicBrainzQuery::Lookup>& lookups)
+{
     cancel();
 
-    emit fetchStarted();
-    m_currentRequestType = RequestType::Search;
+    m_batch.lookups = lookups;
+    m_batch.groups = MusicBrainzQuery::pack(lookups);
 
-    QUrl searchUrl = buildSearchUrl(artist, album);
-    m_currentReply = m_httpClient->get(searchUrl);
+    qsizetype packed{0};
+    for(const auto& group : std::as_const(m_batch.groups)) {
+        packed += group.size();
+    }
+    qCDebug(httpClientLog) << "MusicBrainz batch search:" << packed << "lookups in" << m_batch.groups.size()
+                           << "queries";
 
-    if(m_currentReply) {
-        connect(m_currentReply, &QNetworkReply::finished, this, [this]() {
-            onSearchReply(m_currentReply);
-        });
+    // Nothing to search for
+    for(qsizetype i = 0; i < lookups.size(); ++i) {
+        if(MusicBrainzQuery::clause(lookups[i]).isEmpty()) {
+            emit batchSearchResults(i, {});
+        }
     }
+
+    if(!m_batch.groups.isEmpty()) {
+        m_batch.found.resize(m_batch.groups.constFirst().size());
+    }
+    sendBatchPage();
 }
 
-void MusicBrainzSource::fetchRelease(const QString& mbid)
+void MusicBrainzSource::sendBatchPage()
 {
-    cancel();
-
-    emit fetchStarted();
-    m_currentRequestType = RequestType::Release;
+    if(m_batch.group >= m_batch.groups.size()) {
+        m_batch = {};
+        emit batchSearchFinished();
+        return;
+    }
 
-    QUrl releaseUrl = buildReleaseUrl(mbid);
-    m_currentReply = m_httpClient->get(releaseUrl);
+    const QString query = MusicBrainzQuery::combine(m_batch.lookups, m_batch.groups[m_batch.group]);
+    sendRequest(RequestType::BatchSearch, buildQueryUrl(query, m_batch.page * MusicBrainzQuery::PageSize),
+                &MusicBrainzSource::onBatchSearchReply);
+    emit fetchProgress(static_cast<int>(100 * m_batch.group / m_batch.groups.size()));
+}
 
-    if(m_currentReply) {
-        connect(m_currentReply, &QNetworkReply::finished, this, [this]() {
-            onReleaseReply(m_currentReply);
-        });
-    }
+void MusicBrainzSource::fetchRelease(const QString& mbid)
+{
+    sendRequest(RequestType::Release, buildReleaseUrl(mbid), &MusicBrainzSource::onReleaseReply);
 }
 
 void MusicBrainzSource::fetchReleaseGroup(const QString& mbid)
 {
-    cancel();
+    sendRequest(RequestType::ReleaseGroup, buildReleaseGroupUrl(mbid), &MusicBrainzSource::onReleaseGroupReply);
+}
+
+void MusicBrainzSource::sendRequest(RequestType type, const QUrl& url,
+                                    void (MusicBrainzSource::*onReply)(const HttpResponse&))
+{
+    if(type != RequestType::BatchSearch) {
+        // Only one request is followed at a time, so the user's own takes the batch's place
+        stopBatch();
+    }
+
+    // Batch pages wait behind whatever the user asks for meanwhile
+    const auto lane = type == RequestType::BatchSearch ? RequestScheduler::Lane::Batch
+                                                       : RequestScheduler::Lane::Interactive;
+
+    // Made before the previous request is cancelled: asking for the same thing again
+    // joins its transfer rather than giving up its place under the rate limit
+    HttpRequest* request = m_httpClient->get(url, this, lane);
+    dropRequest();
 
     emit fetchStarted();
-    m_currentRequestType = RequestType::ReleaseGroup;
+    m_currentRequestType = type;
 
-    QUrl releaseGroupUrl = buildReleaseGroupUrl(mbid);
-    m_currentReply = m_httpClient->get(releaseGroupUrl);
+    m_request = request;
+    connect(m_request, &HttpRequest::succeeded, this, onReply);
+    connect(m_request, &HttpRequest::failed, this, &MusicBrainzSource::onRequestFailed);
+}
 
-    if(m_currentReply) {
-        connect(m_currentReply, &QNetworkReply::finished, this, [this]() {
-            onReleaseGroupReply(m_currentReply);
-        });
+void MusicBrainzSource::cancel()
+{
+    dropRequest();
+    cancelPrefetches();
+    m_batch = {};
+    ++m_batchGeneration;
+}
+
+void MusicBrainzSource::stopBatch()
+{
+    if(m_batch.groups.isEmpty()) {
+        return;
     }
+
+    // Lookups not searched yet get no results; whoever ran the batch still hears that it is over
+    m_batch = {};
+    ++m_batchGeneration;
+    emit batchSearchFinished();
 }
 
-void MusicBrainzSource::cancel()
+void MusicBrainzSource::dropRequest()
 {
-    if(m_currentReply) {
-        m_currentReply->abort();
-        m_currentReply->deleteLater();
-        m_currentReply = nullptr;
+    if(m_request) {
+        m_request->cancel();
+        m_request = nullptr;
     }
     m_currentRequestType = RequestType::None;
+    cancelParse();
 }
 
 QUrl MusicBrainzSource::buildSearchUrl(const QString& artist, const QString& album) const
+{
+    return buildQueryUrl(MusicBrainzQuery::clause({artist, album}), 0);
+}
+
+QUrl MusicBrainzSource::buildQueryUrl(const QString& lucene, int offset) const
 {
     QUrl url(QString("%1/release").arg(API_BASE));
     QUrlQuery query;
 
-    // Build Lucene query
-    QStringList queryParts;
-    if(!artist.isEmpty()) {
-        queryParts.append(QString("artist:\"%1\"").arg(artist));
-    }
-    if(!album.isEmpty()) {
-        queryParts.append(QString("release:\"%1\"").arg(album));
-    }
-
-    query.addQueryItem("query", queryParts.join(" AND "));
+    query.addQueryItem("query", lucene);
     query.addQueryItem("fmt", "json");
-    query.addQueryItem("limit", "25");
+    query.addQueryItem("limit", QString::number(MusicBrainzQuery::PageSize));
+    if(offset > 0) {
+        query.addQueryItem("offset", QString::number(offset));
+    }
 
     url.setQuery(query);
 
-    qDebug() << "MusicBrainz search URL:" << url.toString();
+    qCDebug(httpClientLog) << "MusicBrainz search URL:" << url.toString();
     return url;
 }
 
@@ -177,7 +243,7 @@ QUrl MusicBrainzSource::buildReleaseUrl(const QString& mbid) const
 
     url.setQuery(query);
 
-    qDebug() << "MusicBrainz release URL:" << url.toString();
+    qCDebug(httpClientLog) << "MusicBrainz release URL:" << url.toString();
     return url;
 }
 
@@ -186,131 +252,293 @@ QUrl MusicBrainzSource::buildReleaseGroupUrl(const QString& mbid) const
     QUrl url(QString("%1/release-group/%2").arg(API_BASE, mbid));
     QUrlQuery query;
 
-    // Include releases, recordings, and artist credits
-    query.addQueryItem("inc", "releases+recordings+artist-credits+labels");
+    // Include releases with their media (format and track count per disc), recordings, and artist credits
+    query.addQueryItem("inc", "releases+media+recordings+artist-credits+labels");
     query.addQueryItem("fmt", "json");
 
     url.setQuery(query);
 
-    qDebug() << "MusicBrainz release group URL:" << url.toString();
+    qCDebug(httpClientLog) << "MusicBrainz release group URL:" << url.toString();
     return url;
 }
 
-void MusicBrainzSource::onSearchReply(QNetworkReply* reply)
+void MusicBrainzSource::onRequestFailed(const HttpError& error)
 {
-    if(reply != m_currentReply) {
-        return;
+    m_request = nullptr;
+
+    switch(std::exchange(m_currentRequestType, RequestType::None)) {
+        case RequestType::Search:
+            emit fetchFailed(tr("Search failed: %1").arg(error.message));
+            return;
+        case RequestType::BatchSearch: {
+            const quint64 batch = m_batchGeneration;
+            emit fetchFailed(tr("Batch search failed: %1").arg(error.message));
+            // Unless whoever took the failure started over
+            if(batch == m_batchGeneration) {
+                stopBatch();
+            }
+            return;
+        }
+        case RequestType::Release:
+            emit fetchFailed(tr("Failed to fetch release: %1").arg(error.message));
+            return;
+        case RequestType::ReleaseGroup:
+            emit fetchFailed(tr("Failed to fetch release group: %1").arg(error.message));
+            return;
+        case RequestType::None:
+            return;
     }
+}
 
-    m_currentReply = nullptr;
+void MusicBrainzSource::onSearchReply(const HttpResponse& response)
+{
+    m_request = nullptr;
     m_currentRequestType = RequestType::None;
 
-    if(reply->error() != QNetworkReply::NoError) {
-        emit fetchFailed(tr("Search failed: %1").arg(reply->errorString()));
-        reply->deleteLater();
-        return;
-    }
+    const QByteArray data = response.body;
 
-    QByteArray data = reply->readAll();
-    reply->deleteLater();
+    startParse(
+        [data]() {
+            return parseSearchReply(data);
+        },
+        [this](const ParsedSearch& parsed) {
+            if(!parsed.jsonError.isEmpty()) {
+                emit fetchFailed(tr("Failed to parse search results: %1").arg(parsed.jsonError));
+                return;
+            }
 
-    QJsonParseError parseError;
-    QJsonDocument json = QJsonDocument::fromJson(data, &parseError);
+            if(parsed.results.isEmpty()) {
+                emit fetchFailed(tr("No releases found"));
+                return;
+            }
 
-    if(parseError.error != QJsonParseError::NoError) {
-        emit fetchFailed(tr("Failed to parse search results: %1").arg(parseError.errorString()));
-        return;
-    }
+            emit searchResults(parsed.results);
+            prefetchReleases(parsed.results, parsed.trackCounts);
+        });
+}
 
-    QList<Tagger::AlbumMetadata> results = parseSearchResults(json);
+void MusicBrainzSource::onBatchSearchReply(const HttpResponse& response)
+{
+    m_request = nullptr;
+    m_currentRequestType = RequestType::None;
 
-    if(results.isEmpty()) {
-        emit fetchFailed(tr("No releases found"));
-        return;
-    }
+    const QByteArray data = response.body;
+
+    startParse(
+        [data]() {
+            return parseSearchReply(data);
+        },
+        [this](const ParsedSearch& parsed) {
+            if(!parsed.jsonError.isEmpty()) {
+                const quint64 batch = m_batchGeneration;
+                emit fetchFailed(tr("Failed to parse search results: %1").arg(parsed.jsonError));
+                // Unless whoever took the failure started over
+                if(batch == m_batchGeneration) {
+                    stopBatch();
+                }
+                return;
+            }
+
+            const QList<qsizetype> group = m_batch.groups[m_batch.group];
+            const QList<qsizetype> owners = MusicBrainzQuery::assign(parsed.results, m_batch.lookups, group);
+            for(qsizetype i = 0; i < parsed.results.size(); ++i) {
+                if(owners[i] >= 0) {
+                    m_batch.found[owners[i]].append(parsed.results[i]);
+                }
+            }
+
+            // Lookups the server ranked lower may only show up on later pages
+            const bool unanswered = std::any_of(m_batch.found.cbegin(), m_batch.found.cend(),
+                                                [](const auto& found) { return found.isEmpty(); });
+            const int nextOffset = (m_batch.page + 1) * MusicBrainzQuery::PageSize;
+            if(unanswered && nextOffset < parsed.total && m_batch.page + 1 < MusicBrainzQuery::MaxPages) {
+                ++m_batch.page;
+                sendBatchPage();
+                return;
+            }
 
-    emit searchResults(results);
+            const QList<QList<Tagger::AlbumMetadata>> found = std::exchange(m_batch.found, {});
+            const quint64 batch = m_batchGeneration;
+            for(qsizetype i = 0; i < group.size(); ++i) {
+                emit batchSearchResults(group[i], found[i]);
+            }
+            // Cancelled or restarted by whoever took the results
+            if(batch != m_batchGeneration) {
+                return;
+            }
+
+            ++m_batch.group;
+            m_batch.page = 0;
+            if(m_batch.group < m_batch.groups.size()) {
+                m_batch.found.resize(m_batch.groups[m_batch.group].size());
+            }
+            sendBatchPage();
+        });
 }
 
-void MusicBrainzSource::onReleaseGroupReply(QNetworkReply* reply)
+void MusicBrainzSource::onReleaseGroupReply(const HttpResponse& response)
 {
-    if(reply != m_currentReply) {
+    m_request = nullptr;
+    m_currentRequestType = RequestType::None;
+
+    const QByteArray data = response.body;
+    const QString key = response.url.toString();
+    const QString revision = replyRevision(response);
+
+    if(deliverCached(key, revision)) {
         return;
     }
 
-    m_currentReply = nullptr;
+    emit fetchProgress(50);
+
+    startParse(
+        [data]() {
+            return parseAlbumReply(data, RequestType::ReleaseGroup);
+        },
+        [this, key, revision](const ParsedAlbum& parsed) {
+            if(!parsed.jsonError.isEmpty()) {
+                emit fetchFailed(tr("Failed to parse release group data: %1").arg(parsed.jsonError));
+                return;
+            }
+
+            // Releases listed without tracks are fetched on their own if they fit the local tracks
+            if(parsed.metadata.tracks.isEmpty() && parsed.metadata.candidates.isEmpty()) {
+                emit fetchFailed(tr("Release group has no releases"));
+                return;
+            }
+
+            metadataCache()->store(type(), key, revision, parsed.metadata);
+
+            emit fetchProgress(100);
+            emit fetchCompleted(parsed.metadata);
+        });
+}
+
+void MusicBrainzSource::onReleaseReply(const HttpResponse& response)
+{
+    m_request = nullptr;
     m_currentRequestType = RequestType::None;
 
-    if(reply->error() != QNetworkReply::NoError) {
-        emit fetchFailed(tr("Failed to fetch release group: %1").arg(reply->errorString()));
-        reply->deleteLater();
+    const QByteArray data = response.body;
+    const QString key = response.url.toString();
+    const QString revision = replyRevision(response);
+
+    if(deliverCached(key, revision)) {
         return;
     }
 
-    QByteArray data = reply->readAll();
-    reply->deleteLater();
-
     emit fetchProgress(50);
 
-    QJsonParseError parseError;
-    QJsonDocument json = QJsonDocument::fromJson(data, &parseError);
+    startParse(
+        [data]() {
+            return parseAlbumReply(data, RequestType::Release);
+        },
+        [this, key, revision](const ParsedAlbum& parsed) {
+            if(!parsed.jsonError.isEmpty()) {
+                emit fetchFailed(tr("Failed to parse release data: %1").arg(parsed.jsonError));
+                return;
+            }
 
-    if(parseError.error != QJsonParseError::NoError) {
-        emit fetchFailed(tr("Failed to parse release group data: %1").arg(parseError.errorString()));
-        return;
-    }
+            if(parsed.metadata.tracks.isEmpty()) {
+                emit fetchFailed(tr("Release has no tracks"));
+                return;
+            }
+
+            metadataCache()->store(type(), key, revision, parsed.metadata);
 
-    Tagger::AlbumMetadata metadata = parseReleaseGroup(json);
+            emit fetchProgress(100);
+            emit fetchCompleted(parsed.metadata);
+        });
+}
 
-    if(metadata.tracks.isEmpty()) {
-        emit fetchFailed(tr("Release group has no tracks"));
+void MusicBrainzSource::prefetchReleases(const QList<Tagger::AlbumMetadata>& results, const QList<int>& trackCounts)
+{
+    // Nowhere to keep them
+    if(!m_httpClient->cache()) {
         return;
     }
 
-    emit fetchProgress(100);
-    emit fetchCompleted(metadata);
+    const QList<qsizetype> order = Tagger::rankSearchResults(results, trackCounts, m_searchedAlbum, m_localTrackCount);
+    for(const qsizetype index : order.first(std::min<qsizetype>(PrefetchCount, order.size()))) {
+        const QUrl url = buildReleaseUrl(results[index].releaseId);
+        if(m_httpClient->cache()->isFresh(url)) {
+            continue;
+        }
+
+        // Picking the result later joins this transfer and moves it up to the interactive lane
+        HttpRequest* request = m_httpClient->get(url, this, RequestScheduler::Lane::Idle);
+        connect(request, &HttpRequest::failed, this, [url](const HttpError& error) {
+            qCDebug(httpClientLog) << "MusicBrainz prefetch of" << url.toString() << "failed:" << error.message;
+        });
+        m_prefetches.append(request);
+    }
 }
 
-void MusicBrainzSource::onReleaseReply(QNetworkReply* reply)
+void MusicBrainzSource::cancelPrefetches()
 {
-    if(reply != m_currentReply) {
-        return;
+    for(const auto& request : std::as_const(m_prefetches)) {
+        if(request) {
+            request->cancel();
+        }
     }
+    m_prefetches.clear();
+}
 
-    m_currentReply = nullptr;
-    m_currentRequestType = RequestType::None;
+QString MusicBrainzSource::replyRevision(const HttpResponse& response)
+{
+    QString revision;
+    if(const QByteArray etag = response.header("ETag"); !etag.isEmpty()) {
+        revision = QStringLiteral("etag:") + QString::fromLatin1(etag);
+    }
+    else if(const QByteArray modified = response.header("Last-Modified"); !modified.isEmpty()) {
+        revision = QStringLiteral("modified:") + QString::fromLatin1(modified);
+    }
+    else {
+        // Far cheaper than parsing the body again
+        const QByteArray& data = response.body;
+        revision = QStringLiteral("hash:%1:%2").arg(qHash(QByteArrayView(data)), 0, 16).arg(data.size());
+    }
+    return revision + QStringLiteral("/parser:%1").arg(ParserVersion);
+}
 
-    if(reply->error() != QNetworkReply::NoError) {
-        emit fetchFailed(tr("Failed to fetch release: %1").arg(reply->errorString()));
-        reply->deleteLater();
-        return;
+bool MusicBrainzSource::deliverCached(const QString& key, const QString& revision)
+{
+    const auto cached = metadataCache()->lookup(type(), key, revision);
+    if(!cached) {
+        return false;
     }
 
-    QByteArray data = reply->readAll();
-    reply->deleteLater();
+    qCDebug(httpClientLog) << "Metadata cache hit for" << key << revision;
+    emit fetchProgress(100);
+    emit fetchCompleted(*cached);
+    return true;
+}
 
-    emit fetchProgress(50);
+MusicBrainzSource::ParsedSearch MusicBrainzSource::parseSearchReply(const QByteArray& data)
+{
+    ParsedSearch parsed;
 
     QJsonParseError parseError;
     QJsonDocument json = QJsonDocument::fromJson(data, &parseError);
 
     if(parseError.error != QJsonParseError::NoError) {
-        emit fetchFailed(tr("Failed to parse release data: %1").arg(parseError.errorString()));
-        return;
+        parsed.jsonError = parseError.errorString();
+        return parsed;
     }
 
-    Tagger::AlbumMetadata metadata = parseRelease(json);
-
-    if(metadata.tracks.isEmpty()) {
-        emit fetchFailed(tr("Release has no tracks"));
-        return;
-    }
+    parsed.results = parseSearchResults(json, parsed.trackCounts);
+    parsed.total = json.object()["count"].toInt();
+    return parsed;
+}
 
-    emit fetchProgress(100);
-    emit fetchCompleted(metadata);
+MusicBrainzSource::ParsedAlbum MusicBrainzSource::parseAlbumReply(const QByteArray& data, RequestType type)
+{
+    MusicBrainzParser::Result result = type == RequestType::ReleaseGroup ? MusicBrainzParser::parseReleaseGroup(data)
+                                                                         : MusicBrainzParser::parseRelease(data);
+    return {std::move(result.metadata), std::move(result.error)};
 }
 
-QList<Tagger::AlbumMetadata> MusicBrainzSource::parseSearchResults(const QJsonDocument& json)
+QList<Tagger::AlbumMetadata> MusicBrainzSource::parseSearchResults(const QJsonDocument& json, QList<int>& trackCounts)
 {
     QList<Tagger::AlbumMetadata> results;
 
@@ -345,214 +573,9 @@ QList<Tagger::AlbumMetadata> MusicBrainzSource::parseSearchResults(const QJsonDo
         metadata.sourceUrl = QString("https://musicbrainz.org/release/%1").arg(metadata.releaseId);
 
         results.append(metadata);
+        trackCounts.append(release["track-count"].toInt());
     }
 
-    qDebug() << "Parsed" << results.size() << "search results";
+    qCDebug(httpClientLog) << "Parsed" << results.size() << "search results";
     return results;
 }
-
-Tagger::AlbumMetadata MusicBrainzSource::parseReleaseGroup(const QJsonDocument& json)
-{
-    Tagger::AlbumMetadata metadata;
-    metadata.source = Tagger::SourceType::MusicBrainz;
-
-    QJsonObject root = json.object();
-
-    metadata.releaseId = root["id"].toString();
-    metadata.album = root["title"].toString();
-    metadata.sourceUrl = QString("https://musicbrainz.org/release-group/%1").arg(metadata.releaseId);
-
-    // Parse date
-    QString date = root["first-release-date"].toString();
-    if(!date.isEmpty()) {
-        metadata.year = date.left(4).toInt();
-    }
-
-    // Parse album artist
-    QJsonArray artistCredit = root["artist-credit"].toArray();
-    QStringList artists;
-    for(const QJsonValue& creditVal : artistCredit) {
-        QJsonObject credit = creditVal.toObject();
-        QJsonObject artist = credit["artist"].toObject();
-        artists.append(artist["name"].toString());
-    }
-    metadata.albumArtist = artists.join(", ");
-
-    // Get first release with tracks
-    QJsonArray releases = root["releases"].toArray();
-    for(const QJsonValue& releaseVal : releases) {
-        QJsonObject release = releaseVal.toObject();
-        // For simplicity, pick the first release with media and tracks
-        if(release.contains("media")) {
-            QJsonArray media = release["media"].toArray();
-            bool hasTracks = false;
-            for(const QJsonValue& mediaVal : media) {
-                QJsonObject disc = mediaVal.toObject();
-                if(disc.contains("tracks") && disc["tracks"].toArray().size() > 0) {
-                    hasTracks = true;
-                    break;
-                }
-            }
-            if(hasTracks) {
-                // If we have a full release object with media/tracks, parse it
-                if(release.contains("media")) {
-                    int totalDiscs = media.size();
-                    int globalTrackNum = 0;
-
-                    for(int discNum = 0; discNum < media.size(); ++discNum) {
-                        QJsonObject disc = media[discNum].toObject();
-                        QJsonArray tracks = disc["tracks"].toArray();
-                        int totalTracksOnDisc = tracks.size();
-
-                        for(int trackIdx = 0; trackIdx < tracks.size(); ++trackIdx) {
-                            QJsonObject trackObj = tracks[trackIdx].toObject();
-
-                            Tagger::TrackMetadata track;
-                            track.album = metadata.album;
-                            track.albumArtist = metadata.albumArtist;
-                            track.year = metadata.year;
-
-                            // Track title (prefer track title over recording title)
-                            track.title = trackObj["title"].toString();
-
-                            // Track position
-                            track.trackNumber = trackObj["position"].toInt();
-                            track.totalTracks = totalTracksOnDisc;
-                            track.discNumber = discNum + 1;
-                            track.totalDiscs = totalDiscs;
-
-                            // Duration (in milliseconds from API, convert to seconds)
-                            int lengthMs = trackObj["length"].toInt();
-                            track.durationSeconds = lengthMs / 1000;
-
-                            // Recording info
-                            QJsonObject recording = trackObj["recording"].toObject();
-                            track.mbid = recording["id"].toString();
-
-                            // Track artist credit
-                            QJsonArray trackArtistCredit = trackObj["artist-credit"].toArray();
-                            if(trackArtistCredit.isEmpty()) {
-                                trackArtistCredit = recording["artist-credit"].toArray();
-                            }
-
-                            QStringList trackArtists;
-                            for(const QJsonValue& creditVal : trackArtistCredit) {
-                                QJsonObject credit = creditVal.toObject();
-                                QJsonObject artist = credit["artist"].toObject();
-                                trackArtists.append(artist["name"].toString());
-                            }
-                            track.artist = trackArtists.join(", ");
-
-                            if(track.artist.isEmpty()) {
-                                track.artist = metadata.albumArtist;
-                            }
-
-                            metadata.tracks.append(track);
-                            globalTrackNum++;
-                        }
-                    }
-                }
-                break;
-            }
-        }
-    }
-
-    qDebug() << "Parsed release group:" << metadata.album
-             << "by" << metadata.albumArtist
-             << "with" << metadata.tracks.size() << "tracks";
-
-    return metadata;
-}
-
-Tagger::AlbumMetadata MusicBrainzSource::parseRelease(const QJsonDocument& json)
-{
-    Tagger::AlbumMetadata metadata;
-    metadata.source = Tagger::SourceType::MusicBrainz;
-
-    QJsonObject root = json.object();
-
-    metadata.releaseId = root["id"].toString();
-    metadata.album = root["title"].toString();
-    metadata.country = root["country"].toString();
-    metadata.sourceUrl = QString("https://musicbrainz.org/release/%1").arg(metadata.releaseId);
-
-    // Parse date
-    QString date = root["date"].toString();
-    if(!date.isEmpty()) {
-        metadata.year = date.left(4).toInt();
-    }
-
-    // Parse album artist
-    QJsonArray artistCredit = root["artist-credit"].toArray();
-    QStringList artists;
-    for(const QJsonValue& creditVal : artistCredit) {
-        QJsonObject credit = creditVal.toObject();
-        QJsonObject artist = credit["artist"].toObject();
-        artists.append(artist["name"].toString());
-    }
-    metadata.albumArtist = artists.join(", ");
-
-    // Parse media (discs) and tracks
-    QJsonArray media = root["media"].toArray();
-    int totalDiscs = media.size();
-    int globalTrackNum = 0;
-
-    for(int discNum = 0; discNum < media.size(); ++discNum) {
-        QJsonObject disc = media[discNum].toObject();
-        QJsonArray tracks = disc["tracks"].toArray();
-        int totalTracksOnDisc = tracks.size();
-
-        for(int trackIdx = 0; trackIdx < tracks.size(); ++trackIdx) {
-            QJsonObject trackObj = tracks[trackIdx].toObject();
-
-            Tagger::TrackMetadata track;
-            track.album = metadata.album;
-            track.albumArtist = metadata.albumArtist;
-            track.year = metadata.year;
-
-            // Track title (prefer track title over recording title)
-            track.title = trackObj["title"].toString();
-
-            // Track position
-            track.trackNumber = trackObj["position"].toInt();
-            track.totalTracks = totalTracksOnDisc;
-            track.discNumber = discNum + 1;
-            track.totalDiscs = totalDiscs;
-
-            // Duration (in milliseconds from API, convert to seconds)
-            int lengthMs = trackObj["length"].toInt();
-            track.durationSeconds = lengthMs / 1000;
-
-            // Recording info
-            QJsonObject recording = trackObj["recording"].toObject();
-            track.mbid = recording["id"].toString();
-
-            // Track artist credit
-            QJsonArray trackArtistCredit = trackObj["artist-credit"].toArray();
-            if(trackArtistCredit.isEmpty()) {
-                trackArtistCredit = recording["artist-credit"].toArray();
-            }
-
-            QStringList trackArtists;
-            for(const QJsonValue& creditVal : trackArtistCredit) {
-                QJsonObject credit = creditVal.toObject();
-                QJsonObject artist = credit["artist"].toObject();
-                trackArtists.append(artist["name"].toString());
-            }
-            track.artist = trackArtists.join(", ");
-
-            if(track.artist.isEmpty()) {
-                track.artist = metadata.albumArtist;
-            }
-
-            metadata.tracks.append(track);
-            globalTrackNum++;
-        }
-    }
-
-    qDebug() << "Parsed release:" << metadata.album
-             << "by" << metadata.albumArtist
-             << "with" << metadata.tracks.size() << "tracks";
-
-    return metadata;
-}
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "metadatasource.h"
+#include "musicbrainzquery.h"
+#include "core/httprequest.h"
+
+#include <QPointer>
 
-class QNetworkReply;
 class QJsonDocument;
 
 class MusicBrainzSource : public MetadataSource
@@ -19,33 +22,99 @@ public:
 
     void fetchFromUrl(const QString& url) override;
     void searchAlbum(const QString& artist, const QString& album) override;
+    // Looks up many artist/album pairs in as few requests as possible (see MusicBrainzQuery).
+    // Each lookup's results arrive through batchSearchResults once its combined query is
+    // done, batchSearchFinished after the last one. Any other fetch made meanwhile ends
+    // the batch early, as does a failed query; batchSearchFinished still follows.
+    void searchAlbums(const QList<MusicBrainzQuery::Lookup>& lookups);
     void fetchRelease(const QString& mbid);
     void fetchReleaseGroup(const QString& mbid);
+    // Also stops the prefetches of the last search
     void cancel() override;
 
     [[nodiscard]] bool isValidUrl(const QString& url) const override;
 
+signals:
+    void batchSearchResults(qsizetype index, const QList<Tagger::AlbumMetadata>& results);
+    void batchSearchFinished();
+
 private slots:
-    void onSearchReply(QNetworkReply* reply);
-    void onReleaseReply(QNetworkReply* reply);
-    void onReleaseGroupReply(QNetworkReply* reply);
+    void onSearchReply(const HttpResponse& response);
+    void onBatchSearchReply(const HttpResponse& response);
+    void onReleaseReply(const HttpResponse& response);
+    void onReleaseGroupReply(const HttpResponse& response);
+    void onRequestFailed(const HttpError& error);
 
 private:
+    enum class RequestType { None, Search, BatchSearch, Release, ReleaseGroup };
+
+    struct BatchSearch
+    {
+        QList<MusicBrainzQuery::Lookup> lookups;
+        QList<QList<qsizetype>> groups;
+        qsizetype group{0}; // The one being searched
+        int page{0};
+        QList<QList<Tagger::AlbumMetadata>> found; // Per lookup of the group
+    };
+
+    // Part of every metadata cache revision; bump it when parsing changes so that cached albums are parsed again
+    static constexpr int ParserVersion = 2;
+
     static constexpr const char* API_BASE = "https://musicbrainz.org/ws/2";
 
+    // Search results fetched ahead on the idle lane, best fit first
+    static constexpr int PrefetchCount = 3;
+
     QUrl buildSearchUrl(const QString& artist, const QString& album) const;
+    QUrl buildQueryUrl(const QString& query, int offset) const;
     QUrl buildReleaseUrl(const QString& mbid) const;
     QUrl buildReleaseGroupUrl(const QString& mbid) const;
 
-    QList<Tagger::AlbumMetadata> parseSearchResults(const QJsonDocument& json);
-    Tagger::AlbumMetadata parseRelease(const QJsonDocument& json);
-    Tagger::AlbumMetadata parseReleaseGroup(const QJsonDocument& json);
+    // Queues url on the shared client; onReply runs once it has succeeded
+    void sendRequest(RequestType type, const QUrl& url, void (MusicBrainzSource::*onReply)(const HttpResponse&));
+    // Drops the request in progress and its parse
+    void dropRequest();
+    // Requests the current page of the batch's current group, or finishes the batch
+    void sendBatchPage();
+    // Ends a batch before its last group and emits batchSearchFinished
+    void stopBatch();
+
+    // Warms the response cache with the releases the user is likely to pick next
+    void prefetchReleases(const QList<Tagger::AlbumMetadata>& results, const QList<int>& trackCounts);
+    void cancelPrefetches();
+
+    // Parsing runs on the parser pool, so these must not touch member state
+    struct ParsedSearch
+    {
+        QList<Tagger::AlbumMetadata> results;
+        QList<int> trackCounts; // Per result, 0 if not listed
+        int total{0};           // Matches on the server, across all pages
+        QString jsonError;
+    };
+
+    struct ParsedAlbum
+    {
+        Tagger::AlbumMetadata metadata;
+        QString jsonError;
+    };
+
+    // Metadata cache revision of a reply: its ETag or Last-Modified, or a hash of the body
+    static QString replyRevision(const HttpResponse& response);
+    // Emits a cached parse of the same reply; true on a hit
+    bool deliverCached(const QString& key, const QString& revision);
+
+    static ParsedSearch parseSearchReply(const QByteArray& data);
+    static ParsedAlbum parseAlbumReply(const QByteArray& data, RequestType type);
+
+    static QList<Tagger::AlbumMetadata> parseSearchResults(const QJsonDocument& json, QList<int>& trackCounts);
 
     QString extractMbidFromUrl(const QString& url) const;
     QString extractMbidFromUrl(const QString& url, QString& entityType) const;
 
-    enum class RequestType { None, Search, Release, ReleaseGroup };
-
-    QNetworkReply* m_currentReply{nullptr};
+    QPointer<HttpRequest> m_request;
     RequestType m_currentRequestType{RequestType::None};
+    QString m_searchedAlbum;
+    BatchSearch m_batch;
+    quint64 m_batchGeneration{0}; // Bumped whenever the batch is cancelled
+    QList<QPointer<HttpRequest>> m_prefetches;
 };
@@ -0,0 +1,424 @@
+#include "wikipediaparser.h"
+#include "wikitextcleaner.h"
+#include "models/albummetadata.h"
+
+#include <QRegularExpression>
+#include <QDebug>
+
+namespace {
+bool containsIgnoreCase(QByteArrayView text, QByteArrayView needle)
+{
+    for(qsizetype i = 0; i + needle.size() <= text.size(); ++i) {
+        if(text.sliced(i, needle.size()).compare(needle, Qt::CaseInsensitive) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
+WikipediaParser::WikipediaParser(const QString& sourceUrl)
+{
+    m_metadata.source = Tagger::SourceType::Wikipedia;
+    m_metadata.sourceUrl = sourceUrl;
+}
+
+Tagger::AlbumMetadata WikipediaParser::parsePage(QByteArrayView html, const QString& sourceUrl)
+{
+    // The whole page is already in memory, so parse it in place
+    WikipediaParser parser(sourceUrl);
+    parser.m_input = html;
+    parser.parse(true);
+    return parser.m_metadata;
+}
+
+void WikipediaParser::feed(QByteArrayView chunk)
+{
+    if(isComplete() || chunk.isEmpty()) {
+        return;
+    }
+
+    m_buffer.append(chunk);
+    m_input = m_buffer;
+    parse(false);
+}
+
+void WikipediaParser::finish()
+{
+    if(isComplete()) {
+        return;
+    }
+
+    m_input = m_buffer;
+    parse(true);
+}
+
+void WikipediaParser::setPageTitle(const QString& title)
+{
+    m_metadata.album = cleanPageTitle(title);
+}
+
+void WikipediaParser::parse(bool complete)
+{
+    m_tokenizer.setInput(m_input, complete);
+
+    while(m_state != State::Done) {
+        const WikiHtmlTokenizer::Token token = m_tokenizer.next();
+        if(token.type == WikiHtmlTokenizer::TokenType::End) {
+            break;
+        }
+        handleToken(token);
+    }
+
+    if(m_state != State::Done && !complete) {
+        return;
+    }
+
+    if(m_state == State::InTable) {
+        // Page ended inside the table
+        finishTable();
+    }
+
+    if(m_state == State::BeforeSection) {
+        qDebug() << "No Soundtrack/Music/Track listing section found";
+    }
+    else if(m_metadata.candidates.isEmpty()) {
+        qDebug() << "No wikitable/tracklist found in section";
+    }
+
+    m_state = State::Done;
+    finalize();
+}
+
+void WikipediaParser::handleToken(const WikiHtmlTokenizer::Token& token)
+{
+    using TokenType = WikiHtmlTokenizer::TokenType;
+
+    switch(token.type) {
+        case TokenType::Title:
+            if(m_metadata.album.isEmpty()) {
+                m_metadata.album = cleanPageTitle(QString::fromUtf8(token.text));
+            }
+            break;
+
+        case TokenType::Heading: {
+            const QByteArrayView id = WikiHtmlTokenizer::attribute(token.attributes, "id");
+            if(m_state == State::BeforeSection) {
+                if(isSoundtrackHeading(id)) {
+                    m_state = State::InSection;
+                    m_sectionStart = token.offset;
+                    m_sectionLevel = token.level;
+                }
+            }
+            else if(token.level > m_sectionLevel) {
+                // Sub-headings such as "Tamil version" or "Disc 2" name the tables below them
+                m_subHeading = headingName(id);
+            }
+            else {
+                // The next heading of the same or a higher level ends the soundtrack section
+                qDebug() << "Section found from" << m_sectionStart << "to" << token.offset
+                         << "(length:" << token.offset - m_sectionStart << "bytes)";
+                if(m_state == State::InTable) {
+                    finishTable();
+                }
+                m_state = State::Done;
+            }
+            break;
+        }
+
+        case TokenType::TableStart:
+            if(m_state == State::InSection && isTracklistTable(token.attributes)) {
+                m_state = State::InTable;
+                m_tableDepth = token.depth;
+                m_table = {};
+                m_table.name = m_subHeading;
+                m_grid.clear();
+                m_rowOpen = false;
+            }
+            break;
+
+        case TokenType::Caption:
+            if(m_state == State::InTable && token.depth == m_tableDepth) {
+                const QString caption = cellText(token.text);
+                if(!caption.isEmpty()) {
+                    m_table.name = caption;
+                }
+            }
+            break;
+
+        case TokenType::TableEnd:
+            if(m_state == State::InTable && token.depth == m_tableDepth) {
+                finishTable();
+                m_state = State::InSection;
+            }
+            break;
+
+        case TokenType::RowStart:
+            if(m_state == State::InTable && token.depth == m_tableDepth) {
+                m_grid.startRow();
+                m_rowOpen = true;
+            }
+            break;
+
+        case TokenType::Cell:
+            if(m_state == State::InTable && token.depth == m_tableDepth && m_rowOpen) {
+                // Offsets rather than views: the buffer may move between chunks
+                m_grid.addCell(token.text.data() - m_input.data(), token.text.size(), token.header, token.attributes);
+            }
+            break;
+
+        case TokenType::RowEnd:
+            if(m_state == State::InTable && token.depth == m_tableDepth) {
+                m_rowOpen = false;
+            }
+            break;
+
+        case TokenType::End:
+            break;
+    }
+}
+
+void WikipediaParser::finishTable()
+{
+    m_grid.build();
+
+    auto text = [this](const WikiTableGrid::Cell* cell) {
+        return cell ? cellText(m_input.sliced(cell->start, cell->size)) : QString{};
+    };
+
+    // The first row that starts a <th> cell describes the columns
+    int headerRow{0};
+    while(headerRow < m_grid.rowCount() && !m_grid.rowStartsCell(headerRow, true)) {
+        ++headerRow;
+    }
+
+    TableColumns columns;
+    if(headerRow < m_grid.rowCount()) {
+        QStringList headers;
+        headers.reserve(m_grid.columnCount());
+        for(int column = 0; column < m_grid.columnCount(); ++column) {
+            // A header spanning several columns names only the first of them
+            const WikiTableGrid::Cell* cell = m_grid.at(headerRow, column);
+            headers.append(cell && cell->column == column ? text(cell) : QString{});
+        }
+        columns = detectColumns(headers);
+
+        for(int row = headerRow + 1; row < m_grid.rowCount(); ++row) {
+            if(!m_grid.rowStartsCell(row, false)) {
+                continue;
+            }
+            Tagger::TrackMetadata track;
+            if(parseRow(m_input, m_grid, row, columns, static_cast<int>(m_table.tracks.size()) + 1, track)) {
+                m_table.tracks.append(track);
+            }
+        }
+    }
+    m_grid.clear();
+
+    if(m_table.tracks.isEmpty()) {
+        return;
+    }
+
+    // Further tables only count when they have a title column; the first one
+    // keeps the old first-column fallback
+    if(!m_metadata.candidates.isEmpty() && columns.songIndex < 0) {
+        qDebug() << "Skipping table without a title column in section";
+        return;
+    }
+
+    m_metadata.candidates.append(std::move(m_table));
+    m_table = {};
+}
+
+void WikipediaParser::finalize()
+{
+    for(auto& candidate : m_metadata.candidates) {
+        for(auto& track : candidate.tracks) {
+            track.totalTracks = static_cast<int>(candidate.tracks.size());
+            track.album = m_metadata.album;
+        }
+    }
+
+    // The first table is used until a better fit is picked
+    if(!m_metadata.candidates.isEmpty()) {
+        Tagger::useTrackListCandidate(m_metadata, 0);
+    }
+
+    qDebug() << "Parsed Wikipedia page:" << m_metadata.album
+             << "with" << m_metadata.tracks.size() << "tracks in"
+             << m_metadata.candidates.size() << "tracklist(s)";
+}
+
+bool WikipediaParser::parseRow(QByteArrayView input, const WikiTableGrid& grid, int row, const TableColumns& columns,
+                               int rowNumber, Tagger::TrackMetadata& track)
+{
+    auto cellAt = [&grid, row](int column) {
+        return grid.at(row, column);
+    };
+
+    // Fallback: assume the first column is the title
+    const int titleColumn = columns.songIndex >= 0 ? columns.songIndex : 0;
+    const WikiTableGrid::Cell* titleCell = cellAt(titleColumn);
+    if(!titleCell) {
+        return false;
+    }
+    // A title stretched over e.g. the singer column of an instrumental fills only the title
+    auto textAt = [&input, &cellAt, titleCell](int column) {
+        const WikiTableGrid::Cell* cell = cellAt(column);
+        return cell && cell != titleCell ? cellText(input.sliced(cell->start, cell->size)) : QString{};
+    };
+    // A title reaching down from the row above belongs to the previous track
+    if(titleCell->row != row) {
+        return false;
+    }
+    // Summary rows such as "Total length" span the number and title columns with one cell
+    if((columns.numberIndex >= 0 && columns.numberIndex != titleColumn && cellAt(columns.numberIndex) == titleCell)
+       || (columns.durationIndex >= 0 && columns.durationIndex != titleColumn
+           && cellAt(columns.durationIndex) == titleCell)) {
+        return false;
+    }
+
+    track.trackNumber = rowNumber;
+
+    if(columns.numberIndex >= 0) {
+        bool ok;
+        int num = textAt(columns.numberIndex).toInt(&ok);
+        if(ok) {
+            track.trackNumber = num;
+        }
+    }
+
+    track.title = cellText(input.sliced(titleCell->start, titleCell->size));
+
+    if(columns.singerIndex >= 0) {
+        track.artist = textAt(columns.singerIndex);
+    }
+
+    if(columns.lyricsIndex >= 0) {
+        track.lyricist = textAt(columns.lyricsIndex);
+    }
+
+    if(columns.musicIndex >= 0) {
+        track.musicDirector = textAt(columns.musicIndex);
+        if(track.composer.isEmpty()) {
+            track.composer = track.musicDirector;
+        }
+    }
+
+    if(columns.durationIndex >= 0) {
+        track.durationSeconds = parseDuration(textAt(columns.durationIndex));
+    }
+
+    return !track.title.isEmpty();
+}
+
+QString WikipediaParser::cellText(QByteArrayView html)
+{
+    return WikiTextCleaner::clean(html);
+}
+
+bool WikipediaParser::isSoundtrackHeading(QByteArrayView id)
+{
+    // Soundtrack, Music, or Track listing (and variations like Track_listing)
+    return id.compare("Soundtrack", Qt::CaseInsensitive) == 0
+        || id.compare("Music", Qt::CaseInsensitive) == 0
+        || (id.size() >= 5 && id.first(5).compare("Track", Qt::CaseInsensitive) == 0);
+}
+
+QString WikipediaParser::headingName(QByteArrayView id)
+{
+    // Heading ids are the heading text with spaces as underscores
+    return QString::fromUtf8(id).replace(QLatin1Char('_'), QLatin1Char(' ')).trimmed();
+}
+
+bool WikipediaParser::isTracklistTable(QByteArrayView attributes)
+{
+    const QByteArrayView cls = WikiHtmlTokenizer::attribute(attributes, "class");
+    return containsIgnoreCase(cls, "wikitable") || containsIgnoreCase(cls, "tracklist");
+}
+
+QString WikipediaParser::cleanPageTitle(const QString& title)
+{
+    QString cleaned = title;
+    // Remove " - Wikipedia" suffix
+    static const QRegularExpression wikipediaSuffixRe(R"(\s*[-–]\s*Wikipedia.*$)", QRegularExpression::CaseInsensitiveOption);
+    cleaned.remove(wikipediaSuffixRe);
+    // Remove "(film)" suffix
+    static const QRegularExpression filmSuffixRe(R"(\s*\(film\)\s*$)", QRegularExpression::CaseInsensitiveOption);
+    cleaned.remove(filmSuffixRe);
+    return cleanWikiText(cleaned.trimmed());
+}
+
+WikipediaParser::TableColumns WikipediaParser::detectColumns(const QStringList& headers)
+{
+    TableColumns cols;
+
+    for(int i = 0; i < headers.size(); ++i) {
+        QString h = headers[i].toLower();
+
+        if(h.contains("no") || h.contains("#") || h == "sr") {
+            cols.numberIndex = i;
+        }
+        else if(h.contains("song") || h.contains("title") || h.contains("track")) {
+            cols.songIndex = i;
+        }
+        else if(h.contains("singer") || h.contains("artist") || h.contains("vocals") || h.contains("performed")) {
+            cols.singerIndex = i;
+        }
+        else if(h.contains("lyric") || h.contains("written")) {
+            cols.lyricsIndex = i;
+        }
+        else if(h.contains("music") || h.contains("composer") || h.contains("composed")) {
+            cols.musicIndex = i;
+        }
+        else if(h.contains("duration") || h.contains("length") || h.contains("time")) {
+            cols.durationIndex = i;
+        }
+    }
+
+    qDebug() << "Detected columns - Song:" << cols.songIndex
+             << "Singer:" << cols.singerIndex
+             << "Lyrics:" << cols.lyricsIndex
+             << "Music:" << cols.musicIndex
+             << "Duration:" << cols.durationIndex;
+
+    return cols;
+}
+
+QString WikipediaParser::cleanWikiText(const QString& text)
+{
+    return WikiTextCleaner::clean(text.toUtf8());
+}
+
+int WikipediaParser::parseDuration(const QString& durationStr)
+{
+    // Parse formats like "3:45", "3.45", "3m 45s", "225"
+    QString str = durationStr.trimmed();
+
+    // Format: M:SS or MM:SS
+    static QRegularExpression colonRe(R"((\d+):(\d+))");
+    QRegularExpressionMatch match = colonRe.match(str);
+    if(match.hasMatch()) {
+        int minutes = match.captured(1).toInt();
+        int seconds = match.captured(2).toInt();
+        return minutes * 60 + seconds;
+    }
+
+    // Format: M.SS
+    static QRegularExpression dotRe(R"((\d+)\.(\d+))");
+    match = dotRe.match(str);
+    if(match.hasMatch()) {
+        int minutes = match.captured(1).toInt();
+        int seconds = match.captured(2).toInt();
+        return minutes * 60 + seconds;
+    }
+
+    // Plain seconds
+    bool ok;
+    int seconds = str.toInt(&ok);
+    if(ok) {
+        return seconds;
+    }
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "wikitablegrid.h"
+#include "wikitokenizer.h"
+
+#include <tagger/tagger_common.h>
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+// Extracts album and track metadata from a Wikipedia article.
+// The page is tokenized in a single forward pass (see WikiHtmlTokenizer)
+// directly on the UTF-8 reply buffer; only the title and the table cells
+// that end up in TrackMetadata are ever transcoded to QString.
+//
+// Every tracklist table in the soundtrack section (language versions,
+// discs, bonus EPs) becomes a TrackListCandidate named after its caption
+// or sub-heading; the first one is the album's active tracklist.
+// Each table is laid out as a WikiTableGrid, so rowspan and colspan keep
+// every value under its own header column.
+//
+// A parser can be fed the page chunk by chunk while it downloads. It is
+// complete as soon as the soundtrack section has ended, so the rest of
+// the transfer can be dropped. An instance must only be used from
+// one thread at a time; the static helpers keep no state.
+class WikipediaParser
+{
+public:
+    explicit WikipediaParser(const QString& sourceUrl);
+
+    // Appends the next chunk of the page and parses as far as it allows
+    void feed(QByteArrayView chunk);
+    // Parses whatever is left once the whole page has been received
+    void finish();
+
+    // For input without a <title>, such as a single section from the parse API
+    void setPageTitle(const QString& title);
+
+    // True once no more input is needed; result() is final from then on
+    [[nodiscard]] bool isComplete() const { return m_state == State::Done; }
+    // True once the soundtrack section has been reached
+    [[nodiscard]] bool foundSection() const { return m_state != State::BeforeSection; }
+    [[nodiscard]] qsizetype bytesParsed() const { return m_tokenizer.position(); }
+    [[nodiscard]] const Tagger::AlbumMetadata& result() const { return m_metadata; }
+
+    static Tagger::AlbumMetadata parsePage(QByteArrayView html, const QString& sourceUrl);
+
+    static QString cleanWikiText(const QString& text);
+    static int parseDuration(const QString& durationStr);
+    // Soundtrack, Music or Track listing section anchors
+    static bool isSoundtrackHeading(QByteArrayView id);
+
+private:
+    enum class State
+    {
+        BeforeSection,
+        InSection,
+        InTable,
+        Done
+    };
+
+    struct TableColumns
+    {
+        int numberIndex{-1};
+        int songIndex{-1};
+        int singerIndex{-1};
+        int lyricsIndex{-1};
+        int musicIndex{-1};
+        int durationIndex{-1};
+    };
+
+    void parse(bool complete);
+    void handleToken(const WikiHtmlTokenizer::Token& token);
+    void finishTable();
+    void finalize();
+
+    static TableColumns detectColumns(const QStringList& headers);
+    static bool parseRow(QByteArrayView input, const WikiTableGrid& grid, int row, const TableColumns& columns,
+                         int rowNumber, Tagger::TrackMetadata& track);
+    static QString cellText(QByteArrayView html);
+    static QString cleanPageTitle(const QString& title);
+    static bool isTracklistTable(QByteArrayView attributes);
+    static QString headingName(QByteArrayView id);
+
+    Tagger::AlbumMetadata m_metadata;
+    QByteArray m_buffer;
+    QByteArrayView m_input;
+    WikiHtmlTokenizer m_tokenizer;
+
+    State m_state{State::BeforeSection};
+    qsizetype m_sectionStart{-1};
+    int m_sectionLevel{0};
+    QString m_subHeading;
+    int m_tableDepth{0};
+
+    Tagger::TrackListCandidate m_table;
+    bool m_rowOpen{false};
+    WikiTableGrid m_grid; // Byte ranges only; the cells that are used get transcoded
+};
@@ -1,15 +1,17 @@
 #include "wikipediasource.h"
+#include "wikipediaparser.h"
 #include "core/httpclient.h"
+#include "core/metadatacache.h"
 
-#include <QNetworkReply>
-#include <QRegularExpression>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QUrl>
 #include <QDebug>
 
 WikipediaSource::WikipediaSource(HttpClient* client, QObject* parent)
     : MetadataSource(client, parent)
 {
-    connect(m_httpClient, &HttpClient::requestCompleted, this, &WikipediaSource::onNetworkReply);
 }
 
 bool WikipediaSource::isValidUrl(const QString& url) const
@@ -33,371 +35,433 @@ void WikipediaSource::fetchFromUrl(const QString& url)
     cancel();
 
     m_pendingUrl = url;
+    m_progress = 0;
     emit fetchStarted();
 
-    m_currentReply = m_httpClient->get(QUrl(url));
+    // Only the soundtrack section is needed; ask the parse API for it first
+    if(pageTitle(url).isEmpty()) {
+        fetchFullPage();
+    }
+    else {
+        fetchSectionList();
+    }
 }
 
-void WikipediaSource::searchAlbum(const QString& artist, const QString& album)
+void WikipediaSource::setServerOverride(const QUrl& server)
 {
-    Q_UNUSED(artist)
-    Q_UNUSED(album)
-    emit fetchFailed(tr("Wikipedia does not support search. Please provide a URL."));
+    m_serverOverride = server;
 }
 
-void WikipediaSource::cancel()
+QUrl WikipediaSource::serverUrl(const QString& path, const QUrlQuery& query) const
 {
-    if(m_currentReply) {
-        m_currentReply->abort();
-        m_currentReply->deleteLater();
-        m_currentReply = nullptr;
+    QUrl url(m_pendingUrl);
+    url.setFragment({});
+    url.setPath(path);
+    url.setQuery(query);
+
+    if(m_serverOverride.isValid()) {
+        url.setScheme(m_serverOverride.scheme());
+        url.setHost(m_serverOverride.host());
+        url.setPort(m_serverOverride.port());
     }
-    m_pendingUrl.clear();
+    return url;
 }
 
-void WikipediaSource::onNetworkReply(QNetworkReply* reply)
+QString WikipediaSource::pageTitle(const QString& url)
 {
-    if(reply != m_currentReply) {
-        return;
-    }
-
-    m_currentReply = nullptr;
-
-    if(reply->error() != QNetworkReply::NoError) {
-        emit fetchFailed(tr("Network error: %1").arg(reply->errorString()));
-        reply->deleteLater();
-        return;
-    }
+    const QString path = QUrl(url).path(QUrl::FullyDecoded);
+    return path.startsWith(QLatin1String("/wiki/")) ? path.mid(6) : QString();
+}
 
-    QByteArray html = reply->readAll();
-    reply->deleteLater();
+void WikipediaSource::fetchSectionList()
+{
+    QUrlQuery query;
+    query.addQueryItem(QStringLiteral("action"), QStringLiteral("parse"));
+    query.addQueryItem(QStringLiteral("page"), pageTitle(m_pendingUrl));
+    query.addQueryItem(QStringLiteral("prop"), QStringLiteral("sections|revid"));
+    query.addQueryItem(QStringLiteral("redirects"), QStringLiteral("1"));
+    query.addQueryItem(QStringLiteral("format"), QStringLiteral("json"));
+    query.addQueryItem(QStringLiteral("formatversion"), QStringLiteral("2"));
+
+    m_stage = Stage::SectionList;
+    sendRequest(serverUrl(QStringLiteral("/w/api.php"), query));
+}
 
-    if(html.isEmpty()) {
-        emit fetchFailed(tr("Empty response from Wikipedia"));
-        return;
+void WikipediaSource::fetchSection(int index, qint64 revisionId)
+{
+    QUrlQuery query;
+    query.addQueryItem(QStringLiteral("action"), QStringLiteral("parse"));
+    // Pinned to the revision the section index and the cache entry refer to
+    if(revisionId > 0) {
+        query.addQueryItem(QStringLiteral("oldid"), QString::number(revisionId));
     }
-
-    emit fetchProgress(50);
-
-    Tagger::AlbumMetadata metadata = parseWikipediaPage(html, m_pendingUrl);
-
-    if(metadata.tracks.isEmpty()) {
-        emit fetchFailed(tr("No soundtrack table found on the page"));
-        return;
+    else {
+        query.addQueryItem(QStringLiteral("page"), pageTitle(m_pendingUrl));
     }
+    query.addQueryItem(QStringLiteral("prop"), QStringLiteral("text"));
+    query.addQueryItem(QStringLiteral("section"), QString::number(index));
+    query.addQueryItem(QStringLiteral("disablelimitreport"), QStringLiteral("1"));
+    query.addQueryItem(QStringLiteral("disableeditsection"), QStringLiteral("1"));
+    query.addQueryItem(QStringLiteral("redirects"), QStringLiteral("1"));
+    query.addQueryItem(QStringLiteral("format"), QStringLiteral("json"));
+    query.addQueryItem(QStringLiteral("formatversion"), QStringLiteral("2"));
+
+    m_stage = Stage::Section;
+    sendRequest(serverUrl(QStringLiteral("/w/api.php"), query));
+}
 
-    emit fetchProgress(100);
-    emit fetchCompleted(metadata);
+void WikipediaSource::fetchFullPage()
+{
+    m_stage = Stage::FullPage;
+    m_parser = std::make_shared<WikipediaParser>(m_pendingUrl);
+    m_bytesQueued = 0;
+    m_bytesReceived = 0;
+    m_bytesTotal = -1;
+
+    const QUrl page(m_pendingUrl);
+    sendRequest(serverUrl(page.path(), QUrlQuery(page)));
 }
 
-Tagger::AlbumMetadata WikipediaSource::parseWikipediaPage(const QByteArray& html, const QString& sourceUrl)
+void WikipediaSource::sendRequest(const QUrl& url)
 {
-    Tagger::AlbumMetadata metadata;
-    metadata.source = Tagger::SourceType::Wikipedia;
-    metadata.sourceUrl = sourceUrl;
-
-    QString htmlStr = QString::fromUtf8(html);
-
-    // Extract page title as album name
-    metadata.album = extractPageTitle(htmlStr);
-
-    // Find and parse soundtrack section
-    QString soundtrackSection = extractSoundtrackSection(htmlStr);
-    if(!soundtrackSection.isEmpty()) {
-        metadata.tracks = parseSoundtrackTable(soundtrackSection);
-
-        // Try to extract album artist from tracks
-        if(!metadata.tracks.isEmpty() && metadata.albumArtist.isEmpty()) {
-            // Use music director if available
-            for(const auto& track : metadata.tracks) {
-                if(!track.musicDirector.isEmpty()) {
-                    metadata.musicDirector = track.musicDirector;
-                    break;
-                }
-            }
-        }
+    m_request = m_httpClient->get(url, this);
+    connect(m_request, &HttpRequest::succeeded, this, &WikipediaSource::onResponse);
+    connect(m_request, &HttpRequest::failed, this, &WikipediaSource::onRequestFailed);
+
+    if(m_stage == Stage::FullPage) {
+        // Parse the page while it downloads; the tracklist usually ends long before the page does
+        connect(m_request, &HttpRequest::readyRead, this, &WikipediaSource::onReadyRead);
+        connect(m_request, &HttpRequest::downloadProgress, this, [this](qint64 received, qint64 total) {
+            m_bytesReceived = received;
+            m_bytesTotal = total;
+        });
     }
+}
 
-    // Set album name on all tracks
-    for(auto& track : metadata.tracks) {
-        track.album = metadata.album;
-    }
+void WikipediaSource::fallBackToFullPage(const QString& reason)
+{
+    qCDebug(httpClientLog) << "Wikipedia parse API unavailable (" << reason << "), fetching the full page";
+    fetchFullPage();
+}
 
-    qDebug() << "Parsed Wikipedia page:" << metadata.album
-             << "with" << metadata.tracks.size() << "tracks";
+void WikipediaSource::searchAlbum(const QString& artist, const QString& album)
+{
+    Q_UNUSED(artist)
+    Q_UNUSED(album)
+    emit fetchFailed(tr("Wikipedia does not support search. Please provide a URL."));
+}
 
-    return metadata;
+void WikipediaSource::cancel()
+{
+    abortRequest();
+    m_pendingUrl.clear();
+    m_pendingRevision.clear();
+    m_stage = Stage::None;
+    m_parser.reset();
+    cancelParse();
 }
 
-QString WikipediaSource::extractPageTitle(const QString& html)
+void WikipediaSource::abortRequest()
 {
-    // Look for <title> tag
-    static QRegularExpression titleRe(R"(<title>([^<]+)</title>)", QRegularExpression::CaseInsensitiveOption);
-    QRegularExpressionMatch match = titleRe.match(html);
-    if(match.hasMatch()) {
-        QString title = match.captured(1);
-        // Remove " - Wikipedia" suffix
-        title.remove(QRegularExpression(R"(\s*[-–]\s*Wikipedia.*$)", QRegularExpression::CaseInsensitiveOption));
-        // Remove "(film)" suffix
-        title.remove(QRegularExpression(R"(\s*\(film\)\s*$)", QRegularExpression::CaseInsensitiveOption));
-        return cleanWikiText(title.trimmed());
+    if(m_request) {
+        m_request->cancel();
+        m_request = nullptr;
     }
-    return QString();
 }
 
-QString WikipediaSource::extractSoundtrackSection(const QString& html)
+void WikipediaSource::onReadyRead()
 {
-    // Look for Soundtrack, Music, or Track listing section
-    // Look for any h2/h3 tag with id containing:
-    // - Soundtrack
-    // - Music
-    // - Track (with possible variations like Track_listing)
-    static QRegularExpression sectionRe(
-        R"RE(<h[23][^>]*id="(?:Soundtrack|Music|Track[^"]*)"[^>]*>.*?</h[23]>)RE",
-        QRegularExpression::CaseInsensitiveOption | QRegularExpression::DotMatchesEverythingOption
-    );
-
-    QRegularExpressionMatch sectionMatch = sectionRe.match(html);
-    if(!sectionMatch.hasMatch()) {
-        qDebug() << "No Soundtrack/Music/Track listing section found";
-        return QString();
+    if(!m_request || !m_parser) {
+        return;
     }
 
-    int sectionStart = sectionMatch.capturedEnd();
-
-    // Find the next section (next h2 or h3)
-    static QRegularExpression nextSectionRe(R"(<h[23][^>]*>)", QRegularExpression::CaseInsensitiveOption);
-    QRegularExpressionMatch nextMatch = nextSectionRe.match(html, sectionStart);
-
-    int sectionEnd = nextMatch.hasMatch() ? nextMatch.capturedStart() : html.length();
-
-    qDebug() << "Section found from" << sectionStart << "to" << sectionEnd << "(length:" << sectionEnd - sectionStart << "chars)";
-
-    QString section = html.mid(sectionStart, sectionEnd - sectionStart);
-
-    // Debug: Print section contents if needed
-    // qDebug() << "Section content snippet:" << section.left(200);
-
-    return section;
+    const QByteArray chunk = m_request->readAvailable();
+    if(!chunk.isEmpty()) {
+        queueParse(chunk, false);
+    }
 }
 
-QList<Tagger::TrackMetadata> WikipediaSource::parseSoundtrackTable(const QString& tableHtml)
+void WikipediaSource::onResponse(const HttpResponse& response)
 {
-    QList<Tagger::TrackMetadata> tracks;
-
-    // Find table element - wikitable or tracklist
-    static QRegularExpression tableRe(
-        R"(<table[^>]*class="[^"]*(?:wikitable|tracklist)[^"]*"[^>]*>(.*?)</table>)",
-        QRegularExpression::CaseInsensitiveOption | QRegularExpression::DotMatchesEverythingOption
-    );
-
-    QRegularExpressionMatch tableMatch = tableRe.match(tableHtml);
-    if(!tableMatch.hasMatch()) {
-        qDebug() << "No wikitable/tracklist found in section";
-        return tracks;
+    m_request = nullptr;
+
+    switch(m_stage) {
+        case Stage::SectionList:
+            onSectionListReply(response.body);
+            return;
+        case Stage::Section:
+            onSectionReply(response.body);
+            return;
+        case Stage::FullPage:
+            onPageReply(response.body);
+            return;
+        case Stage::None:
+            return;
     }
+}
 
-    QString tableContent = tableMatch.captured(1);
-
-    // Parse header row to detect columns
-    static QRegularExpression headerRowRe(
-        R"(<tr[^>]*>(.*?)</tr>)",
-        QRegularExpression::CaseInsensitiveOption | QRegularExpression::DotMatchesEverythingOption
-    );
-
-    static QRegularExpression headerCellRe(
-        R"(<t[hd][^>]*>(.*?)</t[hd]>)",
-        QRegularExpression::CaseInsensitiveOption | QRegularExpression::DotMatchesEverythingOption
-    );
-
-    QRegularExpressionMatchIterator rowIt = headerRowRe.globalMatch(tableContent);
-
-    TableColumns columns;
-    bool foundHeader = false;
-
-    while(rowIt.hasNext()) {
-        QRegularExpressionMatch rowMatch = rowIt.next();
-        QString rowContent = rowMatch.captured(1);
+void WikipediaSource::onRequestFailed(const HttpError& error)
+{
+    m_request = nullptr;
+
+    switch(m_stage) {
+        case Stage::SectionList:
+        case Stage::Section:
+            fallBackToFullPage(error.message);
+            return;
+        case Stage::FullPage:
+            emit fetchFailed(tr("Network error: %1").arg(error.message));
+            m_parser.reset();
+            m_stage = Stage::None;
+            return;
+        case Stage::None:
+            return;
+    }
+}
 
-        // Check if this is a header row (contains <th> tags)
-        if(rowContent.contains("<th", Qt::CaseInsensitive) && !foundHeader) {
-            QStringList headers;
-            QRegularExpressionMatchIterator cellIt = headerCellRe.globalMatch(rowContent);
-            while(cellIt.hasNext()) {
-                QRegularExpressionMatch cellMatch = cellIt.next();
-                headers.append(cleanWikiText(cellMatch.captured(1)));
+void WikipediaSource::onSectionListReply(const QByteArray& data)
+{
+    const QString anchor = QUrl(m_pendingUrl).fragment(QUrl::FullyDecoded);
+
+    startParse(
+        [data, anchor]() {
+            return findSoundtrackSection(data, anchor);
+        },
+        [this](const SectionLookup& lookup) {
+            if(lookup.index < 0) {
+                fallBackToFullPage(lookup.error);
+                return;
             }
-            columns = detectColumns(headers);
-            foundHeader = true;
-            continue;
-        }
 
-        // Data row
-        if(foundHeader && rowContent.contains("<td", Qt::CaseInsensitive)) {
-            QStringList cells;
-            QRegularExpressionMatchIterator cellIt = headerCellRe.globalMatch(rowContent);
-            while(cellIt.hasNext()) {
-                QRegularExpressionMatch cellMatch = cellIt.next();
-                cells.append(cleanWikiText(cellMatch.captured(1)));
+            m_pendingRevision.clear();
+            if(lookup.revisionId > 0) {
+                m_pendingRevision = QStringLiteral("rev:%1/parser:%2").arg(lookup.revisionId).arg(ParserVersion);
+
+                // Parsed before and the page has not been edited since
+                if(const auto cached = metadataCache()->lookup(type(), m_pendingUrl, m_pendingRevision)) {
+                    qCDebug(httpClientLog) << "Metadata cache hit for" << m_pendingUrl << m_pendingRevision;
+                    m_stage = Stage::None;
+                    reportProgress(100);
+                    emit fetchCompleted(*cached);
+                    return;
+                }
             }
 
-            if(cells.isEmpty()) {
-                continue;
+            reportProgress(10);
+            fetchSection(lookup.index, lookup.revisionId);
+        });
+}
+
+void WikipediaSource::onSectionReply(const QByteArray& data)
+{
+    reportProgress(50);
+
+    startParse(
+        [data, url = m_pendingUrl]() {
+            return parseSection(data, url);
+        },
+        [this](const SectionPage& page) {
+            if(!page.error.isEmpty()) {
+                fallBackToFullPage(page.error);
+                return;
             }
 
-            Tagger::TrackMetadata track;
-            track.trackNumber = tracks.size() + 1;
+            m_stage = Stage::None;
 
-            if(columns.numberIndex >= 0 && columns.numberIndex < cells.size()) {
-                bool ok;
-                int num = cells[columns.numberIndex].toInt(&ok);
-                if(ok) {
-                    track.trackNumber = num;
-                }
+            if(page.metadata.tracks.isEmpty()) {
+                emit fetchFailed(tr("No soundtrack table found on the page"));
+                return;
             }
 
-            if(columns.songIndex >= 0 && columns.songIndex < cells.size()) {
-                track.title = cells[columns.songIndex];
-            }
-            else if(!cells.isEmpty()) {
-                // Fallback: assume first non-number column is title
-                track.title = cells[0];
-            }
+            metadataCache()->store(type(), m_pendingUrl, m_pendingRevision, page.metadata);
 
-            if(columns.singerIndex >= 0 && columns.singerIndex < cells.size()) {
-                track.artist = cells[columns.singerIndex];
-            }
+            reportProgress(100);
+            emit fetchCompleted(page.metadata);
+        });
+}
 
-            if(columns.lyricsIndex >= 0 && columns.lyricsIndex < cells.size()) {
-                track.lyricist = cells[columns.lyricsIndex];
-            }
+WikipediaSource::SectionLookup WikipediaSource::findSoundtrackSection(const QByteArray& json, const QString& anchor)
+{
+    SectionLookup lookup;
 
-            if(columns.musicIndex >= 0 && columns.musicIndex < cells.size()) {
-                track.musicDirector = cells[columns.musicIndex];
-                if(track.composer.isEmpty()) {
-                    track.composer = track.musicDirector;
-                }
-            }
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(json, &parseError);
+    if(parseError.error != QJsonParseError::NoError) {
+        lookup.error = parseError.errorString();
+        return lookup;
+    }
 
-            if(columns.durationIndex >= 0 && columns.durationIndex < cells.size()) {
-                track.durationSeconds = parseDuration(cells[columns.durationIndex]);
-            }
+    const QJsonObject root = doc.object();
+    if(root.contains(QLatin1String("error"))) {
+        lookup.error = root.value(QLatin1String("error")).toObject().value(QLatin1String("info")).toString();
+        return lookup;
+    }
 
-            if(!track.title.isEmpty()) {
-                tracks.append(track);
-            }
+    const QJsonObject parse = root.value(QLatin1String("parse")).toObject();
+    const QJsonArray sections = parse.value(QLatin1String("sections")).toArray();
+    lookup.revisionId = parse.value(QLatin1String("revid")).toInteger();
+
+    QJsonObject match;
+    for(const QJsonValue& value : sections) {
+        const QJsonObject section = value.toObject();
+        const QString sectionAnchor = section.value(QLatin1String("anchor")).toString();
+        // An explicit #fragment in the URL wins over the heading heuristics
+        if(!anchor.isEmpty() && sectionAnchor == anchor) {
+            match = section;
+            break;
+        }
+        const int level = section.value(QLatin1String("level")).toString().toInt();
+        if(match.isEmpty() && (level == 2 || level == 3)
+           && WikipediaParser::isSoundtrackHeading(sectionAnchor.toUtf8())) {
+            match = section;
         }
     }
 
-    // Set total tracks
-    for(auto& track : tracks) {
-        track.totalTracks = tracks.size();
+    if(match.isEmpty()) {
+        lookup.error = QStringLiteral("no soundtrack section listed");
+        return lookup;
     }
 
-    qDebug() << "Parsed" << tracks.size() << "tracks from table";
-    return tracks;
+    // Sections pulled in from templates have indices like "T-1" and can't be requested on their own
+    bool ok{false};
+    const int index = match.value(QLatin1String("index")).toString().toInt(&ok);
+    if(!ok) {
+        lookup.error = QStringLiteral("soundtrack section is transcluded");
+        return lookup;
+    }
+
+    qCDebug(httpClientLog) << "Soundtrack section" << match.value(QLatin1String("line")).toString() << "has index"
+                           << index;
+    lookup.index = index;
+    return lookup;
 }
 
-WikipediaSource::TableColumns WikipediaSource::detectColumns(const QStringList& headers)
+WikipediaSource::SectionPage WikipediaSource::parseSection(const QByteArray& json, const QString& sourceUrl)
 {
-    TableColumns cols;
+    SectionPage page;
 
-    for(int i = 0; i < headers.size(); ++i) {
-        QString h = headers[i].toLower();
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(json, &parseError);
+    if(parseError.error != QJsonParseError::NoError) {
+        page.error = parseError.errorString();
+        return page;
+    }
 
-        if(h.contains("no") || h.contains("#") || h == "sr") {
-            cols.numberIndex = i;
-        }
-        else if(h.contains("song") || h.contains("title") || h.contains("track")) {
-            cols.songIndex = i;
-        }
-        else if(h.contains("singer") || h.contains("artist") || h.contains("vocals") || h.contains("performed")) {
-            cols.singerIndex = i;
-        }
-        else if(h.contains("lyric") || h.contains("written")) {
-            cols.lyricsIndex = i;
-        }
-        else if(h.contains("music") || h.contains("composer") || h.contains("composed")) {
-            cols.musicIndex = i;
-        }
-        else if(h.contains("duration") || h.contains("length") || h.contains("time")) {
-            cols.durationIndex = i;
-        }
+    const QJsonObject root = doc.object();
+    if(root.contains(QLatin1String("error"))) {
+        page.error = root.value(QLatin1String("error")).toObject().value(QLatin1String("info")).toString();
+        return page;
+    }
+
+    const QJsonObject parse = root.value(QLatin1String("parse")).toObject();
+    QJsonValue text = parse.value(QLatin1String("text"));
+    if(text.isObject()) {
+        // formatversion=1 wraps the HTML in {"*": ...}
+        text = text.toObject().value(QLatin1String("*"));
+    }
+    if(!text.isString()) {
+        page.error = QStringLiteral("no section text in reply");
+        return page;
     }
 
-    qDebug() << "Detected columns - Song:" << cols.songIndex
-             << "Singer:" << cols.singerIndex
-             << "Lyrics:" << cols.lyricsIndex
-             << "Music:" << cols.musicIndex
-             << "Duration:" << cols.durationIndex;
+    WikipediaParser parser(sourceUrl);
+    parser.setPageTitle(parse.value(QLatin1String("title")).toString());
+    parser.feed(text.toString().toUtf8());
+    parser.finish();
 
-    return cols;
+    page.metadata = parser.result();
+    return page;
 }
 
-QString WikipediaSource::cleanWikiText(const QString& text)
+void WikipediaSource::onPageReply(const QByteArray& rest)
 {
-    QString cleaned = text;
+    if(rest.isEmpty() && m_bytesQueued == 0) {
+        emit fetchFailed(tr("Empty response from Wikipedia"));
+        m_parser.reset();
+        m_stage = Stage::None;
+        return;
+    }
 
-    // Remove HTML tags
-    static QRegularExpression htmlTagRe(R"(<[^>]+>)");
-    cleaned.remove(htmlTagRe);
+    if(m_parser) {
+        queueParse(rest, true);
+    }
+}
 
-    // Remove Wikipedia citation markers [1], [2], etc.
-    static QRegularExpression citationRe(R"(\[\d+\])");
-    cleaned.remove(citationRe);
+void WikipediaSource::queueParse(const QByteArray& chunk, bool last)
+{
+    auto parser = m_parser;
 
-    // Remove [edit] links
-    static QRegularExpression editRe(R"(\[edit\])", QRegularExpression::CaseInsensitiveOption);
-    cleaned.remove(editRe);
+    auto parse = [parser, chunk, last]() {
+        parser->feed(chunk);
+        if(last) {
+            parser->finish();
+        }
 
-    // Decode HTML entities
-    cleaned.replace("&amp;", "&");
-    cleaned.replace("&lt;", "<");
-    cleaned.replace("&gt;", ">");
-    cleaned.replace("&quot;", "\"");
-    cleaned.replace("&#39;", "'");
-    cleaned.replace("&nbsp;", " ");
+        ParseStep step;
+        step.bytesParsed = parser->bytesParsed();
+        step.foundSection = parser->foundSection();
+        step.complete = parser->isComplete();
+        if(step.complete) {
+            step.metadata = parser->result();
+        }
+        return step;
+    };
 
-    // Remove quotes around titles
-    cleaned.remove(QChar('"'));
-    cleaned.remove(QChar(0x201C)); // "
-    cleaned.remove(QChar(0x201D)); // "
+    auto deliver = [this, parser](const ParseStep& step) {
+        // Results for a cancelled or superseded fetch are dropped
+        if(parser == m_parser) {
+            onParseStep(step);
+        }
+    };
 
-    // Normalize whitespace
-    cleaned = cleaned.simplified();
+    const bool first = m_bytesQueued == 0;
+    m_bytesQueued += chunk.size();
 
-    return cleaned;
+    if(first) {
+        m_parseQueue = QtConcurrent::run(parserPool(), parse).then(this, deliver);
+    }
+    else {
+        m_parseQueue = m_parseQueue.then(parserPool(), parse).then(this, deliver);
+    }
 }
 
-int WikipediaSource::parseDuration(const QString& durationStr)
+void WikipediaSource::onParseStep(const ParseStep& step)
 {
-    // Parse formats like "3:45", "3.45", "3m 45s", "225"
-    QString str = durationStr.trimmed();
-
-    // Format: M:SS or MM:SS
-    static QRegularExpression colonRe(R"((\d+):(\d+))");
-    QRegularExpressionMatch match = colonRe.match(str);
-    if(match.hasMatch()) {
-        int minutes = match.captured(1).toInt();
-        int seconds = match.captured(2).toInt();
-        return minutes * 60 + seconds;
+    if(!step.complete) {
+        if(m_bytesTotal > 0 && m_bytesQueued > 0) {
+            // Share of the page parsed so far: download progress scaled by how
+            // much of the received data the parser has caught up with
+            const double parsed = static_cast<double>(step.bytesParsed) / static_cast<double>(m_bytesQueued);
+            const double received = static_cast<double>(m_bytesReceived) / static_cast<double>(m_bytesTotal);
+            reportProgress(qMin(99, static_cast<int>(parsed * received * 100)));
+        }
+        else if(step.foundSection) {
+            reportProgress(50);
+        }
+        return;
     }
 
-    // Format: M.SS
-    static QRegularExpression dotRe(R"((\d+)\.(\d+))");
-    match = dotRe.match(str);
-    if(match.hasMatch()) {
-        int minutes = match.captured(1).toInt();
-        int seconds = match.captured(2).toInt();
-        return minutes * 60 + seconds;
+    // The tracklist has been read; the rest of the page is not needed
+    if(m_request) {
+        qCDebug(httpClientLog) << "Soundtrack section parsed after" << m_bytesQueued << "bytes, stopping download";
+        abortRequest();
     }
+    m_parser.reset();
+    m_stage = Stage::None;
 
-    // Plain seconds
-    bool ok;
-    int seconds = str.toInt(&ok);
-    if(ok) {
-        return seconds;
+    if(step.metadata.tracks.isEmpty()) {
+        emit fetchFailed(tr("No soundtrack table found on the page"));
+        return;
     }
 
-    return 0;
+    reportProgress(100);
+    emit fetchCompleted(step.metadata);
+}
+
+void WikipediaSource::reportProgress(int percent)
+{
+    if(percent > m_progress) {
+        m_progress = percent;
+        emit fetchProgress(percent);
+    }
 }
@@ -1,8 +1,16 @@
 #pragma once
 
 #include "metadatasource.h"
+#include "core/httprequest.h"
 
-class QNetworkReply;
+#include <QFuture>
+#include <QPointer>
+#include <QUrl>
+#include <QUrlQuery>
+
+#include <memory>
+
+class WikipediaParser;
 
 class WikipediaSource : public MetadataSource
 {
@@ -22,28 +30,83 @@ public:
 
     [[nodiscard]] bool isValidUrl(const QString& url) const override;
 
+    // Sends every request to this scheme/host/port instead of the article's wiki.
+    // Used to run the source against a local stand-in server.
+    void setServerOverride(const QUrl& server);
+
 private slots:
-    void onNetworkReply(QNetworkReply* reply);
+    void onReadyRead();
+    void onResponse(const HttpResponse& response);
+    void onRequestFailed(const HttpError& error);
 
 private:
-    Tagger::AlbumMetadata parseWikipediaPage(const QByteArray& html, const QString& sourceUrl);
-    QList<Tagger::TrackMetadata> parseSoundtrackTable(const QString& tableHtml);
-    QString extractSoundtrackSection(const QString& html);
-    QString extractPageTitle(const QString& html);
-    QString cleanWikiText(const QString& text);
-    int parseDuration(const QString& durationStr);
-
-    struct TableColumns
+    // Part of every metadata cache revision; bump it when parsing changes so that cached albums are parsed again
+    static constexpr int ParserVersion = 1;
+
+    enum class Stage
+    {
+        None,
+        SectionList, // action=parse&prop=sections
+        Section,     // action=parse&section=N
+        FullPage     // Rendered article, parsed while it downloads
+    };
+
+    struct SectionLookup
+    {
+        int index{-1};
+        qint64 revisionId{0}; // Page revision the section list describes, 0 if unknown
+        QString error;        // Reason to fall back to the full page
+    };
+
+    struct SectionPage
     {
-        int numberIndex{-1};
-        int songIndex{-1};
-        int singerIndex{-1};
-        int lyricsIndex{-1};
-        int musicIndex{-1};
-        int durationIndex{-1};
+        Tagger::AlbumMetadata metadata;
+        QString error; // Reason to fall back to the full page
     };
-    TableColumns detectColumns(const QStringList& headers);
 
-    QNetworkReply* m_currentReply{nullptr};
+    // Snapshot of the parser taken on the pool after each chunk
+    struct ParseStep
+    {
+        qsizetype bytesParsed{0};
+        bool foundSection{false};
+        bool complete{false};
+        Tagger::AlbumMetadata metadata; // Only set once complete
+    };
+
+    static QString pageTitle(const QString& url);
+    QUrl serverUrl(const QString& path, const QUrlQuery& query) const;
+
+    void fetchSectionList();
+    void fetchSection(int index, qint64 revisionId);
+    void fetchFullPage();
+    void fallBackToFullPage(const QString& reason);
+    // Queues url on the shared client; the outcome arrives through onResponse() or onRequestFailed()
+    void sendRequest(const QUrl& url);
+
+    void onSectionListReply(const QByteArray& data);
+    void onSectionReply(const QByteArray& data);
+    void onPageReply(const QByteArray& rest);
+
+    // Run on the parser pool
+    static SectionLookup findSoundtrackSection(const QByteArray& json, const QString& anchor);
+    static SectionPage parseSection(const QByteArray& json, const QString& sourceUrl);
+
+    void queueParse(const QByteArray& chunk, bool last);
+    void onParseStep(const ParseStep& step);
+    void reportProgress(int percent);
+    void abortRequest();
+
+    QPointer<HttpRequest> m_request;
     QString m_pendingUrl;
+    QString m_pendingRevision; // Metadata cache revision of the section being fetched
+    QUrl m_serverOverride;
+    Stage m_stage{Stage::None};
+
+    // Chunks are parsed in arrival order on the parser pool
+    std::shared_ptr<WikipediaParser> m_parser;
+    QFuture<void> m_parseQueue;
+    qint64 m_bytesQueued{0};
+    qint64 m_bytesReceived{0};
+    qint64 m_bytesTotal{-1};
+    int m_progress{0};
 };
@@ -0,0 +1,120 @@
+#include "wikitablegrid.h"
+#include "wikitokenizer.h"
+
+namespace {
+// Limits from the HTML table model
+constexpr int MaxColumnSpan = 1000;
+constexpr int MaxRowSpan = 65534;
+} // namespace
+
+void WikiTableGrid::clear()
+{
+    m_cells.clear();
+    m_rowStarts.clear();
+    m_slots.clear();
+    m_rowCount = 0;
+    m_columnCount = 0;
+}
+
+void WikiTableGrid::startRow()
+{
+    m_rowStarts.append(static_cast<int>(m_cells.size()));
+}
+
+void WikiTableGrid::addCell(qsizetype start, qsizetype size, bool header, QByteArrayView attributes)
+{
+    if(m_rowStarts.isEmpty()) {
+        startRow();
+    }
+
+    Cell cell;
+    cell.start = start;
+    cell.size = size;
+    cell.row = static_cast<int>(m_rowStarts.size()) - 1;
+    cell.rowSpan = qMin(span(attributes, "rowspan"), MaxRowSpan);
+    cell.columnSpan = qBound(1, span(attributes, "colspan"), MaxColumnSpan);
+    cell.header = header;
+    m_cells.append(cell);
+}
+
+void WikiTableGrid::build()
+{
+    m_rowCount = static_cast<int>(m_rowStarts.size());
+
+    // First pass: place each cell in the first free column of its row.
+    // busyUntil[column] is the first row not yet covered by a cell above.
+    QList<int> busyUntil;
+    for(int row = 0; row < m_rowCount; ++row) {
+        const int first = m_rowStarts[row];
+        const int last = row + 1 < m_rowCount ? m_rowStarts[row + 1] : static_cast<int>(m_cells.size());
+
+        int column{0};
+        for(int index = first; index < last; ++index) {
+            Cell& cell = m_cells[index];
+            while(column < busyUntil.size() && busyUntil[column] > row) {
+                ++column;
+            }
+
+            const int rowsLeft = m_rowCount - row;
+            cell.column = column;
+            cell.rowSpan = cell.rowSpan == 0 ? rowsLeft : qMin(cell.rowSpan, rowsLeft);
+
+            if(busyUntil.size() < column + cell.columnSpan) {
+                busyUntil.resize(column + cell.columnSpan, 0);
+            }
+            for(int c = column; c < column + cell.columnSpan; ++c) {
+                busyUntil[c] = row + cell.rowSpan;
+            }
+            column += cell.columnSpan;
+        }
+    }
+    m_columnCount = static_cast<int>(busyUntil.size());
+
+    // Second pass: fill the matrix. Overlapping cells are a table model
+    // error; the slot keeps the cell that was placed first.
+    m_slots.fill(-1, m_rowCount * m_columnCount);
+    for(int index = 0; index < m_cells.size(); ++index) {
+        const Cell& cell = m_cells[index];
+        for(int row = cell.row; row < cell.row + cell.rowSpan; ++row) {
+            int* slot = m_slots.data() + row * m_columnCount + cell.column;
+            for(int c = 0; c < cell.columnSpan; ++c, ++slot) {
+                if(*slot < 0) {
+                    *slot = index;
+                }
+            }
+        }
+    }
+}
+
+bool WikiTableGrid::rowStartsCell(int row, bool header) const
+{
+    if(row < 0 || row >= m_rowCount) {
+        return false;
+    }
+    const int first = m_rowStarts[row];
+    const int last = row + 1 < m_rowCount ? m_rowStarts[row + 1] : static_cast<int>(m_cells.size());
+    for(int index = first; index < last; ++index) {
+        if(m_cells[index].header == header) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int WikiTableGrid::span(QByteArrayView attributes, QByteArrayView name)
+{
+    // Leading digits only, as browsers read them ("2;" or "3px" still count)
+    const QByteArrayView value = WikiHtmlTokenizer::attribute(attributes, name).trimmed();
+    if(value.isEmpty() || value[0] < '0' || value[0] > '9') {
+        return 1;
+    }
+
+    int result{0};
+    for(const char c : value) {
+        if(c < '0' || c > '9') {
+            break;
+        }
+        result = qMin(result * 10 + (c - '0'), MaxRowSpan + 1);
+    }
+    return result;
+}
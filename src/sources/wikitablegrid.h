@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QByteArrayView>
+#include <QList>
+
+// Row/column matrix of one HTML table with rowspan and colspan expanded.
+// Cells are collected row by row while the table is tokenized and laid
+// out once by build() using the HTML table model, so that every slot
+// knows which cell covers it. A cell spanning several slots is stored
+// once; at() returns the same cell for each slot it covers.
+class WikiTableGrid
+{
+public:
+    struct Cell
+    {
+        qsizetype start{0}; // Byte range of the cell's inner HTML in the page
+        qsizetype size{0};
+        int row{0};         // Top-left slot of the cell
+        int column{0};
+        int rowSpan{1};
+        int columnSpan{1};
+        bool header{false}; // Cell is a <th>
+    };
+
+    void clear();
+
+    // Cells added after this belong to a new row
+    void startRow();
+    void addCell(qsizetype start, qsizetype size, bool header, QByteArrayView attributes);
+
+    // Lays out the collected cells; rows spanning past the last row are cut off there
+    void build();
+
+    [[nodiscard]] int rowCount() const { return m_rowCount; }
+    [[nodiscard]] int columnCount() const { return m_columnCount; }
+
+    // Cell covering a slot, or nullptr where no cell reaches
+    [[nodiscard]] const Cell* at(int row, int column) const
+    {
+        if(row < 0 || row >= m_rowCount || column < 0 || column >= m_columnCount) {
+            return nullptr;
+        }
+        const int index = m_slots[row * m_columnCount + column];
+        return index < 0 ? nullptr : &m_cells[index];
+    }
+
+    // True if a cell of the given kind begins in this row (rather than reaching into it from above)
+    [[nodiscard]] bool rowStartsCell(int row, bool header) const;
+
+    // Value of a rowspan or colspan attribute; 0 for rowspan means "to the end of the table"
+    static int span(QByteArrayView attributes, QByteArrayView name);
+
+private:
+    QList<Cell> m_cells;
+    QList<int> m_rowStarts; // Index of each row's first cell in m_cells
+    QList<int> m_slots;     // m_rowCount × m_columnCount indices into m_cells, -1 for holes
+    int m_rowCount{0};
+    int m_columnCount{0};
+};
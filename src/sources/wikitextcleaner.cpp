@@ -0,0 +1,338 @@
+#include "wikitextcleaner.h"
+#include "htmlentities.h"
+
+#include <QVarLengthArray>
+
+namespace {
+constexpr char32_t ReplacementCharacter = 0xFFFD;
+constexpr char32_t InvalidSequence = 0xFFFFFFFF;
+
+// Numeric references to C1 controls mean the windows-1252 character
+// (0 where the code point is kept as is)
+constexpr char16_t Windows1252[32] = {
+    0x20AC, 0,      0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160,
+    0x2039, 0x0152, 0,      0x017D, 0,      0,      0x2018, 0x2019, 0x201C, 0x201D, 0x2022,
+    0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0,      0x017E, 0x0178};
+
+bool isAsciiDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool isAsciiAlnum(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || isAsciiDigit(c);
+}
+
+int hexValue(char c)
+{
+    if(isAsciiDigit(c)) {
+        return c - '0';
+    }
+    if(c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if(c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Same set as QChar::isSpace(), which QString::simplified() used
+bool isSpace(char32_t cp)
+{
+    return (cp >= 0x09 && cp <= 0x0D) || cp == 0x20 || cp == 0x85 || cp == 0xA0 || cp == 0x1680
+        || (cp >= 0x2000 && cp <= 0x200A) || cp == 0x2028 || cp == 0x2029 || cp == 0x202F || cp == 0x205F
+        || cp == 0x3000;
+}
+
+bool isQuote(char32_t cp)
+{
+    return cp == '"' || cp == 0x201C || cp == 0x201D;
+}
+
+// Decodes the UTF-8 sequence at pos; length is set even for invalid input
+char32_t decodeUtf8(QByteArrayView text, qsizetype pos, qsizetype& length)
+{
+    const auto lead = static_cast<unsigned char>(text[pos]);
+    length = 1;
+    if(lead < 0x80) {
+        return lead;
+    }
+
+    int extra{0};
+    char32_t cp{0};
+    if(lead >= 0xC2 && lead <= 0xDF) {
+        extra = 1;
+        cp = lead & 0x1F;
+    }
+    else if(lead >= 0xE0 && lead <= 0xEF) {
+        extra = 2;
+        cp = lead & 0x0F;
+    }
+    else if(lead >= 0xF0 && lead <= 0xF4) {
+        extra = 3;
+        cp = lead & 0x07;
+    }
+    else {
+        return InvalidSequence;
+    }
+
+    if(pos + extra >= text.size()) {
+        return InvalidSequence;
+    }
+    for(int i = 1; i <= extra; ++i) {
+        const auto byte = static_cast<unsigned char>(text[pos + i]);
+        if((byte & 0xC0) != 0x80) {
+            return InvalidSequence;
+        }
+        cp = (cp << 6) | (byte & 0x3F);
+    }
+    length = extra + 1;
+    return cp;
+}
+
+class TextWriter
+{
+public:
+    explicit TextWriter(qsizetype capacity)
+    {
+        m_out.reserve(capacity);
+    }
+
+    // Raw UTF-8 bytes of one character that is neither space nor quote
+    void append(const char* utf8, qsizetype size)
+    {
+        if(m_pendingSpace) {
+            m_out.append(' ');
+            m_pendingSpace = false;
+        }
+        m_out.append(utf8, size);
+        if(size == 1 && *utf8 == ']') {
+            dropMarker();
+        }
+    }
+
+    void appendCodePoint(char32_t cp)
+    {
+        if(isSpace(cp)) {
+            space();
+            return;
+        }
+        if(isQuote(cp)) {
+            return;
+        }
+
+        char utf8[4];
+        qsizetype size{0};
+        if(cp < 0x80) {
+            utf8[size++] = static_cast<char>(cp);
+        }
+        else if(cp < 0x800) {
+            utf8[size++] = static_cast<char>(0xC0 | (cp >> 6));
+            utf8[size++] = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else if(cp < 0x10000) {
+            utf8[size++] = static_cast<char>(0xE0 | (cp >> 12));
+            utf8[size++] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            utf8[size++] = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else {
+            utf8[size++] = static_cast<char>(0xF0 | (cp >> 18));
+            utf8[size++] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            utf8[size++] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            utf8[size++] = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        append(utf8, size);
+    }
+
+    // Replacement text of a named reference, one or two code points
+    void appendUtf8(QByteArrayView utf8)
+    {
+        qsizetype pos{0};
+        while(pos < utf8.size()) {
+            qsizetype length{0};
+            appendCodePoint(decodeUtf8(utf8, pos, length));
+            pos += length;
+        }
+    }
+
+    void space()
+    {
+        // Leading whitespace is dropped, inner runs become one space
+        if(!m_out.isEmpty()) {
+            m_pendingSpace = true;
+        }
+    }
+
+    [[nodiscard]] QString toString() const
+    {
+        return QString::fromUtf8(m_out.constData(), m_out.size());
+    }
+
+private:
+    // Called after a ']': removes a trailing [123] or [edit]
+    void dropMarker()
+    {
+        const qsizetype close = m_out.size() - 1;
+        qsizetype open = close - 1;
+        while(open >= 0 && m_out[open] != '[') {
+            --open;
+        }
+        if(open < 0) {
+            return;
+        }
+
+        const QByteArrayView inner(m_out.constData() + open + 1, close - open - 1);
+        bool citation = !inner.isEmpty();
+        for(const char c : inner) {
+            citation &= isAsciiDigit(c);
+        }
+        if(!citation && inner.compare("edit", Qt::CaseInsensitive) != 0) {
+            return;
+        }
+
+        m_out.resize(open);
+        if(!m_out.isEmpty() && m_out.back() == ' ') {
+            m_out.resize(m_out.size() - 1);
+            m_pendingSpace = true;
+        }
+    }
+
+    QVarLengthArray<char, 256> m_out;
+    bool m_pendingSpace{false};
+};
+
+// Decodes "&#...;" at pos (pointing at '&'); returns the number of bytes used or 0
+qsizetype decodeNumericReference(QByteArrayView text, qsizetype pos, TextWriter& out)
+{
+    const qsizetype size = text.size();
+    qsizetype i = pos + 2;
+    const bool hex = i < size && (text[i] == 'x' || text[i] == 'X');
+    if(hex) {
+        ++i;
+    }
+
+    const qsizetype digitsStart = i;
+    char32_t cp{0};
+    while(i < size) {
+        const int digit = hex ? hexValue(text[i]) : (isAsciiDigit(text[i]) ? text[i] - '0' : -1);
+        if(digit < 0) {
+            break;
+        }
+        // Saturate instead of overflowing; anything this large is invalid anyway
+        cp = cp > 0x10FFFF ? cp : cp * (hex ? 16 : 10) + static_cast<char32_t>(digit);
+        ++i;
+    }
+    if(i == digitsStart) {
+        return 0;
+    }
+    if(i < size && text[i] == ';') {
+        ++i;
+    }
+
+    if(cp == 0 || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        cp = ReplacementCharacter;
+    }
+    else if(cp >= 0x80 && cp <= 0x9F && Windows1252[cp - 0x80] != 0) {
+        cp = Windows1252[cp - 0x80];
+    }
+
+    out.appendCodePoint(cp);
+    return i - pos;
+}
+
+// Decodes "&name;" (or a legacy "&name") at pos; returns the number of bytes used or 0
+qsizetype decodeNamedReference(QByteArrayView text, qsizetype pos, TextWriter& out)
+{
+    // The longest reference name is 31 characters plus ';'
+    constexpr qsizetype MaxNameLength = 32;
+
+    const qsizetype nameStart = pos + 1;
+    qsizetype i = nameStart;
+    while(i < text.size() && i - nameStart < MaxNameLength && isAsciiAlnum(text[i])) {
+        ++i;
+    }
+    if(i == nameStart) {
+        return 0;
+    }
+
+    if(i < text.size() && text[i] == ';') {
+        const QByteArrayView utf8 = HtmlEntities::lookup(text.sliced(nameStart, i + 1 - nameStart));
+        if(!utf8.isEmpty()) {
+            out.appendUtf8(utf8);
+            return i + 1 - pos;
+        }
+    }
+
+    QByteArrayView utf8;
+    const qsizetype length = HtmlEntities::matchLegacy(text.sliced(nameStart, i - nameStart), utf8);
+    if(length > 0) {
+        out.appendUtf8(utf8);
+        return length + 1;
+    }
+    return 0;
+}
+} // namespace
+
+QString WikiTextCleaner::clean(QByteArrayView html)
+{
+    // Output never needs much more room than the input: references shrink
+    // and only a handful of them grow by one byte
+    TextWriter out(html.size() + 16);
+
+    const qsizetype size = html.size();
+    qsizetype pos{0};
+
+    while(pos < size) {
+        const char c = html[pos];
+
+        if(c == '<') {
+            // Same rule as the old <[^>]+> pattern: "<>" and an unclosed '<' are text
+            const qsizetype gt = html.indexOf('>', pos + 1);
+            if(gt > pos + 1) {
+                pos = gt + 1;
+                continue;
+            }
+            out.append(&c, 1);
+            ++pos;
+            continue;
+        }
+
+        if(c == '&' && pos + 1 < size) {
+            const qsizetype used = html[pos + 1] == '#' ? decodeNumericReference(html, pos, out)
+                                                         : decodeNamedReference(html, pos, out);
+            if(used > 0) {
+                pos += used;
+                continue;
+            }
+            out.append(&c, 1);
+            ++pos;
+            continue;
+        }
+
+        if(static_cast<unsigned char>(c) < 0x80) {
+            if(isSpace(static_cast<char32_t>(c))) {
+                out.space();
+            }
+            else if(c != '"') {
+                out.append(&c, 1);
+            }
+            ++pos;
+            continue;
+        }
+
+        qsizetype length{0};
+        const char32_t cp = decodeUtf8(html, pos, length);
+        if(cp == InvalidSequence || (!isSpace(cp) && !isQuote(cp))) {
+            // Invalid bytes are passed on for fromUtf8() to replace
+            out.append(html.data() + pos, length);
+        }
+        else {
+            out.appendCodePoint(cp);
+        }
+        pos += length;
+    }
+
+    return out.toString();
+}
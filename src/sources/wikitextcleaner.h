@@ -0,0 +1,18 @@
+#pragma once
+
+#include <QByteArrayView>
+#include <QString>
+
+// Turns the inner HTML of a table cell (or a page title) into plain text
+// in a single pass over the UTF-8 input:
+//   - drops tags, citation markers like [12] and [edit] links
+//   - decodes all HTML5 named and numeric character references
+//   - removes straight and curly double quotes around titles
+//   - collapses whitespace runs to one space and trims the ends
+// Everything is written to one preallocated buffer and transcoded to
+// QString once at the end.
+class WikiTextCleaner
+{
+public:
+    static QString clean(QByteArrayView html);
+};
@@ -0,0 +1,378 @@
+#include "wikitokenizer.h"
+
+#include <cstring>
+
+namespace {
+bool isAsciiAlnum(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+char toLowerAscii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+// Compares against a lowercase ASCII literal
+bool equalsIgnoreCase(QByteArrayView text, QByteArrayView lower)
+{
+    if(text.size() != lower.size()) {
+        return false;
+    }
+    for(qsizetype i = 0; i < text.size(); ++i) {
+        if(toLowerAscii(text[i]) != lower[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+WikiHtmlTokenizer::WikiHtmlTokenizer(QByteArrayView html, bool complete)
+    : m_html(html)
+    , m_complete(complete)
+{
+    m_cells.resize(1);
+}
+
+void WikiHtmlTokenizer::setInput(QByteArrayView html, bool complete)
+{
+    m_html = html;
+    m_complete = complete;
+}
+
+bool WikiHtmlTokenizer::needMore(qsizetype tagStart)
+{
+    // A construct that runs into the end of a partial input is read again,
+    // from its '<', once more data has arrived
+    if(m_complete) {
+        return false;
+    }
+    m_pos = tagStart;
+    return true;
+}
+
+WikiHtmlTokenizer::Tag WikiHtmlTokenizer::classify(QByteArrayView name)
+{
+    switch(name.size()) {
+        case 2:
+            if(equalsIgnoreCase(name, "td")) return Tag::DataCell;
+            if(equalsIgnoreCase(name, "th")) return Tag::HeaderCell;
+            if(equalsIgnoreCase(name, "tr")) return Tag::Row;
+            if(equalsIgnoreCase(name, "h2")) return Tag::H2;
+            if(equalsIgnoreCase(name, "h3")) return Tag::H3;
+            break;
+        case 5:
+            if(equalsIgnoreCase(name, "table")) return Tag::Table;
+            if(equalsIgnoreCase(name, "title")) return Tag::Title;
+            if(equalsIgnoreCase(name, "style")) return Tag::Style;
+            break;
+        case 6:
+            if(equalsIgnoreCase(name, "script")) return Tag::Script;
+            break;
+        case 7:
+            if(equalsIgnoreCase(name, "caption")) return Tag::Caption;
+            break;
+        default:
+            break;
+    }
+    return Tag::Other;
+}
+
+qsizetype WikiHtmlTokenizer::findTagEnd(qsizetype from) const
+{
+    // Quoted attribute values may contain '>'
+    const qsizetype size = m_html.size();
+    qsizetype pos = from;
+    while(pos < size) {
+        const char c = m_html[pos];
+        if(c == '>') {
+            return pos;
+        }
+        if(c == '=') {
+            ++pos;
+            while(pos < size && isSpace(m_html[pos])) {
+                ++pos;
+            }
+            if(pos < size && (m_html[pos] == '"' || m_html[pos] == '\'')) {
+                const qsizetype close = m_html.indexOf(m_html[pos], pos + 1);
+                if(close < 0) {
+                    return size;
+                }
+                pos = close + 1;
+            }
+            continue;
+        }
+        ++pos;
+    }
+    return size;
+}
+
+qsizetype WikiHtmlTokenizer::findClosingTag(qsizetype from, QByteArrayView name) const
+{
+    const qsizetype size = m_html.size();
+    qsizetype pos = from;
+    while((pos = m_html.indexOf("</", pos)) >= 0) {
+        const qsizetype nameStart = pos + 2;
+        const qsizetype nameEnd = nameStart + name.size();
+        if(nameEnd <= size && equalsIgnoreCase(m_html.sliced(nameStart, name.size()), name)
+           && ((nameEnd == size && m_complete) || (nameEnd < size && !isAsciiAlnum(m_html[nameEnd])))) {
+            return pos;
+        }
+        pos = nameStart;
+    }
+    return size;
+}
+
+bool WikiHtmlTokenizer::closeCell(Token& token, qsizetype end)
+{
+    OpenCell& cell = m_cells[m_depth];
+    if(!cell.open) {
+        return false;
+    }
+
+    token.type = TokenType::Cell;
+    token.text = m_html.sliced(cell.start, end - cell.start);
+    token.attributes = m_html.sliced(cell.attributesStart, cell.attributesSize);
+    token.header = cell.header;
+    token.depth = m_depth;
+    cell.open = false;
+    return true;
+}
+
+WikiHtmlTokenizer::Token WikiHtmlTokenizer::next()
+{
+    const char* data = m_html.data();
+    const qsizetype size = m_html.size();
+
+    while(m_pos < size) {
+        const auto* lt = static_cast<const char*>(std::memchr(data + m_pos, '<', static_cast<size_t>(size - m_pos)));
+        if(!lt) {
+            m_pos = size;
+            break;
+        }
+
+        const qsizetype tagStart = lt - data;
+        qsizetype pos = tagStart + 1;
+        if(pos >= size) {
+            if(needMore(tagStart)) {
+                return {};
+            }
+            m_pos = size;
+            break;
+        }
+
+        // Comments, doctype and processing instructions
+        if(data[pos] == '!' || data[pos] == '?') {
+            if(size - pos < 3 && needMore(tagStart)) {
+                return {};
+            }
+            const bool comment = m_html.sliced(pos).startsWith("!--");
+            const qsizetype end = comment ? m_html.indexOf("-->", pos + 3) : m_html.indexOf('>', pos);
+            if(end < 0 && needMore(tagStart)) {
+                return {};
+            }
+            m_pos = end < 0 ? size : end + (comment ? 3 : 1);
+            continue;
+        }
+
+        const bool closing = data[pos] == '/';
+        if(closing) {
+            ++pos;
+        }
+
+        const qsizetype nameStart = pos;
+        while(pos < size && isAsciiAlnum(data[pos])) {
+            ++pos;
+        }
+        if(pos == size && needMore(tagStart)) {
+            return {};
+        }
+        if(pos == nameStart) {
+            // Stray '<' in text
+            m_pos = pos;
+            continue;
+        }
+
+        const Tag tag = classify(m_html.sliced(nameStart, pos - nameStart));
+        const qsizetype tagEnd = findTagEnd(pos);
+        if(tagEnd == size && needMore(tagStart)) {
+            return {};
+        }
+        const QByteArrayView attributes = m_html.sliced(pos, tagEnd - pos);
+        m_pos = tagEnd < size ? tagEnd + 1 : size;
+
+        Token token;
+        token.offset = tagStart;
+        token.depth = m_depth;
+
+        switch(tag) {
+            case Tag::Other:
+                break;
+
+            case Tag::Script:
+            case Tag::Style:
+                // Raw text elements: skip straight to the closing tag
+                if(!closing) {
+                    const qsizetype end = findClosingTag(m_pos, tag == Tag::Script ? "script" : "style");
+                    if(end == size && needMore(tagStart)) {
+                        return {};
+                    }
+                    m_pos = end;
+                }
+                break;
+
+            case Tag::Title:
+                if(!closing) {
+                    const qsizetype end = findClosingTag(m_pos, "title");
+                    if(end == size && needMore(tagStart)) {
+                        return {};
+                    }
+                    token.type = TokenType::Title;
+                    token.text = m_html.sliced(m_pos, end - m_pos);
+                    m_pos = end;
+                    return token;
+                }
+                break;
+
+            case Tag::H2:
+            case Tag::H3:
+                if(!closing) {
+                    token.type = TokenType::Heading;
+                    token.level = tag == Tag::H2 ? 2 : 3;
+                    token.attributes = attributes;
+                    return token;
+                }
+                break;
+
+            case Tag::Table:
+                if(!closing) {
+                    ++m_depth;
+                    if(m_cells.size() <= m_depth) {
+                        m_cells.resize(m_depth + 1);
+                    }
+                    m_cells[m_depth] = {};
+                    token.type = TokenType::TableStart;
+                    token.depth = m_depth;
+                    token.attributes = attributes;
+                    return token;
+                }
+                if(m_depth == 0) {
+                    break;
+                }
+                // An unclosed cell ends with its table; re-read the tag afterwards
+                if(closeCell(token, tagStart)) {
+                    m_pos = tagStart;
+                    return token;
+                }
+                token.type = TokenType::TableEnd;
+                --m_depth;
+                return token;
+
+            case Tag::Caption:
+                if(!closing && m_depth > 0) {
+                    const qsizetype end = findClosingTag(m_pos, "caption");
+                    if(end == size && needMore(tagStart)) {
+                        return {};
+                    }
+                    token.type = TokenType::Caption;
+                    token.text = m_html.sliced(m_pos, end - m_pos);
+                    m_pos = end;
+                    return token;
+                }
+                break;
+
+            case Tag::Row:
+                if(m_depth == 0) {
+                    break;
+                }
+                if(closeCell(token, tagStart)) {
+                    m_pos = tagStart;
+                    return token;
+                }
+                token.type = closing ? TokenType::RowEnd : TokenType::RowStart;
+                if(!closing) {
+                    token.attributes = attributes;
+                }
+                return token;
+
+            case Tag::DataCell:
+            case Tag::HeaderCell:
+                if(m_depth == 0) {
+                    break;
+                }
+                if(closing) {
+                    if(closeCell(token, tagStart)) {
+                        return token;
+                    }
+                    break;
+                }
+                // A new cell implicitly closes the previous one
+                if(closeCell(token, tagStart)) {
+                    m_pos = tagStart;
+                    return token;
+                }
+                m_cells[m_depth] = {true, tag == Tag::HeaderCell, m_pos, pos, attributes.size()};
+                break;
+        }
+    }
+
+    return {};
+}
+
+QByteArrayView WikiHtmlTokenizer::attribute(QByteArrayView attributes, QByteArrayView name)
+{
+    const qsizetype size = attributes.size();
+    qsizetype pos = 0;
+
+    while(pos < size) {
+        while(pos < size && (isSpace(attributes[pos]) || attributes[pos] == '/')) {
+            ++pos;
+        }
+
+        const qsizetype nameStart = pos;
+        while(pos < size && !isSpace(attributes[pos]) && attributes[pos] != '=' && attributes[pos] != '/') {
+            ++pos;
+        }
+        const QByteArrayView attrName = attributes.sliced(nameStart, pos - nameStart);
+
+        while(pos < size && isSpace(attributes[pos])) {
+            ++pos;
+        }
+
+        QByteArrayView value;
+        if(pos < size && attributes[pos] == '=') {
+            ++pos;
+            while(pos < size && isSpace(attributes[pos])) {
+                ++pos;
+            }
+            if(pos < size && (attributes[pos] == '"' || attributes[pos] == '\'')) {
+                const char quote = attributes[pos++];
+                qsizetype end = attributes.indexOf(quote, pos);
+                if(end < 0) {
+                    end = size;
+                }
+                value = attributes.sliced(pos, end - pos);
+                pos = end + 1;
+            }
+            else {
+                const qsizetype valueStart = pos;
+                while(pos < size && !isSpace(attributes[pos])) {
+                    ++pos;
+                }
+                value = attributes.sliced(valueStart, pos - valueStart);
+            }
+        }
+
+        if(!attrName.isEmpty() && equalsIgnoreCase(attrName, name)) {
+            return value;
+        }
+    }
+
+    return {};
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <QByteArrayView>
+#include <QVarLengthArray>
+
+// Forward-only tokenizer over raw Wikipedia article HTML.
+// Walks the buffer exactly once and only reports the structure the
+// soundtrack parser needs: the page title, h2/h3 headings, tables with
+// their captions, rows and cells. Everything else (scripts, styles, comments, inline markup)
+// is skipped without being copied.
+//
+// The input may be handed over in growing prefixes while a page is still
+// downloading: with an incomplete input, next() stops in front of any tag
+// that is cut off and returns End until setInput() provides more bytes.
+class WikiHtmlTokenizer
+{
+public:
+    enum class TokenType
+    {
+        Title,
+        Heading,
+        TableStart,
+        TableEnd,
+        RowStart,
+        RowEnd,
+        Cell,
+        Caption,
+        End
+    };
+
+    struct Token
+    {
+        TokenType type{TokenType::End};
+        QByteArrayView text;       // Title text or raw inner HTML of a cell or caption
+        QByteArrayView attributes; // Raw attribute string of the opening tag
+        qsizetype offset{0};       // Byte offset of the tag in the input
+        int level{0};              // Heading level (2 or 3)
+        int depth{0};              // Table nesting depth (1 = outermost table)
+        bool header{false};        // Cell is a <th>
+    };
+
+    explicit WikiHtmlTokenizer(QByteArrayView html = {}, bool complete = true);
+
+    // Replaces the input with a longer version of the same document.
+    // Views returned by earlier tokens refer to the old buffer.
+    void setInput(QByteArrayView html, bool complete);
+
+    Token next();
+
+    [[nodiscard]] qsizetype position() const { return m_pos; }
+
+    // Returns the (unquoted) value of an attribute inside a raw attribute string
+    static QByteArrayView attribute(QByteArrayView attributes, QByteArrayView name);
+
+private:
+    enum class Tag
+    {
+        Other,
+        Title,
+        H2,
+        H3,
+        Table,
+        Caption,
+        Row,
+        DataCell,
+        HeaderCell,
+        Script,
+        Style
+    };
+
+    struct OpenCell
+    {
+        bool open{false};
+        bool header{false};
+        qsizetype start{0};
+        qsizetype attributesStart{0};
+        qsizetype attributesSize{0};
+    };
+
+    static Tag classify(QByteArrayView name);
+    qsizetype findTagEnd(qsizetype from) const;
+    qsizetype findClosingTag(qsizetype from, QByteArrayView name) const;
+    bool closeCell(Token& token, qsizetype end);
+    bool needMore(qsizetype tagStart);
+
+    QByteArrayView m_html;
+    bool m_complete{true};
+    qsizetype m_pos{0};
+    int m_depth{0};
+    QVarLengthArray<OpenCell, 4> m_cells; // One slot per table depth
+};
@@ -42,6 +42,8 @@ void TaggerPlugin::initialise(const Fooyin::GuiPluginContext& context)
 {
     // Initialize tagging manager
     m_manager = new TaggingManager(this);
+    m_manager->setConfidenceThreshold(m_settings->value<TaggerSettings::ConfidenceThreshold>() / 100.0);
+    m_manager->setDurationTolerance(m_settings->value<TaggerSettings::DurationTolerance>());
 
     // Store track selection controller
     m_trackSelection = context.trackSelection;
@@ -1,5 +1,6 @@
 #include "taggerwidget.h"
 #include "core/taggingmanager.h"
+#include "models/albummetadata.h"
 #include "settings/taggersettings.h"
 #include "ui/trackmatchdialog.h"
 
@@ -23,6 +24,14 @@
 #include <QRadioButton>
 #include <QTableWidget>
 #include <QVBoxLayout>
+#include <QDebug>
+
+#include <utility>
+
+namespace {
+// Releases of one release group whose tracks are fetched on their own before settling for another
+constexpr int MaxReleaseFetches = 3;
+} // namespace
 
 TaggerWidget::TaggerWidget(TaggingManager* manager, Fooyin::SettingsManager* settings, QWidget* parent)
     : FyWidget(parent)
@@ -238,8 +247,11 @@ void TaggerWidget::setupUI()
 void TaggerWidget::loadTracks(const Fooyin::TrackList& tracks)
 {
     m_tracks = tracks;
+    m_features = TaggingManager::trackFeatures(tracks);
     m_fetchedMetadata = Tagger::AlbumMetadata();
     m_matchResults.clear();
+    // Lets searches guess which results to fetch ahead
+    m_manager->setLocalTrackCount(static_cast<int>(tracks.size()));
 
     // Try to pre-fill artist/album from first track
     if(!tracks.empty()) {
@@ -326,15 +338,72 @@ void TaggerWidget::onSearchResultDoubleClicked(int row)
     m_manager->fetchFromUrl(Tagger::SourceType::MusicBrainz, selected.releaseId);
 }
 
-void TaggerWidget::onFetchCompleted(const Tagger::AlbumMetadata& metadata)
+void TaggerWidget::onFetchCompleted(const Tagger::AlbumMetadata& fetched)
 {
+    if(m_releaseGroup && fetched.releaseId == m_pendingReleaseId) {
+        // Tracks of the release that looked like the best fit, fetched on their own
+        Tagger::AlbumMetadata group = *std::exchange(m_releaseGroup, std::nullopt);
+        for(auto& candidate : group.candidates) {
+            if(candidate.releaseId == fetched.releaseId) {
+                candidate.tracks = fetched.tracks;
+            }
+        }
+        useFetchedAlbum(std::move(group));
+        return;
+    }
+
+    m_releaseGroup.reset();
+    m_releaseFetches = 0;
+    useFetchedAlbum(fetched);
+}
+
+void TaggerWidget::useFetchedAlbum(Tagger::AlbumMetadata metadata)
+{
+    // Pages listing several versions or discs, and the releases of a release group:
+    // use the tracklist that fits the loaded tracks
+    int candidate{-1};
+    if((metadata.candidates.size() > 1 && !m_tracks.empty())
+       || (metadata.tracks.isEmpty() && !metadata.candidates.isEmpty())) {
+        const QList<int>& durations = m_features.durations();
+        // Tracks per disc, if every file says which disc it is on
+        QList<int> discs;
+        bool discsKnown{true};
+        for(const int disc : m_features.discNumbers()) {
+            discsKnown = discsKnown && disc > 0;
+            if(discsKnown) {
+                if(discs.size() < disc) {
+                    discs.resize(disc);
+                }
+                ++discs[disc - 1];
+            }
+        }
+        if(!discsKnown) {
+            discs.clear();
+        }
+
+        candidate = Tagger::bestTrackListCandidate(metadata, durations, discs);
+        if(metadata.candidates[candidate].tracks.isEmpty()) {
+            if(fetchCandidateRelease(metadata, candidate)) {
+                return;
+            }
+            // Out of fetches: the best of the releases whose tracks are known
+            metadata.candidates.removeIf([](const auto& release) { return release.tracks.isEmpty(); });
+            if(metadata.candidates.isEmpty()) {
+                onFetchFailed(tr("No release of this release group lists its tracks"));
+                return;
+            }
+            candidate = Tagger::bestTrackListCandidate(metadata, durations, discs);
+        }
+        Tagger::useTrackListCandidate(metadata, candidate);
+    }
+
     m_fetchedMetadata = metadata;
     setUIEnabled(true);
     m_progressBar->setRange(0, 100);
     m_progressBar->setValue(100);
 
     // Perform matching
-    m_matchResults = m_manager->matchTracks(m_tracks, metadata);
+    m_matchResults = m_manager->matchTracks(m_tracks, m_features, metadata);
 
     updateMatchPreview();
 
@@ -345,17 +414,55 @@ void TaggerWidget::onFetchCompleted(const Tagger::AlbumMetadata& metadata)
         }
     }
 
-    updateStatus(tr("Fetched %1 tracks, matched %2/%3")
-                     .arg(metadata.tracks.size())
-                     .arg(matchedCount)
-                     .arg(m_tracks.size()));
+    QString status = tr("Fetched %1 tracks, matched %2/%3")
+                         .arg(metadata.tracks.size())
+                         .arg(matchedCount)
+                         .arg(m_tracks.size());
+    if(candidate >= 0) {
+        const QString name = metadata.candidates[candidate].name;
+        status += QStringLiteral(" - ")
+                + tr("using tracklist %1 of %2%3")
+                      .arg(candidate + 1)
+                      .arg(metadata.candidates.size())
+                      .arg(name.isEmpty() ? QString() : QStringLiteral(" (%1)").arg(name));
+    }
+    updateStatus(status);
 
     m_applyButton->setEnabled(matchedCount > 0);
     m_overrideMatchesButton->setEnabled(!metadata.tracks.isEmpty() && !m_tracks.empty());
 }
 
+bool TaggerWidget::fetchCandidateRelease(const Tagger::AlbumMetadata& group, int candidate)
+{
+    const Tagger::TrackListCandidate& release = group.candidates[candidate];
+    if(release.releaseId.isEmpty() || m_releaseFetches >= MaxReleaseFetches) {
+        return false;
+    }
+
+    ++m_releaseFetches;
+    m_releaseGroup = group;
+    m_pendingReleaseId = release.releaseId;
+    m_manager->fetchFromUrl(Tagger::SourceType::MusicBrainz, release.releaseId);
+
+    const QString name = release.name.isEmpty() ? release.releaseId : release.name;
+    updateStatus(tr("Fetching tracks of release %1 of %2 (%3), which fits the loaded tracks best")
+                     .arg(candidate + 1)
+                     .arg(group.candidates.size())
+                     .arg(name));
+    return true;
+}
+
 void TaggerWidget::onFetchFailed(const QString& error)
 {
+    if(m_releaseGroup) {
+        // Go on with the other releases of the group
+        qWarning() << "Could not fetch release" << m_pendingReleaseId << "of a release group:" << error;
+        Tagger::AlbumMetadata group = *std::exchange(m_releaseGroup, std::nullopt);
+        group.candidates.removeIf([this](const auto& release) { return release.releaseId == m_pendingReleaseId; });
+        useFetchedAlbum(std::move(group));
+        return;
+    }
+
     setUIEnabled(true);
     m_progressBar->setRange(0, 100);
     m_progressBar->setValue(0);
@@ -558,6 +665,8 @@ void TaggerWidget::onOverrideMatchesClicked()
 
     // Create and show the track match dialog
     Tagger::TrackMatchDialog dialog(m_fetchedMetadata, m_tracks, m_matchResults, this);
+    dialog.setMatchingEngine(m_manager->matchingEngine());
+    dialog.setTrackFeatures(m_features);
 
     if(dialog.exec() == QDialog::Accepted) {
         // Update match results with user's overrides
@@ -7,6 +7,8 @@
 #include <gui/fywidget.h>
 #include <core/track.h>
 
+#include <optional>
+
 namespace Fooyin {
 class SettingsManager;
 }
@@ -49,7 +51,7 @@ private slots:
     void onSearchClicked();
     void onDirectFetchClicked();
     void onSearchResultDoubleClicked(int row);
-    void onFetchCompleted(const Tagger::AlbumMetadata& metadata);
+    void onFetchCompleted(const Tagger::AlbumMetadata& fetched);
     void onFetchFailed(const QString& error);
     void onSearchResults(const QList<Tagger::AlbumMetadata>& results);
     void onApplyClicked();
@@ -64,15 +66,23 @@ private:
     void updateMatchPreview();
     void updateStatus(const QString& message);
     void setUIEnabled(bool enabled);
+    // Picks the tracklist that fits the loaded tracks, then matches and shows it
+    void useFetchedAlbum(Tagger::AlbumMetadata metadata);
+    // Fetches the tracks of a release group's release listed without them; false if it may not
+    bool fetchCandidateRelease(const Tagger::AlbumMetadata& group, int candidate);
 
     TaggingManager* m_manager;
     Fooyin::SettingsManager* m_settings;
 
     // Loaded data
     Fooyin::TrackList m_tracks;
+    TrackFeatures m_features; // Of m_tracks, replaced only with them
     Tagger::AlbumMetadata m_fetchedMetadata;
     QList<Tagger::MatchResult> m_matchResults;
     QList<Tagger::AlbumMetadata> m_searchResultsCache;
+    std::optional<Tagger::AlbumMetadata> m_releaseGroup; // Waiting for the tracks of one of its releases
+    QString m_pendingReleaseId;                          // That release
+    int m_releaseFetches{0};                             // Releases fetched for the current group
 
     // Source selection
     QButtonGroup* m_sourceGroup;
@@ -1,4 +1,5 @@
 #include "trackmatchdialog.h"
+#include "core/taggingmanager.h"
 #include "core/track.h"
 
 #include <QTableView>
@@ -17,6 +18,7 @@
 #include <QMimeData>
 #include <QApplication>
 #include <algorithm>
+#include <vector>
 
 namespace Tagger {
 
@@ -690,74 +692,52 @@ void TrackMatchDialog::onUnmatchTracks()
 void TrackMatchDialog::onAutoMatch()
 {
     const auto& sourceTracks = m_sourceModel->tracks();
-    auto destTracks = m_destinationModel->tracks();
 
-    // Simple auto-match based on title similarity and duration
-    // Reorder destination tracks to match source tracks
-    Fooyin::TrackList reorderedDestTracks;
-    QList<bool> usedDestTracks;
-    usedDestTracks.resize(destTracks.size(), false);
-
-    for(int i = 0; i < sourceTracks.size(); ++i) {
-        const auto& sourceTrack = sourceTracks[i];
-        QString sourceTitle = sourceTrack.title.toLower().simplified();
-        int sourceDuration = sourceTrack.durationSeconds;
-
-        int bestMatch = -1;
-        double bestScore = 0.0;
-
-        for(int j = 0; j < destTracks.size(); ++j) {
-            if(usedDestTracks[j]) {
-                continue;
-            }
-
-            const auto& destTrack = destTracks[j];
-            QString destTitle = destTrack.title().toLower().simplified();
-            int destDuration = destTrack.duration() / 1000;
-
-            // Calculate similarity score
-            double score = 0.0;
+    QList<MatchingEngine::Track> fetched;
+    fetched.reserve(sourceTracks.size());
+    for(const auto& sourceTrack : sourceTracks) {
+        fetched.append({sourceTrack.title, sourceTrack.durationSeconds, sourceTrack.trackNumber});
+    }
 
-            // Title similarity (exact match gets high score)
-            if(destTitle == sourceTitle) {
-                score += 0.8;
-            }
-            else if(destTitle.contains(sourceTitle) || sourceTitle.contains(destTitle)) {
-                score += 0.5;
-            }
+    // The destination list only ever reorders the user's tracks, so they are matched in their original order
+    const Fooyin::TrackList& destTracks = m_userTracks;
+    if(m_features.size() != static_cast<qsizetype>(destTracks.size())) {
+        m_features = TaggingManager::trackFeatures(destTracks);
+    }
 
-            // Duration similarity
-            if(destDuration > 0 && sourceDuration > 0) {
-                int diff = qAbs(destDuration - sourceDuration);
-                if(diff <= 2) {
-                    score += 0.2;
-                }
-                else if(diff <= 5) {
-                    score += 0.1;
-                }
-            }
+    // Best pairing over all tracks, then each destination track is moved to the row of its source track
+    const QList<MatchingEngine::Match> matches = m_engine.match(m_features, fetched);
 
-            if(score > bestScore && score >= 0.5) {
-                bestScore = score;
-                bestMatch = j;
-            }
+    std::vector<int> rowTrack(static_cast<std::size_t>(sourceTracks.size()), -1);
+    QList<bool> usedDestTracks(static_cast<qsizetype>(destTracks.size()), false);
+    int matchedCount{0};
+    for(qsizetype j = 0; j < matches.size(); ++j) {
+        if(matches[j].index >= 0) {
+            rowTrack[static_cast<std::size_t>(matches[j].index)] = static_cast<int>(j);
+            usedDestTracks[j] = true;
+            ++matchedCount;
         }
+    }
 
-        if(bestMatch >= 0) {
-            reorderedDestTracks.push_back(destTracks[bestMatch]);
-            usedDestTracks[bestMatch] = true;
-        }
-        else {
-            // No match found, add placeholder or skip
-            // We'll add unmatched tracks at the end
+    // Rows left without a match take the leftover tracks in order, so the matched ones keep their rows
+    Fooyin::TrackList reorderedDestTracks;
+    qsizetype leftover{0};
+    auto nextLeftover = [&]() -> int {
+        while(leftover < usedDestTracks.size() && usedDestTracks[leftover]) {
+            ++leftover;
         }
-    }
+        return leftover < usedDestTracks.size() ? static_cast<int>(leftover++) : -1;
+    };
 
-    // Add remaining unmatched destination tracks
-    for(int j = 0; j < destTracks.size(); ++j) {
-        if(!usedDestTracks[j]) {
-            reorderedDestTracks.push_back(destTracks[j]);
+    for(const int track : rowTrack) {
+        const int destIndex = track >= 0 ? track : nextLeftover();
+        if(destIndex < 0) {
+            break;
         }
+        reorderedDestTracks.push_back(destTracks[static_cast<std::size_t>(destIndex)]);
+    }
+    for(int destIndex = nextLeftover(); destIndex >= 0; destIndex = nextLeftover()) {
+        reorderedDestTracks.push_back(destTracks[static_cast<std::size_t>(destIndex)]);
     }
 
     // Update the destination model with reordered tracks
@@ -766,7 +746,6 @@ void TrackMatchDialog::onAutoMatch()
     updateMatchVisuals();
     updateMatchButtons();
 
-    int matchedCount = static_cast<int>(qMin(static_cast<int>(sourceTracks.size()), static_cast<int>(reorderedDestTracks.size())));
     m_statusLabel->setText(tr("Auto-matched and reordered %1/%2 tracks").arg(matchedCount).arg(destTracks.size()));
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "core/matchingengine.h"
+#include "core/trackfeatures.h"
 #include "models/matchresult.h"
 #include "models/albummetadata.h"
 #include <tagger/tagger_common.h>
@@ -112,6 +114,11 @@ public:
 
     [[nodiscard]] QList<MatchResult> getMatches() const { return m_matches; }
 
+    // Auto Match pairs the tracks with this engine's settings
+    void setMatchingEngine(const MatchingEngine& engine) { m_engine = engine; }
+    // Features of userTracks, in their order, so Auto Match need not derive them again
+    void setTrackFeatures(const TrackFeatures& features) { m_features = features; }
+
 private slots:
     void onSourceSelectionChanged();
     void onDestinationSelectionChanged();
@@ -136,6 +143,8 @@ private:
     AlbumMetadata m_sourceMetadata;
     Fooyin::TrackList m_userTracks;
     QList<MatchResult> m_matches;
+    MatchingEngine m_engine;
+    TrackFeatures m_features;
 
     SourceTrackModel* m_sourceModel;
     DestinationTrackModel* m_destinationModel;
@@ -0,0 +1,147 @@
+#include "heaptracking.h"
+
+#include "sources/wikitextcleaner.h"
+#include "sources/wikitokenizer.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRegularExpression>
+#include <QDebug>
+
+// Copy of the regex/replace based cleanWikiText, kept as the baseline
+static QString legacyCleanWikiText(const QString& text)
+{
+    QString cleaned = text;
+
+    static QRegularExpression htmlTagRe(R"(<[^>]+>)");
+    cleaned.remove(htmlTagRe);
+
+    static QRegularExpression citationRe(R"(\[\d+\])");
+    cleaned.remove(citationRe);
+
+    static QRegularExpression editRe(R"(\[edit\])", QRegularExpression::CaseInsensitiveOption);
+    cleaned.remove(editRe);
+
+    cleaned.replace("&amp;", "&");
+    cleaned.replace("&lt;", "<");
+    cleaned.replace("&gt;", ">");
+    cleaned.replace("&quot;", "\"");
+    cleaned.replace("&#39;", "'");
+    cleaned.replace("&nbsp;", " ");
+
+    cleaned.remove(QChar('"'));
+    cleaned.remove(QChar(0x201C));
+    cleaned.remove(QChar(0x201D));
+
+    return cleaned.simplified();
+}
+
+// Every cell, caption and title of the given pages, as the parser sees them
+static QList<QByteArray> collectCells(const QStringList& paths)
+{
+    QList<QByteArray> cells;
+    for(const QString& path : paths) {
+        QFile file(path);
+        if(!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "Could not open" << path;
+            continue;
+        }
+        const QByteArray html = file.readAll();
+
+        WikiHtmlTokenizer tokenizer(html);
+        for(auto token = tokenizer.next(); token.type != WikiHtmlTokenizer::TokenType::End; token = tokenizer.next()) {
+            if(token.type == WikiHtmlTokenizer::TokenType::Cell || token.type == WikiHtmlTokenizer::TokenType::Caption
+               || token.type == WikiHtmlTokenizer::TokenType::Title) {
+                cells.append(token.text.toByteArray());
+            }
+        }
+    }
+    return cells;
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // Pages from the command line, or the saved pages in the tree
+    QStringList paths;
+    for(int i = 1; i < argc; ++i) {
+        paths.append(QString::fromLocal8Bit(argv[i]));
+    }
+    if(paths.isEmpty()) {
+        paths.append(QStringLiteral(TAGGER_SOURCE_DIR "/annakili.html"));
+        const QDir corpus(QStringLiteral(TAGGER_SOURCE_DIR "/test/data/wikipedia"));
+        for(const QString& name : corpus.entryList({QStringLiteral("*.html")}, QDir::Files, QDir::Name)) {
+            paths.append(corpus.filePath(name));
+        }
+    }
+
+    const QList<QByteArray> cells = collectCells(paths);
+    if(cells.isEmpty()) {
+        qWarning() << "No table cells found";
+        return 1;
+    }
+
+    qint64 cellBytes{0};
+    for(const QByteArray& cell : cells) {
+        cellBytes += cell.size();
+    }
+
+    // Enough rounds for a stable figure even on a small corpus
+    const int rounds = qMax(1, static_cast<int>(2'000'000 / qMax<qint64>(cellBytes, 1)));
+
+    const HeapUsage legacyHeap = measureHeap([&]() {
+        for(const QByteArray& cell : cells) {
+            legacyCleanWikiText(QString::fromUtf8(cell));
+        }
+    });
+    const HeapUsage cleanerHeap = measureHeap([&]() {
+        for(const QByteArray& cell : cells) {
+            WikiTextCleaner::clean(cell);
+        }
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    for(int round = 0; round < rounds; ++round) {
+        for(const QByteArray& cell : cells) {
+            legacyCleanWikiText(QString::fromUtf8(cell));
+        }
+    }
+    const qint64 legacyNs = timer.nsecsElapsed();
+
+    timer.restart();
+    for(int round = 0; round < rounds; ++round) {
+        for(const QByteArray& cell : cells) {
+            WikiTextCleaner::clean(cell);
+        }
+    }
+    const qint64 cleanerNs = timer.nsecsElapsed();
+
+    // Where the outputs differ the old cleaner left references or markers behind
+    int differing{0};
+    for(const QByteArray& cell : cells) {
+        const QString before = legacyCleanWikiText(QString::fromUtf8(cell));
+        const QString after = WikiTextCleaner::clean(cell);
+        if(before != after && ++differing <= 10) {
+            qInfo().noquote() << QStringLiteral("  \"%1\" -> \"%2\"").arg(before, after);
+        }
+    }
+
+    const double calls = static_cast<double>(rounds) * static_cast<double>(cells.size());
+    qInfo().noquote() << QStringLiteral("%1 pages, %2 cells (%3 bytes), %4 rounds")
+                             .arg(paths.size())
+                             .arg(cells.size())
+                             .arg(cellBytes)
+                             .arg(rounds);
+    qInfo().noquote() << QStringLiteral("Regex cleaner:       %1 ns/cell").arg(legacyNs / calls, 0, 'f', 1);
+    qInfo().noquote() << QStringLiteral("Single-pass cleaner: %1 ns/cell").arg(cleanerNs / calls, 0, 'f', 1);
+    qInfo().noquote() << QStringLiteral("Regex cleaner heap (all cells):       %1").arg(formatHeap(legacyHeap));
+    qInfo().noquote() << QStringLiteral("Single-pass cleaner heap (all cells): %1").arg(formatHeap(cleanerHeap));
+    qInfo().noquote() << QStringLiteral("Speedup: %1x").arg(static_cast<double>(legacyNs) / qMax<qint64>(cleanerNs, 1), 0, 'f', 2);
+    qInfo().noquote() << QStringLiteral("%1 cell(s) now decode differently").arg(differing);
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+// Fetches a saved Wikipedia page and a MusicBrainz-sized release group
+// from a local stand-in server, first uncompressed over a new connection
+// per request, then compressed over kept-alive connections, and reports
+// bytes on the wire, connections opened and wall time per fetch.
+
+#include "musicbrainzpayload.h"
+#include "standinserver.h"
+
+#include "core/httpclient.h"
+#include "core/httprequest.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QDebug>
+
+#include <utility>
+
+namespace {
+constexpr int Fetches = 30;
+
+struct Run
+{
+    qint64 serverBytes{0};
+    qint64 clientWireBytes{0};
+    qint64 bodyBytes{0};
+    int connections{0};
+    qint64 wallMs{0};
+};
+
+Run fetch(StandInServer& server, const QString& path, bool optimised)
+{
+    server.setCompression(optimised);
+    server.setKeepAlive(optimised);
+    const qint64 servedBefore = server.bytesServed();
+    const int connectionsBefore = server.connections();
+
+    // A fresh client, so no connection is left over from an earlier run
+    HttpClient client;
+    client.setCacheDirectory({});
+    client.setCompressionEnabled(optimised);
+    client.setKeepAliveEnabled(optimised);
+
+    QElapsedTimer timer;
+    timer.start();
+    for(int i = 0; i < Fetches; ++i) {
+        QUrl url = server.url();
+        url.setPath(path);
+        url.setQuery(QStringLiteral("n=%1").arg(i));
+
+        QEventLoop loop;
+        HttpRequest* request = client.get(url, &loop);
+        QObject::connect(request, &HttpRequest::succeeded, &loop, &QEventLoop::quit);
+        QObject::connect(request, &HttpRequest::failed, &loop, [&loop](const HttpError& error) {
+            qWarning() << "Fetch failed:" << error.message;
+            loop.quit();
+        });
+        loop.exec();
+    }
+
+    Run run;
+    run.wallMs = timer.elapsed();
+    run.serverBytes = server.bytesServed() - servedBefore;
+    run.connections = server.connections() - connectionsBefore;
+    const HttpClient::TransferStats stats = client.transferStats();
+    run.clientWireBytes = stats.wireBytes;
+    run.bodyBytes = stats.bodyBytes;
+    return run;
+}
+
+void report(const char* name, const Run& before, const Run& after)
+{
+    auto line = [](const char* label, const Run& run) {
+        qInfo().noquote() << QStringLiteral("  %1 %2 bytes on the wire (client saw %3) for %4, %5 connections, "
+                                            "%6 ms per fetch")
+                                 .arg(QString::fromLatin1(label), -12)
+                                 .arg(run.serverBytes / Fetches, 8)
+                                 .arg(run.clientWireBytes / Fetches, 8)
+                                 .arg(run.bodyBytes / Fetches, 8)
+                                 .arg(run.connections, 3)
+                                 .arg(static_cast<double>(run.wallMs) / Fetches, 0, 'f', 2);
+    };
+    qInfo().noquote() << QString::fromLatin1(name);
+    line("before:", before);
+    line("after:", after);
+    qInfo().noquote() << QStringLiteral("  %1% of the bytes, %2x the speed")
+                             .arg(100.0 * static_cast<double>(after.serverBytes) / qMax<qint64>(before.serverBytes, 1),
+                                  0, 'f', 1)
+                             .arg(static_cast<double>(before.wallMs) / qMax<qint64>(after.wallMs, 1), 0, 'f', 2);
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStandardPaths::setTestModeEnabled(true);
+
+    QFile page(QStringLiteral(TAGGER_SOURCE_DIR "/annakili.html"));
+    if(!page.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open" << page.fileName();
+        return 1;
+    }
+
+    StandInServer server;
+    if(!server.listen()) {
+        qWarning() << "Could not start the stand-in server";
+        return 1;
+    }
+    server.route(QStringLiteral("/wiki/Annakili"), {}, {200, "text/html; charset=utf-8", page.readAll(), {}, {}, {}});
+    const QByteArray releaseGroup = releaseGroupJson(40, 12);
+    server.route(QStringLiteral("/ws/2/release-group"), {}, {200, "application/json", releaseGroup, {}, {}, {}});
+
+    qInfo().noquote() << QStringLiteral("%1 sequential fetches of each, before: identity encoding and a connection "
+                                        "per request; after: deflate and keep-alive")
+                             .arg(Fetches);
+    for(const auto& [name, path] : {std::pair{"Wikipedia page", QStringLiteral("/wiki/Annakili")},
+                                    std::pair{"MusicBrainz release group", QStringLiteral("/ws/2/release-group")}}) {
+        const Run before = fetch(server, path, false);
+        const Run after = fetch(server, path, true);
+        report(name, before, after);
+    }
+
+    return 0;
+}
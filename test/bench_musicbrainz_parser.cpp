@@ -0,0 +1,231 @@
+#include "heaptracking.h"
+#include "musicbrainzpayload.h"
+
+#include "sources/musicbrainzparser.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+
+#include <cstdio>
+#include <utility>
+
+// Copy of the QJsonDocument-based MusicBrainzSource release-group parsing,
+// kept as the baseline for comparing results, timings and heap usage with
+// the streaming parser.
+class LegacyMusicBrainzParser
+{
+public:
+    static Tagger::AlbumMetadata parseReleaseGroup(const QByteArray& data)
+    {
+        QJsonParseError parseError;
+        const QJsonDocument json = QJsonDocument::fromJson(data, &parseError);
+        if(parseError.error != QJsonParseError::NoError) {
+            return {};
+        }
+
+        Tagger::AlbumMetadata metadata;
+        metadata.source = Tagger::SourceType::MusicBrainz;
+
+        QJsonObject root = json.object();
+
+        metadata.releaseId = root["id"].toString();
+        metadata.album = root["title"].toString();
+        metadata.sourceUrl = QString("https://musicbrainz.org/release-group/%1").arg(metadata.releaseId);
+
+        QString date = root["first-release-date"].toString();
+        if(!date.isEmpty()) {
+            metadata.year = date.left(4).toInt();
+        }
+        metadata.albumArtist = artistNames(root["artist-credit"].toArray());
+
+        QJsonArray releases = root["releases"].toArray();
+        for(const QJsonValue& releaseVal : releases) {
+            QJsonObject release = releaseVal.toObject();
+            if(!release.contains("media")) {
+                continue;
+            }
+            QJsonArray media = release["media"].toArray();
+            bool hasTracks = false;
+            for(const QJsonValue& mediaVal : media) {
+                QJsonObject disc = mediaVal.toObject();
+                if(disc.contains("tracks") && disc["tracks"].toArray().size() > 0) {
+                    hasTracks = true;
+                    break;
+                }
+            }
+            if(hasTracks) {
+                addMedia(metadata, media);
+                break;
+            }
+        }
+        return metadata;
+    }
+
+private:
+    static QString artistNames(const QJsonArray& artistCredit)
+    {
+        QStringList artists;
+        for(const QJsonValue& creditVal : artistCredit) {
+            QJsonObject credit = creditVal.toObject();
+            QJsonObject artist = credit["artist"].toObject();
+            artists.append(artist["name"].toString());
+        }
+        return artists.join(", ");
+    }
+
+    static void addMedia(Tagger::AlbumMetadata& metadata, const QJsonArray& media)
+    {
+        int totalDiscs = media.size();
+        for(int discNum = 0; discNum < media.size(); ++discNum) {
+            QJsonObject disc = media[discNum].toObject();
+            QJsonArray tracks = disc["tracks"].toArray();
+            int totalTracksOnDisc = tracks.size();
+
+            for(int trackIdx = 0; trackIdx < tracks.size(); ++trackIdx) {
+                QJsonObject trackObj = tracks[trackIdx].toObject();
+
+                Tagger::TrackMetadata track;
+                track.album = metadata.album;
+                track.albumArtist = metadata.albumArtist;
+                track.year = metadata.year;
+                track.title = trackObj["title"].toString();
+                track.trackNumber = trackObj["position"].toInt();
+                track.totalTracks = totalTracksOnDisc;
+                track.discNumber = discNum + 1;
+                track.totalDiscs = totalDiscs;
+                track.durationSeconds = trackObj["length"].toInt() / 1000;
+
+                QJsonObject recording = trackObj["recording"].toObject();
+                track.mbid = recording["id"].toString();
+
+                QJsonArray trackArtistCredit = trackObj["artist-credit"].toArray();
+                if(trackArtistCredit.isEmpty()) {
+                    trackArtistCredit = recording["artist-credit"].toArray();
+                }
+                track.artist = artistNames(trackArtistCredit);
+                if(track.artist.isEmpty()) {
+                    track.artist = metadata.albumArtist;
+                }
+
+                metadata.tracks.append(track);
+            }
+        }
+    }
+};
+
+static bool sameTrack(const Tagger::TrackMetadata& a, const Tagger::TrackMetadata& b)
+{
+    return a.title == b.title && a.artist == b.artist && a.album == b.album && a.albumArtist == b.albumArtist
+        && a.mbid == b.mbid && a.trackNumber == b.trackNumber && a.totalTracks == b.totalTracks
+        && a.discNumber == b.discNumber && a.totalDiscs == b.totalDiscs && a.year == b.year
+        && a.durationSeconds == b.durationSeconds;
+}
+
+static bool sameAlbum(const Tagger::AlbumMetadata& a, const Tagger::AlbumMetadata& b)
+{
+    if(a.releaseId != b.releaseId || a.album != b.album || a.albumArtist != b.albumArtist || a.year != b.year
+       || a.sourceUrl != b.sourceUrl || a.tracks.size() != b.tracks.size()) {
+        return false;
+    }
+    for(int i = 0; i < a.tracks.size(); ++i) {
+        if(!sameTrack(a.tracks[i], b.tracks[i])) {
+            qDebug() << "Track" << i + 1 << "differs:" << a.tracks[i].title << "vs" << b.tracks[i].title;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void quietMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& message)
+{
+    Q_UNUSED(context)
+    if(type != QtDebugMsg) {
+        fprintf(stderr, "%s\n", qPrintable(message));
+    }
+}
+
+// Parses one payload both ways; false if the results differ
+static bool compare(const QString& name, const QByteArray& json, int iterations)
+{
+    const Tagger::AlbumMetadata legacy = LegacyMusicBrainzParser::parseReleaseGroup(json);
+    const Tagger::AlbumMetadata streamed = MusicBrainzParser::parseReleaseGroup(json).metadata;
+    const bool identical = sameAlbum(legacy, streamed);
+
+    const HeapUsage legacyHeap = measureHeap([&]() { LegacyMusicBrainzParser::parseReleaseGroup(json); });
+    const HeapUsage streamedHeap = measureHeap([&]() { MusicBrainzParser::parseReleaseGroup(json); });
+
+    QElapsedTimer timer;
+    timer.start();
+    for(int i = 0; i < iterations; ++i) {
+        LegacyMusicBrainzParser::parseReleaseGroup(json);
+    }
+    const qint64 legacyNs = timer.nsecsElapsed();
+
+    timer.restart();
+    for(int i = 0; i < iterations; ++i) {
+        MusicBrainzParser::parseReleaseGroup(json);
+    }
+    const qint64 streamedNs = timer.nsecsElapsed();
+
+    qInfo().noquote() << QStringLiteral("%1: %2 KiB, %3 tracks taken, %4 iterations")
+                             .arg(name)
+                             .arg(json.size() / 1024.0, 0, 'f', 1)
+                             .arg(streamed.tracks.size())
+                             .arg(iterations);
+    qInfo().noquote() << QStringLiteral("  QJsonDocument: %1 us, %2")
+                             .arg(legacyNs / 1000.0 / iterations, 0, 'f', 1)
+                             .arg(formatHeap(legacyHeap));
+    qInfo().noquote() << QStringLiteral("  Streaming:     %1 us, %2")
+                             .arg(streamedNs / 1000.0 / iterations, 0, 'f', 1)
+                             .arg(formatHeap(streamedHeap));
+    qInfo().noquote() << QStringLiteral("  Speedup: %1x, %2")
+                             .arg(static_cast<double>(legacyNs) / qMax<qint64>(streamedNs, 1), 0, 'f', 2)
+                             .arg(identical ? QStringLiteral("results identical") : QStringLiteral("RESULTS DIFFER"));
+    return identical;
+}
+
+// Compares the streaming release-group parser with the QJsonDocument one
+// on generated groups of growing size, then on any saved ws/2 replies in
+// test/data/musicbrainz or given on the command line.
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // Parser debug output would dominate the timings
+    qInstallMessageHandler(quietMessageHandler);
+
+    bool identical{true};
+    for(const auto& [releases, tracks] :
+        {std::pair{1, 12}, std::pair{25, 12}, std::pair{100, 15}, std::pair{400, 20}}) {
+        const QByteArray json = releaseGroupJson(releases, tracks);
+        const int iterations = qMax(5, static_cast<int>(20 * 1024 * 1024 / json.size()));
+        identical &= compare(QStringLiteral("Generated, %1 releases of %2 tracks").arg(releases).arg(tracks), json,
+                             qMin(iterations, 2000));
+    }
+
+    QStringList files;
+    const QDir saved(QStringLiteral(TAGGER_SOURCE_DIR "/test/data/musicbrainz"));
+    for(const QString& file : saved.entryList({QStringLiteral("*.json")}, QDir::Files)) {
+        files.append(saved.filePath(file));
+    }
+    for(int i = 1; i < argc; ++i) {
+        files.append(QString::fromLocal8Bit(argv[i]));
+    }
+
+    for(const QString& path : files) {
+        QFile file(path);
+        if(!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "Could not open" << path;
+            return 1;
+        }
+        identical &= compare(path, file.readAll(), 50);
+    }
+
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+#include "core/editdistance.h"
+#include "core/matchingengine.h"
+#include "core/titlebatch.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QDebug>
+
+#include <algorithm>
+#include <random>
+
+// Soundtrack-like titles of two to six words, some with an aside like Wikipedia gives them
+static QList<QString> generateRawTitles(qsizetype count, std::mt19937& random)
+{
+    static const QStringList words{
+        QStringLiteral("raja"),   QStringLiteral("kanmani"),  QStringLiteral("anbodu"),  QStringLiteral("kadhal"),
+        QStringLiteral("poo"),    QStringLiteral("maalai"),   QStringLiteral("theme"),   QStringLiteral("instrumental"),
+        QStringLiteral("ennai"),  QStringLiteral("thedi"),    QStringLiteral("vandha"),  QStringLiteral("nilave"),
+        QStringLiteral("love"),   QStringLiteral("reprise"),  QStringLiteral("version"), QStringLiteral("sad"),
+        QStringLiteral("vaanam"), QStringLiteral("megam"),    QStringLiteral("mazhai"),  QStringLiteral("thendral"),
+        QStringLiteral("unnai"),  QStringLiteral("ninaithu"), QStringLiteral("oru"),     QStringLiteral("naal"),
+    };
+    static const QStringList asides{
+        {},
+        {},
+        QStringLiteral(" (Reprise)"),
+        QStringLiteral(" (Female Version)"),
+        QStringLiteral(" (From \"Thendral Vandhu Ennai Thodum\" Original Motion Picture Soundtrack)"),
+    };
+    std::uniform_int_distribution<qsizetype> wordCount(2, 6);
+    std::uniform_int_distribution<qsizetype> word(0, words.size() - 1);
+    std::uniform_int_distribution<qsizetype> aside(0, asides.size() - 1);
+
+    QList<QString> titles;
+    titles.reserve(count);
+    for(qsizetype i = 0; i < count; ++i) {
+        QStringList parts;
+        for(qsizetype w = wordCount(random); w > 0; --w) {
+            parts.append(words.at(word(random)));
+        }
+        titles.append(parts.join(QLatin1Char(' ')) + asides.at(aside(random)));
+    }
+    return titles;
+}
+
+// Normalized as the Jaro-Winkler channel sees them
+static QList<QString> generateTitles(qsizetype count, std::mt19937& random)
+{
+    QList<QString> titles = generateRawTitles(count, random);
+    for(QString& title : titles) {
+        title = MatchingEngine::normalizeTitle(title);
+    }
+    return titles;
+}
+
+// Copy of the dynamic-programming Levenshtein distance, kept as the baseline
+static qsizetype legacyDistance(const QString& a, const QString& b)
+{
+    QList<qsizetype> row(b.size() + 1);
+    for(qsizetype j = 0; j <= b.size(); ++j) {
+        row[j] = j;
+    }
+    for(qsizetype i = 1; i <= a.size(); ++i) {
+        qsizetype diagonal = row[0];
+        row[0] = i;
+        for(qsizetype j = 1; j <= b.size(); ++j) {
+            const qsizetype above = row[j];
+            row[j] = std::min({above + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0 : 1)});
+            diagonal = above;
+        }
+    }
+    return row[b.size()];
+}
+
+static QString kernelName(TitleBatch::Kernel kernel)
+{
+    switch(kernel) {
+        case TitleBatch::Kernel::Scalar:
+            return QStringLiteral("Scalar");
+        case TitleBatch::Kernel::Sse2:
+            return QStringLiteral("SSE2");
+        case TitleBatch::Kernel::Avx2:
+            return QStringLiteral("AVX2");
+    }
+    return {};
+}
+
+// Scores a 500 × 500 title matrix pair by pair with MatchingEngine::jaroWinkler,
+// then a row at a time with every TitleBatch kernel this CPU runs. Then
+// edit distances on raw titles, dynamic programming vs. bit-parallel, and
+// a whole MatchingEngine::match of two 500-track lists.
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    constexpr qsizetype Size = 500;
+    constexpr int Rounds = 5;
+
+    std::mt19937 random(42);
+    const QList<QString> local = generateTitles(Size, random);
+    const QList<QString> fetched = generateTitles(Size, random);
+
+    QList<double> reference(Size * Size);
+    QElapsedTimer timer;
+    timer.start();
+    for(int round = 0; round < Rounds; ++round) {
+        for(qsizetype i = 0; i < Size; ++i) {
+            for(qsizetype j = 0; j < Size; ++j) {
+                reference[i * Size + j] = MatchingEngine::jaroWinkler(local[i], fetched[j]);
+            }
+        }
+    }
+    const qint64 pairwiseNs = timer.nsecsElapsed();
+
+    constexpr double Pairs = static_cast<double>(Size) * Size * Rounds;
+    qInfo().noquote() << QStringLiteral("%1 x %1 titles, %2 rounds").arg(Size).arg(Rounds);
+    qInfo().noquote() << QStringLiteral("Pair by pair: %1 ns/pair").arg(pairwiseNs / Pairs, 0, 'f', 1);
+
+    bool identical{true};
+    for(const auto kernel : {TitleBatch::Kernel::Scalar, TitleBatch::Kernel::Sse2, TitleBatch::Kernel::Avx2}) {
+        if(!TitleBatch::isSupported(kernel)) {
+            qInfo().noquote() << QStringLiteral("%1: not available").arg(kernelName(kernel));
+            continue;
+        }
+
+        const TitleBatch batch(fetched, kernel);
+        QList<double> row;
+        bool same{true};
+
+        timer.restart();
+        for(int round = 0; round < Rounds; ++round) {
+            for(qsizetype i = 0; i < Size; ++i) {
+                batch.jaroWinkler(local[i], row);
+                if(round == 0) {
+                    same = same && std::equal(row.cbegin(), row.cend(), reference.cbegin() + i * Size);
+                }
+            }
+        }
+        const qint64 batchNs = timer.nsecsElapsed();
+        identical = identical && same;
+
+        qInfo().noquote() << QStringLiteral("%1: %2 ns/pair, %3x, %4")
+                                 .arg(kernelName(kernel), -12)
+                                 .arg(batchNs / Pairs, 0, 'f', 1)
+                                 .arg(static_cast<double>(pairwiseNs) / qMax<qint64>(batchNs, 1), 0, 'f', 2)
+                                 .arg(same ? QStringLiteral("results identical") : QStringLiteral("RESULTS DIFFER"));
+    }
+
+    // Raw titles with their asides, a fifth of them longer than one 64-bit block
+    std::mt19937 rawRandom(7);
+    const QList<QString> rawLocal = generateRawTitles(Size, rawRandom);
+    const QList<QString> rawFetched = generateRawTitles(Size, rawRandom);
+
+    QList<qsizetype> distances(Size * Size);
+    timer.restart();
+    for(qsizetype i = 0; i < Size; ++i) {
+        for(qsizetype j = 0; j < Size; ++j) {
+            distances[i * Size + j] = legacyDistance(rawLocal[i], rawFetched[j]);
+        }
+    }
+    const qint64 legacyNs = timer.nsecsElapsed();
+
+    bool sameDistances{true};
+    timer.restart();
+    for(qsizetype i = 0; i < Size; ++i) {
+        const EditDistance pattern(rawLocal[i]);
+        for(qsizetype j = 0; j < Size; ++j) {
+            sameDistances = pattern.distance(rawFetched[j]) == distances[i * Size + j] && sameDistances;
+        }
+    }
+    const qint64 bitParallelNs = timer.nsecsElapsed();
+    identical = identical && sameDistances;
+
+    constexpr double RawPairs = static_cast<double>(Size) * Size;
+    qInfo().noquote() << QStringLiteral("Edit distance, dynamic programming: %1 ns/pair")
+                             .arg(legacyNs / RawPairs, 0, 'f', 1);
+    qInfo().noquote() << QStringLiteral("Edit distance, bit-parallel:        %1 ns/pair, %2x, %3")
+                             .arg(bitParallelNs / RawPairs, 0, 'f', 1)
+                             .arg(static_cast<double>(legacyNs) / qMax<qint64>(bitParallelNs, 1), 0, 'f', 2)
+                             .arg(sameDistances ? QStringLiteral("results identical")
+                                                : QStringLiteral("RESULTS DIFFER"));
+
+    QList<MatchingEngine::Track> localTracks;
+    QList<MatchingEngine::Track> fetchedTracks;
+    for(qsizetype i = 0; i < Size; ++i) {
+        localTracks.append({rawLocal[i], 0});
+        fetchedTracks.append({rawFetched[i], 0});
+    }
+    const MatchingEngine engine;
+    timer.restart();
+    const QList<MatchingEngine::Match> matches = engine.match(localTracks, fetchedTracks);
+    const qint64 matchNs = timer.nsecsElapsed();
+    qInfo().noquote() << QStringLiteral("Matching %1 x %1 tracks without durations: %2 ms, %3 ns/pair")
+                             .arg(Size)
+                             .arg(matchNs / 1'000'000.0, 0, 'f', 1)
+                             .arg(matchNs / RawPairs, 0, 'f', 1);
+
+    return identical ? 0 : 1;
+}
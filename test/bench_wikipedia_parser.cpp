@@ -0,0 +1,316 @@
+#include "heaptracking.h"
+
+#include "sources/wikipediaparser.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRegularExpression>
+#include <QDebug>
+
+#include <cstdio>
+
+// Copy of the regex-based WikipediaSource parsing path, kept as the
+// baseline for comparing results, timings and heap usage with the tokenizer.
+class LegacyWikipediaParser
+{
+public:
+    static Tagger::AlbumMetadata parsePage(const QByteArray& html, const QString& sourceUrl)
+    {
+        Tagger::AlbumMetadata metadata;
+        metadata.source = Tagger::SourceType::Wikipedia;
+        metadata.sourceUrl = sourceUrl;
+
+        QString htmlStr = QString::fromUtf8(html);
+        metadata.album = extractPageTitle(htmlStr);
+
+        QString soundtrackSection = extractSoundtrackSection(htmlStr);
+        if(!soundtrackSection.isEmpty()) {
+            metadata.tracks = parseSoundtrackTable(soundtrackSection);
+            for(const auto& track : metadata.tracks) {
+                if(!track.musicDirector.isEmpty()) {
+                    metadata.musicDirector = track.musicDirector;
+                    break;
+                }
+            }
+        }
+
+        for(auto& track : metadata.tracks) {
+            track.album = metadata.album;
+        }
+        return metadata;
+    }
+
+private:
+    static QString extractPageTitle(const QString& html)
+    {
+        static QRegularExpression titleRe(R"(<title>([^<]+)</title>)", QRegularExpression::CaseInsensitiveOption);
+        QRegularExpressionMatch match = titleRe.match(html);
+        if(match.hasMatch()) {
+            QString title = match.captured(1);
+            title.remove(QRegularExpression(R"(\s*[-–]\s*Wikipedia.*$)", QRegularExpression::CaseInsensitiveOption));
+            title.remove(QRegularExpression(R"(\s*\(film\)\s*$)", QRegularExpression::CaseInsensitiveOption));
+            return WikipediaParser::cleanWikiText(title.trimmed());
+        }
+        return QString();
+    }
+
+    static QString extractSoundtrackSection(const QString& html)
+    {
+        static QRegularExpression sectionRe(
+            R"RE(<h[23][^>]*id="(?:Soundtrack|Music|Track[^"]*)"[^>]*>.*?</h[23]>)RE",
+            QRegularExpression::CaseInsensitiveOption | QRegularExpression::DotMatchesEverythingOption
+        );
+
+        QRegularExpressionMatch sectionMatch = sectionRe.match(html);
+        if(!sectionMatch.hasMatch()) {
+            return QString();
+        }
+
+        int sectionStart = sectionMatch.capturedEnd();
+
+        static QRegularExpression nextSectionRe(R"(<h[23][^>]*>)", QRegularExpression::CaseInsensitiveOption);
+        QRegularExpressionMatch nextMatch = nextSectionRe.match(html, sectionStart);
+
+        int sectionEnd = nextMatch.hasMatch() ? nextMatch.capturedStart() : html.length();
+        return html.mid(sectionStart, sectionEnd - sectionStart);
+    }
+
+    struct TableColumns
+    {
+        int numberIndex{-1};
+        int songIndex{-1};
+        int singerIndex{-1};
+        int lyricsIndex{-1};
+        int musicIndex{-1};
+        int durationIndex{-1};
+    };
+
+    static TableColumns detectColumns(const QStringList& headers)
+    {
+        TableColumns cols;
+        for(int i = 0; i < headers.size(); ++i) {
+            QString h = headers[i].toLower();
+            if(h.contains("no") || h.contains("#") || h == "sr") {
+                cols.numberIndex = i;
+            }
+            else if(h.contains("song") || h.contains("title") || h.contains("track")) {
+                cols.songIndex = i;
+            }
+            else if(h.contains("singer") || h.contains("artist") || h.contains("vocals") || h.contains("performed")) {
+                cols.singerIndex = i;
+            }
+            else if(h.contains("lyric") || h.contains("written")) {
+                cols.lyricsIndex = i;
+            }
+            else if(h.contains("music") || h.contains("composer") || h.contains("composed")) {
+                cols.musicIndex = i;
+            }
+            else if(h.contains("duration") || h.contains("length") || h.contains("time")) {
+                cols.durationIndex = i;
+            }
+        }
+        return cols;
+    }
+
+    static QList<Tagger::TrackMetadata> parseSoundtrackTable(const QString& tableHtml)
+    {
+        QList<Tagger::TrackMetadata> tracks;
+
+        static QRegularExpression tableRe(
+            R"(<table[^>]*class="[^"]*(?:wikitable|tracklist)[^"]*"[^>]*>(.*?)</table>)",
+            QRegularExpression::CaseInsensitiveOption | QRegularExpression::DotMatchesEverythingOption
+        );
+
+        QRegularExpressionMatch tableMatch = tableRe.match(tableHtml);
+        if(!tableMatch.hasMatch()) {
+            return tracks;
+        }
+
+        QString tableContent = tableMatch.captured(1);
+
+        static QRegularExpression rowRe(
+            R"(<tr[^>]*>(.*?)</tr>)",
+            QRegularExpression::CaseInsensitiveOption | QRegularExpression::DotMatchesEverythingOption
+        );
+        static QRegularExpression cellRe(
+            R"(<t[hd][^>]*>(.*?)</t[hd]>)",
+            QRegularExpression::CaseInsensitiveOption | QRegularExpression::DotMatchesEverythingOption
+        );
+
+        QRegularExpressionMatchIterator rowIt = rowRe.globalMatch(tableContent);
+        TableColumns columns;
+        bool foundHeader = false;
+
+        while(rowIt.hasNext()) {
+            QString rowContent = rowIt.next().captured(1);
+
+            if(rowContent.contains("<th", Qt::CaseInsensitive) && !foundHeader) {
+                QStringList headers;
+                QRegularExpressionMatchIterator cellIt = cellRe.globalMatch(rowContent);
+                while(cellIt.hasNext()) {
+                    headers.append(WikipediaParser::cleanWikiText(cellIt.next().captured(1)));
+                }
+                columns = detectColumns(headers);
+                foundHeader = true;
+                continue;
+            }
+
+            if(foundHeader && rowContent.contains("<td", Qt::CaseInsensitive)) {
+                QStringList cells;
+                QRegularExpressionMatchIterator cellIt = cellRe.globalMatch(rowContent);
+                while(cellIt.hasNext()) {
+                    cells.append(WikipediaParser::cleanWikiText(cellIt.next().captured(1)));
+                }
+                if(cells.isEmpty()) {
+                    continue;
+                }
+
+                Tagger::TrackMetadata track;
+                track.trackNumber = tracks.size() + 1;
+
+                if(columns.numberIndex >= 0 && columns.numberIndex < cells.size()) {
+                    bool ok;
+                    int num = cells[columns.numberIndex].toInt(&ok);
+                    if(ok) {
+                        track.trackNumber = num;
+                    }
+                }
+                if(columns.songIndex >= 0 && columns.songIndex < cells.size()) {
+                    track.title = cells[columns.songIndex];
+                }
+                else if(!cells.isEmpty()) {
+                    track.title = cells[0];
+                }
+                if(columns.singerIndex >= 0 && columns.singerIndex < cells.size()) {
+                    track.artist = cells[columns.singerIndex];
+                }
+                if(columns.lyricsIndex >= 0 && columns.lyricsIndex < cells.size()) {
+                    track.lyricist = cells[columns.lyricsIndex];
+                }
+                if(columns.musicIndex >= 0 && columns.musicIndex < cells.size()) {
+                    track.musicDirector = cells[columns.musicIndex];
+                    if(track.composer.isEmpty()) {
+                        track.composer = track.musicDirector;
+                    }
+                }
+                if(columns.durationIndex >= 0 && columns.durationIndex < cells.size()) {
+                    track.durationSeconds = WikipediaParser::parseDuration(cells[columns.durationIndex]);
+                }
+                if(!track.title.isEmpty()) {
+                    tracks.append(track);
+                }
+            }
+        }
+
+        for(auto& track : tracks) {
+            track.totalTracks = tracks.size();
+        }
+        return tracks;
+    }
+};
+
+static bool sameTrack(const Tagger::TrackMetadata& a, const Tagger::TrackMetadata& b)
+{
+    return a.title == b.title && a.artist == b.artist && a.album == b.album && a.lyricist == b.lyricist
+        && a.composer == b.composer && a.musicDirector == b.musicDirector && a.trackNumber == b.trackNumber
+        && a.totalTracks == b.totalTracks && a.durationSeconds == b.durationSeconds;
+}
+
+static bool sameAlbum(const Tagger::AlbumMetadata& a, const Tagger::AlbumMetadata& b)
+{
+    if(a.album != b.album || a.musicDirector != b.musicDirector || a.tracks.size() != b.tracks.size()) {
+        return false;
+    }
+    for(int i = 0; i < a.tracks.size(); ++i) {
+        if(!sameTrack(a.tracks[i], b.tracks[i])) {
+            qDebug() << "Track" << i + 1 << "differs:" << a.tracks[i].title << "vs" << b.tracks[i].title;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void quietMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& message)
+{
+    Q_UNUSED(context)
+    if(type != QtDebugMsg) {
+        fprintf(stderr, "%s\n", qPrintable(message));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const QString path = argc > 1 ? QString::fromLocal8Bit(argv[1])
+                                  : QStringLiteral(TAGGER_SOURCE_DIR "/annakili.html");
+    const int iterations = argc > 2 ? QByteArray(argv[2]).toInt() : 200;
+
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open" << path;
+        return 1;
+    }
+    const QByteArray html = file.readAll();
+    const QString url = QStringLiteral("https://en.wikipedia.org/wiki/Annakili_(soundtrack)");
+
+    // Parser debug output would dominate the timings
+    qInstallMessageHandler(quietMessageHandler);
+
+    Tagger::AlbumMetadata legacy = LegacyWikipediaParser::parsePage(html, url);
+    // The regex parser took the tracklist's "Total length" row for a track titled
+    // with the total; the grid layout skips it, so leave it out of the comparison
+    static const QRegularExpression totalLengthRe(QStringLiteral(R"(^\d+:\d\d$)"));
+    if(!legacy.tracks.isEmpty() && totalLengthRe.match(legacy.tracks.constLast().title).hasMatch()) {
+        legacy.tracks.removeLast();
+        for(auto& track : legacy.tracks) {
+            track.totalTracks = static_cast<int>(legacy.tracks.size());
+        }
+    }
+    const Tagger::AlbumMetadata tokenized = WikipediaParser::parsePage(html, url);
+
+    // Feed the page the way a download delivers it and note how much of it was needed
+    WikipediaParser incremental(url);
+    qsizetype bytesFed{0};
+    constexpr qsizetype chunkSize = 16 * 1024;
+    while(!incremental.isComplete() && bytesFed < html.size()) {
+        const QByteArrayView chunk = QByteArrayView(html).sliced(bytesFed, qMin(chunkSize, html.size() - bytesFed));
+        incremental.feed(chunk);
+        bytesFed += chunk.size();
+    }
+    incremental.finish();
+
+    const bool identical = sameAlbum(legacy, tokenized) && sameAlbum(tokenized, incremental.result());
+
+    const HeapUsage legacyHeap = measureHeap([&]() { LegacyWikipediaParser::parsePage(html, url); });
+    const HeapUsage tokenizedHeap = measureHeap([&]() { WikipediaParser::parsePage(html, url); });
+
+    QElapsedTimer timer;
+    timer.start();
+    for(int i = 0; i < iterations; ++i) {
+        LegacyWikipediaParser::parsePage(html, url);
+    }
+    const qint64 legacyNs = timer.nsecsElapsed();
+
+    timer.restart();
+    for(int i = 0; i < iterations; ++i) {
+        WikipediaParser::parsePage(html, url);
+    }
+    const qint64 tokenizedNs = timer.nsecsElapsed();
+
+    qInfo().noquote() << QStringLiteral("Page: %1 (%2 bytes), %3 iterations").arg(path).arg(html.size()).arg(iterations);
+    qInfo().noquote() << QStringLiteral("Album: %1, tracks: %2").arg(tokenized.album).arg(tokenized.tracks.size());
+    qInfo().noquote() << QStringLiteral("Regex path:     %1 us/page").arg(legacyNs / 1000.0 / iterations, 0, 'f', 1);
+    qInfo().noquote() << QStringLiteral("Tokenizer path: %1 us/page").arg(tokenizedNs / 1000.0 / iterations, 0, 'f', 1);
+    qInfo().noquote() << QStringLiteral("Regex path heap:     %1").arg(formatHeap(legacyHeap));
+    qInfo().noquote() << QStringLiteral("Tokenizer path heap: %1").arg(formatHeap(tokenizedHeap));
+    qInfo().noquote() << QStringLiteral("Incremental: complete after %1 of %2 bytes (%3 KiB chunks)")
+                             .arg(bytesFed)
+                             .arg(html.size())
+                             .arg(chunkSize / 1024);
+    qInfo().noquote() << QStringLiteral("Speedup: %1x").arg(static_cast<double>(legacyNs) / qMax<qint64>(tokenizedNs, 1), 0, 'f', 2);
+    qInfo().noquote() << (identical ? "Results identical" : "RESULTS DIFFER");
+
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+// Heap accounting shared by the benchmarks. Include from exactly one
+// source file per executable: on glibc it replaces malloc and friends.
+
+#include <QString>
+
+#include <atomic>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+
+// Heap accounting for the peak-allocation figures. Qt containers allocate
+// through malloc rather than operator new, so the libc entry points are
+// interposed here and forwarded to glibc's implementation.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace {
+std::atomic<long long> heapCurrent{0};
+std::atomic<long long> heapPeak{0};
+std::atomic<long long> heapAllocations{0};
+
+void trackAllocation(void* ptr)
+{
+    if(!ptr) {
+        return;
+    }
+    const long long current = heapCurrent += static_cast<long long>(malloc_usable_size(ptr));
+    ++heapAllocations;
+    long long peak = heapPeak.load(std::memory_order_relaxed);
+    while(current > peak && !heapPeak.compare_exchange_weak(peak, current)) { }
+}
+
+void trackRelease(void* ptr)
+{
+    if(ptr) {
+        heapCurrent -= static_cast<long long>(malloc_usable_size(ptr));
+    }
+}
+} // namespace
+
+extern "C" {
+void* malloc(size_t size)
+{
+    void* ptr = __libc_malloc(size);
+    trackAllocation(ptr);
+    return ptr;
+}
+
+void* calloc(size_t count, size_t size)
+{
+    void* ptr = __libc_calloc(count, size);
+    trackAllocation(ptr);
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    trackRelease(ptr);
+    void* result = __libc_realloc(ptr, size);
+    trackAllocation(result ? result : ptr);
+    return result;
+}
+
+void free(void* ptr)
+{
+    trackRelease(ptr);
+    __libc_free(ptr);
+}
+}
+
+#define TAGGER_HEAP_TRACKING 1
+#endif
+
+struct HeapUsage
+{
+    long long peakBytes{-1};
+    long long allocations{-1};
+};
+
+// Peak heap growth and allocation count while running fn once
+template<typename Fn>
+inline HeapUsage measureHeap(Fn&& fn)
+{
+#ifdef TAGGER_HEAP_TRACKING
+    const long long start = heapCurrent.load();
+    const long long startAllocations = heapAllocations.load();
+    heapPeak = start;
+    fn();
+    return {heapPeak.load() - start, heapAllocations.load() - startAllocations};
+#else
+    fn();
+    return {};
+#endif
+}
+
+inline QString formatHeap(const HeapUsage& usage)
+{
+    if(usage.peakBytes < 0) {
+        return QStringLiteral("n/a (heap tracking needs glibc)");
+    }
+    return QStringLiteral("%1 KiB peak, %2 allocations").arg(usage.peakBytes / 1024.0, 0, 'f', 1).arg(usage.allocations);
+}
+
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QByteArray>
+
+// Synthetic MusicBrainz reply shaped like a ws/2 release group fetched with
+// inc=releases+recordings+artist-credits+labels, for the benchmarks
+inline QByteArray releaseGroupJson(int releases, int tracksPerRelease)
+{
+    QByteArray json = R"({"id":"5b4d3e2a-1c0f-4e6b-9a8d-7c6b5a4f3e2d","title":"Annakili","primary-type":"Album",)"
+                      R"("artist-credit":[{"name":"Ilaiyaraaja","artist":{"id":"d5a4e2b1-8c7f-4f3e-9d2c-1b0a9f8e7d6c",)"
+                      R"("name":"Ilaiyaraaja","sort-name":"Ilaiyaraaja"}}],"releases":[)";
+    for(int r = 0; r < releases; ++r) {
+        if(r > 0) {
+            json += ',';
+        }
+        json += R"({"id":"0f1e2d3c-4b5a-6978-8796-a5b4c3d2e1f)" + QByteArray::number(r % 10)
+              + R"(","title":"Annakili","status":"Official","date":"1976-0)" + QByteArray::number(1 + r % 9)
+              + R"(-01","country":"IN","label-info":[{"catalog-number":"ECLP )" + QByteArray::number(5400 + r)
+              + R"(","label":{"id":"7e6d5c4b-3a29-1807-f6e5-d4c3b2a19087","name":"EMI"}}],"media":[{"position":1,)"
+              + R"("format":"Vinyl","track-count":)" + QByteArray::number(tracksPerRelease) + R"(,"tracks":[)";
+        for(int t = 0; t < tracksPerRelease; ++t) {
+            if(t > 0) {
+                json += ',';
+            }
+            json += R"({"id":"a1b2c3d4-e5f6-4789-8abc-def01234567)" + QByteArray::number(t % 10)
+                  + R"(","position":)" + QByteArray::number(t + 1) + R"(,"number":")" + QByteArray::number(t + 1)
+                  + R"(","title":"Machana Paatheengala","length":)" + QByteArray::number(200000 + t * 1000)
+                  + R"(,"recording":{"id":"b2c3d4e5-f6a7-4890-9bcd-ef0123456789","title":"Machana Paatheengala",)"
+                  + R"("artist-credit":[{"name":"S. Janaki","artist":{"id":"c3d4e5f6-a7b8-4901-8cde-f01234567890",)"
+                  + R"("name":"S. Janaki","sort-name":"Janaki, S."}}]}})";
+        }
+        json += "]}]}";
+    }
+    json += "]}";
+    return json;
+}
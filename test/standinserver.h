@@ -0,0 +1,225 @@
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QLocale>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+#include <QUrlQuery>
+
+#include <functional>
+#include <memory>
+
+// Minimal HTTP/1.1 server on localhost that answers GET requests with
+// canned responses. Lets the sources be exercised end to end without
+// touching the real services. Responses with an ETag or Last-Modified
+// answer matching conditional requests with 304 Not Modified; a delay
+// keeps a request in flight for tests that need it to be, and a cut drops
+// the connection partway through the body. Keep-alive and deflate are off
+// unless turned on.
+class StandInServer
+{
+public:
+    struct Response
+    {
+        int status{200};
+        QByteArray contentType{"application/json; charset=utf-8"};
+        QByteArray body;
+        QByteArray etag;
+        QByteArray lastModified;
+        QByteArray cacheControl;
+        int delayMs{0}; // Held back this long before answering
+        QByteArray retryAfter;
+        qsizetype cutAfter{-1}; // Body bytes sent before the connection is dropped; -1 sends all of them
+    };
+
+    // Header names are lowercase
+    using Headers = QHash<QByteArray, QByteArray>;
+
+    // Returns the response for a request, or nullptr to try the next route
+    using Handler = std::function<const Response*(const QUrl& target)>;
+
+    StandInServer()
+    {
+        QObject::connect(&m_server, &QTcpServer::newConnection, &m_server, [this]() {
+            while(QTcpSocket* socket = m_server.nextPendingConnection()) {
+                serve(socket);
+            }
+        });
+    }
+
+    bool listen() { return m_server.listen(QHostAddress::LocalHost); }
+
+    [[nodiscard]] QUrl url() const
+    {
+        QUrl url;
+        url.setScheme(QStringLiteral("http"));
+        url.setHost(QStringLiteral("127.0.0.1"));
+        url.setPort(m_server.serverPort());
+        return url;
+    }
+
+    // Serves response for GETs of path whose query contains all of the given items
+    void route(const QString& path, const QList<QPair<QString, QString>>& query, const Response& response)
+    {
+        m_routes.append([path, query, response](const QUrl& target) -> const Response* {
+            if(target.path() != path) {
+                return nullptr;
+            }
+            const QUrlQuery targetQuery(target);
+            for(const auto& [key, value] : query) {
+                if(targetQuery.queryItemValue(key, QUrl::FullyDecoded) != value) {
+                    return nullptr;
+                }
+            }
+            return &response;
+        });
+    }
+
+    // Lets handler pick the response, e.g. to fail the first few requests
+    void route(const Handler& handler) { m_routes.append(handler); }
+
+    void clear()
+    {
+        m_routes.clear();
+        m_requests.clear();
+        m_requestHeaders.clear();
+        m_bytesServed = 0;
+        m_connections = 0;
+    }
+
+    // Leaves connections open for further requests, unless the client asks to close them
+    void setKeepAlive(bool enabled) { m_keepAlive = enabled; }
+    // Deflates bodies for clients that accept it
+    void setCompression(bool enabled) { m_compression = enabled; }
+
+    [[nodiscard]] const QList<QUrl>& requests() const { return m_requests; }
+    // Headers of each request, in the order of requests()
+    [[nodiscard]] const QList<Headers>& requestHeaders() const { return m_requestHeaders; }
+    // Body bytes as sent, so compressed when compression is on
+    [[nodiscard]] qint64 bytesServed() const { return m_bytesServed; }
+    // Connections accepted; fewer than requests when they are kept alive
+    [[nodiscard]] int connections() const { return m_connections; }
+
+private:
+    void serve(QTcpSocket* socket)
+    {
+        ++m_connections;
+        auto buffer = std::make_shared<QByteArray>();
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket, buffer]() {
+            buffer->append(socket->readAll());
+            // GETs have no body, so a kept-alive connection may hold several requests
+            qsizetype headerEnd = buffer->indexOf("\r\n\r\n");
+            while(headerEnd >= 0) {
+                const QByteArray head = buffer->left(headerEnd);
+                buffer->remove(0, headerEnd + 4);
+                answer(socket, head);
+                headerEnd = buffer->indexOf("\r\n\r\n");
+            }
+        });
+    }
+
+    void answer(QTcpSocket* socket, const QByteArray& head)
+    {
+        // "GET /path?query HTTP/1.1", then "Name: value" lines
+        const QList<QByteArray> lines = head.split('\n');
+        const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+        const QUrl target = QUrl::fromEncoded(requestLine.value(1));
+        Headers headers;
+        for(qsizetype i = 1; i < lines.size(); ++i) {
+            const qsizetype colon = lines[i].indexOf(':');
+            if(colon > 0) {
+                headers.insert(lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed());
+            }
+        }
+        m_requests.append(target);
+        m_requestHeaders.append(headers);
+
+        const Response notFound{404, "text/plain", "Not found"};
+        const Response* response = &notFound;
+        for(const Handler& handler : std::as_const(m_routes)) {
+            if(const Response* match = handler(target)) {
+                response = match;
+                break;
+            }
+        }
+
+        const bool notModified
+            = (!response->etag.isEmpty() && headers.value("if-none-match") == response->etag)
+           || (response->etag.isEmpty() && !response->lastModified.isEmpty()
+               && headers.value("if-modified-since") == response->lastModified);
+        QByteArray body = notModified ? QByteArray{} : response->body;
+
+        // zlib's format is what HTTP calls deflate; qCompress() prefixes it with the length
+        const bool deflate = m_compression && !body.isEmpty() && headers.value("accept-encoding").contains("deflate");
+        if(deflate) {
+            body = qCompress(body).mid(4);
+        }
+        const bool keepAlive = m_keepAlive && headers.value("connection").toLower() != "close";
+
+        QByteArray reply = "HTTP/1.1 " + QByteArray::number(notModified ? 304 : response->status) + " Stand-in\r\n";
+        reply += "Date: " + httpDate(QDateTime::currentDateTimeUtc()) + "\r\n";
+        reply += "Content-Type: " + response->contentType + "\r\n";
+        reply += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+        if(deflate) {
+            reply += "Content-Encoding: deflate\r\n";
+        }
+        if(!response->etag.isEmpty()) {
+            reply += "ETag: " + response->etag + "\r\n";
+        }
+        if(!response->lastModified.isEmpty()) {
+            reply += "Last-Modified: " + response->lastModified + "\r\n";
+        }
+        if(!response->cacheControl.isEmpty()) {
+            reply += "Cache-Control: " + response->cacheControl + "\r\n";
+        }
+        if(!response->retryAfter.isEmpty()) {
+            reply += "Retry-After: " + response->retryAfter + "\r\n";
+        }
+        reply += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+
+        // Content-Length still promises the whole body
+        const bool cut = response->cutAfter >= 0 && response->cutAfter < body.size();
+        if(cut) {
+            body.truncate(response->cutAfter);
+        }
+        reply += body;
+
+        m_bytesServed += body.size();
+        auto send = [socket, reply, keepAlive, cut]() {
+            socket->write(reply);
+            if(cut) {
+                // Late enough for the client to have read what was sent
+                QTimer::singleShot(50, socket, [socket]() { socket->disconnectFromHost(); });
+            }
+            else if(!keepAlive) {
+                socket->disconnectFromHost();
+            }
+        };
+        if(response->delayMs > 0) {
+            QTimer::singleShot(response->delayMs, socket, send);
+        }
+        else {
+            send();
+        }
+    }
+
+    static QByteArray httpDate(const QDateTime& time)
+    {
+        return QLocale::c().toString(time, QStringLiteral("ddd, dd MMM yyyy hh:mm:ss 'GMT'")).toLatin1();
+    }
+
+    QTcpServer m_server;
+    QList<Handler> m_routes;
+    QList<QUrl> m_requests;
+    QList<Headers> m_requestHeaders;
+    qint64 m_bytesServed{0};
+    int m_connections{0};
+    bool m_keepAlive{false};
+    bool m_compression{false};
+};
@@ -0,0 +1,192 @@
+// Runs HttpClient requests against a local stand-in server and checks that
+// each outcome reaches only the object that asked for it: success with
+// status, headers and body, HTTP and network errors as typed failures,
+// several requests in flight for one requester, cancellation, and
+// compressed bodies over a kept-alive connection.
+
+#include "standinserver.h"
+
+#include "core/httpclient.h"
+#include "core/httprequest.h"
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QPointer>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTimer>
+#include <QDebug>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+int failures{0};
+
+void check(bool condition, const char* what)
+{
+    qInfo().noquote() << (condition ? "  ok   " : "  FAIL ") << what;
+    if(!condition) {
+        ++failures;
+    }
+}
+
+// Counts what reaches one requester
+class Requester : public QObject
+{
+public:
+    void request(HttpClient& client, const QUrl& url)
+    {
+        HttpRequest* request = client.get(url, this);
+        ++pending;
+        connect(request, &HttpRequest::succeeded, this, [this](const HttpResponse& response) {
+            responses.append(response);
+            --pending;
+        });
+        connect(request, &HttpRequest::failed, this, [this](const HttpError& error) {
+            errors.append(error);
+            --pending;
+        });
+    }
+
+    int pending{0};
+    QList<HttpResponse> responses;
+    QList<HttpError> errors;
+};
+
+void waitFor(const std::function<bool()>& done)
+{
+    QEventLoop loop;
+    QTimer poll;
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+        if(done()) {
+            loop.quit();
+        }
+    });
+    poll.start(5);
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStandardPaths::setTestModeEnabled(true);
+
+    StandInServer server;
+    if(!server.listen()) {
+        qWarning() << "Could not start the stand-in server";
+        return 1;
+    }
+    server.route(QStringLiteral("/release/a"), {}, {200, "application/json", "{\"id\":\"a\"}", "\"a1\"", {}, {}});
+    server.route(QStringLiteral("/release/b"), {}, {200, "application/json", "{\"id\":\"b\"}", {}, {}, {}});
+    server.route(QStringLiteral("/missing"), {}, {404, "application/json", "{\"error\":\"Not Found\"}", {}, {}, {}});
+
+    auto at = [&server](const QString& path) {
+        QUrl url = server.url();
+        url.setPath(path);
+        return url;
+    };
+
+    HttpClient client;
+    client.setCacheDirectory({});
+
+    qInfo() << "Targeted delivery";
+    {
+        Requester first;
+        Requester second;
+        first.request(client, at(QStringLiteral("/release/a")));
+        first.request(client, at(QStringLiteral("/release/b")));
+        second.request(client, at(QStringLiteral("/release/b")));
+        waitFor([&]() { return first.pending == 0 && second.pending == 0; });
+
+        check(first.responses.size() == 2 && first.errors.isEmpty(), "two requests in flight for one requester");
+        check(second.responses.size() == 1 && second.responses.constFirst().body == "{\"id\":\"b\"}",
+              "the other requester got only its own reply");
+
+        const auto a = std::find_if(first.responses.cbegin(), first.responses.cend(), [](const HttpResponse& r) {
+            return r.url.path() == QLatin1String("/release/a");
+        });
+        check(a != first.responses.cend() && a->statusCode == 200 && a->body == "{\"id\":\"a\"}", "status and body");
+        check(a != first.responses.cend() && a->header("etag") == "\"a1\"", "headers, looked up in any case");
+    }
+
+    qInfo() << "Typed failures";
+    {
+        Requester requester;
+        requester.request(client, at(QStringLiteral("/missing")));
+
+        // A port nobody listens on
+        QTcpServer closed;
+        closed.listen(QHostAddress::LocalHost);
+        QUrl refused = server.url();
+        refused.setPort(closed.serverPort());
+        closed.close();
+        requester.request(client, refused);
+
+        waitFor([&]() { return requester.pending == 0; });
+        check(requester.responses.isEmpty() && requester.errors.size() == 2, "both failed");
+
+        const auto notFound = std::find_if(requester.errors.cbegin(), requester.errors.cend(),
+                                           [](const HttpError& error) { return error.statusCode == 404; });
+        check(notFound != requester.errors.cend() && notFound->kind == HttpError::Kind::Http, "404 is an HTTP error");
+        const auto network = std::find_if(requester.errors.cbegin(), requester.errors.cend(),
+                                          [](const HttpError& error) { return error.statusCode == 0; });
+        check(network != requester.errors.cend() && network->kind == HttpError::Kind::Network
+                  && network->code == QNetworkReply::ConnectionRefusedError,
+              "refused connection is a network error");
+    }
+
+    qInfo() << "Cancellation";
+    {
+        Requester requester;
+        requester.request(client, at(QStringLiteral("/release/a")));
+        QPointer<HttpRequest> request = requester.findChild<HttpRequest*>();
+        check(request && request->isQueued(), "queued until the event loop runs");
+        request->cancel();
+
+        QEventLoop loop;
+        QTimer::singleShot(200, &loop, &QEventLoop::quit);
+        loop.exec();
+        check(requester.responses.isEmpty() && requester.errors.isEmpty(), "no signals after cancel");
+        check(!request, "request deleted");
+    }
+
+    qInfo() << "Compression and keep-alive";
+    {
+        const QByteArray page = QByteArray("<table><tr><td>Machana Paatheengala</td></tr></table>").repeated(200);
+        server.clear();
+        server.route(QStringLiteral("/wiki/page"), {}, {200, "text/html", page, {}, {}, {}});
+        server.setCompression(true);
+        server.setKeepAlive(true);
+
+        Requester requester;
+        requester.request(client, at(QStringLiteral("/wiki/page")));
+        waitFor([&]() { return requester.pending == 0; });
+        requester.request(client, at(QStringLiteral("/wiki/page")));
+        waitFor([&]() { return requester.pending == 0; });
+
+        check(requester.responses.size() == 2 && requester.responses.constLast().body == page,
+              "deflated body arrives decoded");
+        check(server.requestHeaders().constFirst().value("accept-encoding").contains("deflate"), "deflate offered");
+        check(server.bytesServed() < page.size() / 2, "fewer bytes on the wire");
+        check(server.connections() == 1, "second request reused the connection");
+        check(client.transferStats().bodyBytes >= 2 * page.size(), "transfer stats count the decoded bodies");
+
+        server.clear();
+        server.route(QStringLiteral("/wiki/page"), {}, {200, "text/html", page, {}, {}, {}});
+        client.setCompressionEnabled(false);
+        client.setKeepAliveEnabled(false);
+        requester.request(client, at(QStringLiteral("/wiki/page")));
+        waitFor([&]() { return requester.pending == 0; });
+        check(requester.responses.size() == 3 && requester.responses.constLast().body == page, "identity body");
+        check(server.requestHeaders().constFirst().value("accept-encoding") == "identity"
+                  && server.requestHeaders().constFirst().value("connection") == "close",
+              "both can be turned off");
+        check(server.bytesServed() == page.size(), "sent as is");
+    }
+
+    qInfo().noquote() << (failures == 0 ? "All checks passed" : QStringLiteral("%1 check(s) failed").arg(failures));
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,453 @@
+// Checks title normalization and Jaro-Winkler against reference values,
+// that every batch kernel gives the scalar result, the bit-parallel edit
+// distance against the textbook one and the word set channel on titles
+// with asides, that the assignment solver finds the best total score (compared with
+// trying every permutation), that pairs with impossible durations are left
+// out, what precomputed track features add, that titles in Indic scripts
+// find their romanized spellings, and that a box set of a few hundred
+// tracks is matched quickly.
+
+#include "core/editdistance.h"
+#include "core/matchingengine.h"
+#include "core/titlebatch.h"
+#include "core/trackfeatures.h"
+#include "core/transliteration.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+namespace {
+int failures{0};
+
+void check(bool condition, const char* what)
+{
+    qInfo().noquote() << (condition ? "  ok   " : "  FAIL ") << what;
+    if(!condition) {
+        ++failures;
+    }
+}
+
+bool near(double a, double b)
+{
+    return std::abs(a - b) < 0.001;
+}
+
+double total(const QList<double>& scores, qsizetype cols, const QList<int>& assigned)
+{
+    double sum{0.0};
+    for(qsizetype i = 0; i < assigned.size(); ++i) {
+        if(assigned[i] >= 0) {
+            sum += scores[i * cols + assigned[i]];
+        }
+    }
+    return sum;
+}
+
+// Best total over every way of giving rows distinct columns
+double bruteForce(const QList<double>& scores, qsizetype rows, qsizetype cols)
+{
+    const qsizetype slots = std::max(rows, cols);
+    QList<int> columns(slots);
+    std::iota(columns.begin(), columns.end(), 0);
+
+    double best{0.0};
+    do {
+        double sum{0.0};
+        for(qsizetype i = 0; i < rows; ++i) {
+            if(columns[i] < cols) {
+                sum += scores[i * cols + columns[i]];
+            }
+        }
+        best = std::max(best, sum);
+    } while(std::next_permutation(columns.begin(), columns.end()));
+    return best;
+}
+
+// Wagner-Fischer, one row at a time
+qsizetype textbookDistance(const QString& a, const QString& b)
+{
+    QList<qsizetype> row(b.size() + 1);
+    std::iota(row.begin(), row.end(), 0);
+    for(qsizetype i = 1; i <= a.size(); ++i) {
+        qsizetype diagonal = row[0];
+        row[0] = i;
+        for(qsizetype j = 1; j <= b.size(); ++j) {
+            const qsizetype above = row[j];
+            row[j] = std::min({above + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0 : 1)});
+            diagonal = above;
+        }
+    }
+    return row[b.size()];
+}
+
+bool distinct(const QList<int>& assigned)
+{
+    QList<int> used;
+    for(const int col : assigned) {
+        if(col >= 0) {
+            if(used.contains(col)) {
+                return false;
+            }
+            used.append(col);
+        }
+    }
+    return true;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    qInfo() << "Titles";
+    {
+        check(MatchingEngine::normalizeTitle(QStringLiteral("01 - Raja Raja Chozhan"))
+                  == QLatin1String("raja raja chozhan"),
+              "track number and case dropped");
+        check(MatchingEngine::normalizeTitle(QStringLiteral("3. Poo Maalaiyae (Duet)"))
+                  == QLatin1String("poo maalaiyae"),
+              "bracketed aside dropped");
+        check(MatchingEngine::normalizeTitle(QStringLiteral("\"Kanmani\" - Anbodu"))
+                  == QLatin1String("kanmani anbodu"),
+              "quotes and dashes become single spaces");
+        check(MatchingEngine::normalizeTitle(QStringLiteral("(Interlude)")) == QLatin1String("interlude"),
+              "a title that is only an aside keeps it");
+        check(MatchingEngine::normalizeTitle(QStringLiteral("1999")) == QLatin1String("1999"),
+              "a year is not a track number");
+    }
+
+    qInfo() << "Jaro-Winkler";
+    {
+        check(near(MatchingEngine::jaroWinkler(u"MARTHA", u"MARHTA"), 0.961), "MARTHA / MARHTA");
+        check(near(MatchingEngine::jaroWinkler(u"DWAYNE", u"DUANE"), 0.84), "DWAYNE / DUANE");
+        check(near(MatchingEngine::jaroWinkler(u"DIXON", u"DICKSONX"), 0.813), "DIXON / DICKSONX");
+        check(MatchingEngine::jaroWinkler(u"abc", u"abc") == 1.0, "identical");
+        check(MatchingEngine::jaroWinkler(u"abc", u"xyz") == 0.0, "nothing in common");
+        check(MatchingEngine::jaroWinkler(u"", u"abc") == 0.0, "empty");
+    }
+
+    qInfo() << "Batch kernels";
+    {
+        // Short alphabet for plenty of matches and transpositions; some titles longer than a slot
+        const std::u16string alphabet = u"abcde \u00e9\u0b95\u0bbe";
+        std::mt19937 random(3);
+        std::uniform_int_distribution<qsizetype> letter(0, static_cast<qsizetype>(alphabet.size()) - 1);
+        auto randomTitle = [&](qsizetype length) {
+            QString title;
+            for(qsizetype i = 0; i < length; ++i) {
+                title += QChar(alphabet[static_cast<std::size_t>(letter(random))]);
+            }
+            return title;
+        };
+
+        QList<QString> titles;
+        for(qsizetype length = 0; length <= TitleBatch::SlotWidth + 6; ++length) {
+            titles.append(randomTitle(length));
+            titles.append(randomTitle(length));
+        }
+        QList<QString> queries{titles[20], titles[21].left(10) + titles[30].mid(10)};
+        for(qsizetype length : {1, 3, 8, 17, 33, 50, 64, 65, 80}) {
+            queries.append(randomTitle(length));
+        }
+
+        for(const auto kernel : {TitleBatch::Kernel::Scalar, TitleBatch::Kernel::Sse2, TitleBatch::Kernel::Avx2}) {
+            if(!TitleBatch::isSupported(kernel)) {
+                qInfo() << "  kernel" << static_cast<int>(kernel) << "not available here";
+                continue;
+            }
+            const TitleBatch batch(titles, kernel);
+            bool exact{true};
+            QList<double> scores;
+            for(const QString& query : queries) {
+                batch.jaroWinkler(query, scores);
+                for(qsizetype j = 0; j < titles.size(); ++j) {
+                    exact = exact && scores[j] == MatchingEngine::jaroWinkler(query, titles[j]);
+                }
+            }
+            check(exact && batch.kernel() == kernel, "batch scores identical to the scalar ones");
+        }
+
+        const TitleBatch batch({QStringLiteral("abc"), QStringLiteral("abd")});
+        QList<double> scores;
+        batch.jaroWinkler(u"abc", scores, {false, true});
+        check(scores == QList<double>{1.0, 0.0}, "skipped titles score 0");
+    }
+
+    qInfo() << "Edit distance";
+    {
+        check(EditDistance::distance(u"kitten", u"sitting") == 3, "kitten / sitting");
+        check(EditDistance::distance(u"", u"abc") == 3 && EditDistance::distance(u"abc", u"") == 3, "empty");
+        check(EditDistance(u"flaw").similarity(u"lawn") == 0.5, "similarity from the longer length");
+
+        std::mt19937 random(5);
+        const std::u16string alphabet = u"abcd \u0b95";
+        auto randomText = [&](qsizetype length) {
+            QString text;
+            for(qsizetype i = 0; i < length; ++i) {
+                text += QChar(alphabet[random() % alphabet.size()]);
+            }
+            return text;
+        };
+        bool oneBlock{true};
+        bool severalBlocks{true};
+        for(int round = 0; round < 400; ++round) {
+            const QString a = randomText(static_cast<qsizetype>(random() % 64) + 1);
+            const QString b = randomText(static_cast<qsizetype>(random() % 80));
+            oneBlock = oneBlock && EditDistance(a).distance(b) == textbookDistance(a, b);
+            const QString longA = randomText(static_cast<qsizetype>(random() % 200) + 65);
+            const QString longB = randomText(static_cast<qsizetype>(random() % 200));
+            severalBlocks = severalBlocks && EditDistance(longA).distance(longB) == textbookDistance(longA, longB);
+        }
+        check(oneBlock, "one block matches the textbook distance");
+        check(severalBlocks, "several blocks match the textbook distance");
+    }
+
+    qInfo() << "Word sets";
+    {
+        check(MatchingEngine::wordSetSimilarity(QStringLiteral("Kanmani Anbodu"), QStringLiteral("Anbodu Kanmani"))
+                  == 1.0,
+              "word order does not matter");
+        check(MatchingEngine::wordSetSimilarity(QStringLiteral("Kanmani"),
+                                                QStringLiteral("Kanmani (From \"Guna\")"))
+                  == 1.0,
+              "an extra aside costs nothing");
+        const double female = MatchingEngine::wordSetSimilarity(QStringLiteral("Poove (Female Version)"),
+                                                                QStringLiteral("Poove (Female Version)"));
+        const double male = MatchingEngine::wordSetSimilarity(QStringLiteral("Poove (Female Version)"),
+                                                              QStringLiteral("Poove (Male Version)"));
+        check(female == 1.0 && male < 1.0 && male > 0.8, "asides still tell versions apart");
+        check(MatchingEngine::wordSetSimilarity(QStringLiteral("Intro"), QStringLiteral("Theme")) == 0.0,
+              "nothing in common");
+
+        MatchingEngine engine;
+        const QList<MatchingEngine::Track> local{{QStringLiteral("Poove (Male Version)"), 0},
+                                                 {QStringLiteral("Poove (Female Version)"), 0}};
+        const QList<MatchingEngine::Track> fetched{{QStringLiteral("Poove (Female Version)"), 0},
+                                                   {QStringLiteral("Poove (Male Version)"), 0}};
+        const QList<MatchingEngine::Match> matches = engine.match(local, fetched);
+        check(matches[0].index == 1 && matches[1].index == 0, "versions paired by their asides");
+    }
+
+    qInfo() << "Assignment";
+    {
+        // Walking the rows in order, row 0 takes column 0 and leaves row 1 with 0.1
+        const QList<double> scores{0.9, 0.85, 0.8, 0.1};
+        check(MatchingEngine::solve(scores, 2, 2) == QList<int>{1, 0}, "an early pick gives way to a better total");
+
+        std::mt19937 random(7);
+        std::uniform_real_distribution<double> value(0.0, 1.0);
+        bool optimal{true};
+        bool valid{true};
+        for(int round = 0; round < 200; ++round) {
+            const qsizetype rows = 1 + round % 6;
+            const qsizetype cols = 1 + (round / 6) % 6;
+            QList<double> matrix(rows * cols);
+            for(double& score : matrix) {
+                // Some pairs ruled out entirely
+                score = value(random) < 0.2 ? 0.0 : value(random);
+            }
+            const QList<int> assigned = MatchingEngine::solve(matrix, rows, cols);
+            valid = valid && assigned.size() == rows && distinct(assigned);
+            optimal = optimal && std::abs(total(matrix, cols, assigned) - bruteForce(matrix, rows, cols)) < 1e-9;
+        }
+        check(valid, "every row gets a distinct column or none");
+        check(optimal, "best total on square and rectangular matrices");
+        check(MatchingEngine::solve({0.0, 0.0}, 1, 2) == QList<int>{-1}, "nothing assigned for zero scores");
+    }
+
+    qInfo() << "Durations";
+    {
+        MatchingEngine engine;
+        const QList<MatchingEngine::Track> local{{QStringLiteral("Intro"), 60}, {QStringLiteral("Theme"), 300}};
+        const QList<MatchingEngine::Track> fetched{{QStringLiteral("Theme"), 62}, {QStringLiteral("Intro"), 301}};
+        const QList<MatchingEngine::Match> matches = engine.match(local, fetched);
+        check(matches[0].index == 0 && matches[1].index == 1 && matches[0].titleSimilarity == 0.0,
+              "same titles with impossible durations never paired");
+
+        const QList<MatchingEngine::Track> unknown{{QStringLiteral("Theme"), 0}, {QStringLiteral("Intro"), 0}};
+        const QList<MatchingEngine::Match> byTitle = engine.match(local, unknown);
+        check(byTitle[0].index == 1 && byTitle[1].index == 0, "titles decide where durations are unknown");
+        check(!byTitle[0].durationMatches && byTitle[0].confidence == 1.0, "full confidence from the title alone");
+
+        const QList<MatchingEngine::Track> close{{QStringLiteral("Intro"), 62}, {QStringLiteral("Theme"), 330}};
+        const QList<MatchingEngine::Match> closeMatches = engine.match(local, close);
+        check(closeMatches[0].durationMatches && closeMatches[0].confidence == 1.0, "within the tolerance");
+        check(!closeMatches[1].durationMatches && closeMatches[1].confidence < 1.0 && closeMatches[1].index == 1,
+              "further off scores lower");
+    }
+
+    qInfo() << "Features";
+    {
+        MatchingEngine engine;
+        const QList<MatchingEngine::Track> fetched{{QStringLiteral("Vaanam"), 0}, {QStringLiteral("Nilave Vaa"), 0}};
+
+        TrackFeatures placeholders;
+        placeholders.append(QStringLiteral("Track 1"), 0, 0, 0, QStringLiteral("Nilave Vaa"));
+        placeholders.append(QStringLiteral("Track 2"), 0, 0, 0, QStringLiteral("Vaanam"));
+        const QList<MatchingEngine::Match> byFileName = engine.match(placeholders, fetched);
+        check(byFileName[0].index == 1 && byFileName[1].index == 0, "file names make up for placeholder titles");
+
+        TrackFeatures named;
+        named.append(QStringLiteral("Vaanam"), 0, 0, 0, QStringLiteral("Vaanam"));
+        check(named.fileNameWords().constFirst().isEmpty(), "file names repeating the title are not kept");
+
+        const QList<MatchingEngine::Track> themes{{QStringLiteral("Theme"), 0, 1}, {QStringLiteral("Theme"), 0, 2}};
+        TrackFeatures numbered;
+        numbered.append(QStringLiteral("Theme"), 0, 2, 0, {});
+        numbered.append(QStringLiteral("Theme"), 0, 1, 0, {});
+        const QList<MatchingEngine::Match> byNumber = engine.match(numbered, themes);
+        check(byNumber[0].index == 1 && byNumber[1].index == 0, "equal titles keep their track numbers");
+
+        const QList<MatchingEngine::Track> local{{QStringLiteral("Intro"), 60, 1}, {QStringLiteral("Theme"), 300, 2}};
+        TrackFeatures features;
+        for(const auto& track : local) {
+            features.append(track.title, track.durationSeconds, track.trackNumber, 0, {});
+        }
+        const QList<MatchingEngine::Match> fromTracks = engine.match(local, themes);
+        const QList<MatchingEngine::Match> fromFeatures = engine.match(features, themes);
+        bool same{true};
+        for(qsizetype i = 0; i < local.size(); ++i) {
+            same = same && fromTracks[i].index == fromFeatures[i].index
+                && fromTracks[i].confidence == fromFeatures[i].confidence;
+        }
+        check(same, "tracks and their features match alike");
+    }
+
+    qInfo() << "Scripts";
+    {
+        const auto sameKey = [](const QString& a, const QString& b) {
+            return Transliteration::phoneticKey(MatchingEngine::normalizeTitle(a))
+                == Transliteration::phoneticKey(MatchingEngine::normalizeTitle(b));
+        };
+        check(sameKey(QStringLiteral("ரஞ்சிதமே"), QStringLiteral("Ranjithame")), "Tamil");
+        check(sameKey(QStringLiteral("தமிழ்"), QStringLiteral("Tamil"))
+                  && sameKey(QStringLiteral("தமிழ்"), QStringLiteral("Tamizh")),
+              "Tamil zh as l");
+        check(sameKey(QStringLiteral("காற்று"), QStringLiteral("Kaatru")), "Tamil rr as tr");
+        check(sameKey(QStringLiteral("సామజవరగమన"), QStringLiteral("Samajavaragamana")), "Telugu");
+        check(sameKey(QStringLiteral("तुम ही हो"), QStringLiteral("Tum Hi Ho")), "Devanagari");
+        check(Transliteration::romanize(QStringLiteral("दिलबर")) == QLatin1String("dilbar")
+                  && Transliteration::romanize(QStringLiteral("कमल")) == QLatin1String("kamal"),
+              "unspoken inherent vowels dropped in Hindi");
+        check(Transliteration::hasIndicLetters(QStringLiteral("ரஞ்சிதமே"))
+                  && !Transliteration::hasIndicLetters(QStringLiteral("Ranjithame")),
+              "Indic letters found");
+
+        MatchingEngine engine;
+        const QList<MatchingEngine::Track> tamil{{QStringLiteral("ரஞ்சிதமே"), 0},
+                                                 {QStringLiteral("தீ தளபதி"), 0},
+                                                 {QStringLiteral("ஜிமிக்கி பொண்ணு"), 0}};
+        const QList<MatchingEngine::Track> romanized{{QStringLiteral("Jimikki Ponnu"), 0},
+                                                     {QStringLiteral("Ranjithame"), 0},
+                                                     {QStringLiteral("Thee Thalapathy"), 0}};
+        const QList<MatchingEngine::Match> matches = engine.match(tamil, romanized);
+        check(matches[0].index == 1 && matches[1].index == 2 && matches[2].index == 0,
+              "script titles paired with their romanized ones");
+        check(matches[0].titleSimilarity > 0.8 && matches[0].titleSimilarity < 1.0,
+              "a phonetic match scores below the same spelling");
+
+        const QList<MatchingEngine::Match> latin
+            = engine.match({{QStringLiteral("Bala"), 0}}, {{QStringLiteral("Pala"), 0}});
+        const double expected = 0.5 * MatchingEngine::jaroWinkler(u"bala", u"pala")
+                              + 0.5 * MatchingEngine::wordSetSimilarity(QStringLiteral("Bala"), QStringLiteral("Pala"));
+        check(latin[0].titleSimilarity == expected, "keys not compared between titles in the same script");
+
+        // An album of 100 Tamil titles against their romanized spellings, shuffled
+        const QStringList consonants{QStringLiteral("க"), QStringLiteral("ச"), QStringLiteral("த"),
+                                     QStringLiteral("ந"), QStringLiteral("ப"), QStringLiteral("ம"),
+                                     QStringLiteral("ர"), QStringLiteral("ல"), QStringLiteral("வ"),
+                                     QStringLiteral("ழ")};
+        const QStringList vowelSigns{{},
+                                     QStringLiteral("ா"),
+                                     QStringLiteral("ி"),
+                                     QStringLiteral("ு"),
+                                     QStringLiteral("ெ"),
+                                     QStringLiteral("ை"),
+                                     QStringLiteral("்")};
+        std::mt19937 random(5);
+        std::uniform_int_distribution<qsizetype> consonant(0, consonants.size() - 1);
+        std::uniform_int_distribution<qsizetype> vowelSign(0, vowelSigns.size() - 1);
+        std::uniform_int_distribution<int> length(3, 6);
+
+        QList<MatchingEngine::Track> local;
+        QStringList keys;
+        while(local.size() < 100) {
+            QString title;
+            for(int syllable = length(random); syllable > 0; --syllable) {
+                title += consonants.at(consonant(random)) + vowelSigns.at(vowelSign(random));
+            }
+            const QString key = Transliteration::phoneticKey(title);
+            if(!keys.contains(key)) {
+                keys.append(key);
+                local.append({title, 0});
+            }
+        }
+        QList<int> order(local.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), random);
+        QList<MatchingEngine::Track> fetched;
+        for(const int index : order) {
+            fetched.append({Transliteration::romanize(local[index].title), 0});
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        const QList<MatchingEngine::Match> albumMatches = engine.match(local, fetched);
+        const qint64 elapsed = timer.elapsed();
+
+        bool correct{true};
+        for(qsizetype j = 0; j < order.size(); ++j) {
+            correct = correct && albumMatches[order[j]].index == j;
+        }
+        qInfo() << "  100 x 100 across scripts matched in" << elapsed << "ms";
+        check(correct, "every romanized title found");
+        check(elapsed < 100, "cheap enough for every pair of an album");
+    }
+
+    qInfo() << "Box set";
+    {
+        // Four discs of 60 tracks, shuffled and with a few titles spelled differently
+        QList<MatchingEngine::Track> fetched;
+        for(int i = 0; i < 240; ++i) {
+            fetched.append({QStringLiteral("Song number %1 from disc %2").arg(i % 60 + 1).arg(i / 60 + 1),
+                            150 + (i * 37) % 200});
+        }
+        QList<int> order(fetched.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), std::mt19937(11));
+
+        QList<MatchingEngine::Track> local;
+        for(const int index : order) {
+            MatchingEngine::Track track = fetched[index];
+            if(index % 10 == 0) {
+                track.title.replace(QLatin1String("number"), QLatin1String("no."));
+            }
+            track.title.prepend(QStringLiteral("%1 - ").arg(index % 60 + 1, 2, 10, QLatin1Char('0')));
+            track.durationSeconds += index % 3;
+            local.append(track);
+        }
+
+        MatchingEngine engine;
+        QElapsedTimer timer;
+        timer.start();
+        const QList<MatchingEngine::Match> matches = engine.match(local, fetched);
+        const qint64 elapsed = timer.elapsed();
+
+        bool correct{true};
+        for(qsizetype i = 0; i < matches.size(); ++i) {
+            correct = correct && matches[i].index == order[i];
+        }
+        qInfo() << "  240 x 240 matched in" << elapsed << "ms";
+        check(correct, "every track found");
+        check(elapsed < 500, "well under a second");
+    }
+
+    qInfo().noquote() << (failures == 0 ? "All checks passed" : QStringLiteral("%1 check(s) failed").arg(failures));
+    return failures == 0 ? 0 : 1;
+}
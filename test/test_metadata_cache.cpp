@@ -0,0 +1,227 @@
+// Round-trips parsed albums through the metadata cache's binary format,
+// checks that other revisions, other versions and damaged files miss,
+// and compares the time of a cache hit with parsing the page again.
+
+#include "core/metadatacache.h"
+#include "sources/wikipediaparser.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QDebug>
+
+namespace {
+int failures{0};
+
+void check(bool condition, const char* what)
+{
+    qInfo().noquote() << (condition ? "  ok   " : "  FAIL ") << what;
+    if(!condition) {
+        ++failures;
+    }
+}
+
+bool sameTrack(const Tagger::TrackMetadata& a, const Tagger::TrackMetadata& b)
+{
+    return a.title == b.title && a.artist == b.artist && a.album == b.album && a.albumArtist == b.albumArtist
+        && a.lyricist == b.lyricist && a.composer == b.composer && a.musicDirector == b.musicDirector
+        && a.trackNumber == b.trackNumber && a.totalTracks == b.totalTracks && a.discNumber == b.discNumber
+        && a.totalDiscs == b.totalDiscs && a.year == b.year && a.durationSeconds == b.durationSeconds
+        && a.isrc == b.isrc && a.mbid == b.mbid;
+}
+
+bool sameTracks(const QList<Tagger::TrackMetadata>& a, const QList<Tagger::TrackMetadata>& b)
+{
+    return a.size() == b.size() && std::equal(a.cbegin(), a.cend(), b.cbegin(), sameTrack);
+}
+
+bool sameAlbum(const Tagger::AlbumMetadata& a, const Tagger::AlbumMetadata& b)
+{
+    if(a.album != b.album || a.albumArtist != b.albumArtist || a.musicDirector != b.musicDirector || a.year != b.year
+       || a.country != b.country || a.releaseId != b.releaseId || a.sourceUrl != b.sourceUrl || a.source != b.source
+       || !sameTracks(a.tracks, b.tracks) || a.candidates.size() != b.candidates.size()) {
+        return false;
+    }
+    for(qsizetype i = 0; i < a.candidates.size(); ++i) {
+        const auto& candidate = a.candidates[i];
+        if(candidate.name != b.candidates[i].name || !sameTracks(candidate.tracks, b.candidates[i].tracks)
+           || candidate.releaseId != b.candidates[i].releaseId
+           || candidate.discTrackCounts != b.candidates[i].discTrackCounts) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// What QDataStream would take for the same strings and numbers, for comparison
+qsizetype dataStreamSize(const Tagger::AlbumMetadata& album)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    auto writeTracks = [&stream](const QList<Tagger::TrackMetadata>& tracks) {
+        for(const auto& t : tracks) {
+            stream << t.title << t.artist << t.album << t.albumArtist << t.lyricist << t.composer << t.musicDirector
+                   << t.isrc << t.mbid << t.trackNumber << t.totalTracks << t.discNumber << t.totalDiscs << t.year
+                   << t.durationSeconds;
+        }
+    };
+    stream << album.album << album.albumArtist << album.musicDirector << album.country << album.releaseId
+           << album.sourceUrl << album.year;
+    writeTracks(album.tracks);
+    for(const auto& candidate : album.candidates) {
+        stream << candidate.name << candidate.releaseId << candidate.discTrackCounts;
+        writeTracks(candidate.tracks);
+    }
+    return data.size();
+}
+
+Tagger::AlbumMetadata sampleRelease()
+{
+    Tagger::AlbumMetadata album;
+    album.album = QStringLiteral("அன்னக்கிளி");
+    album.albumArtist = QStringLiteral("Ilaiyaraaja");
+    album.musicDirector = QStringLiteral("Ilaiyaraaja");
+    album.year = 1976;
+    album.country = QStringLiteral("IN");
+    album.releaseId = QStringLiteral("0f6a9c3e-5d2b-4b8e-9a71-2c4d8e9f1a23");
+    album.sourceUrl = QStringLiteral("https://musicbrainz.org/release/0f6a9c3e-5d2b-4b8e-9a71-2c4d8e9f1a23");
+    album.source = Tagger::SourceType::MusicBrainz;
+    for(int i = 1; i <= 12; ++i) {
+        Tagger::TrackMetadata track;
+        track.title = QStringLiteral("Track %1 – பாடல்").arg(i);
+        track.artist = i % 2 ? QStringLiteral("S. Janaki") : QStringLiteral("T. M. Soundararajan");
+        track.album = album.album;
+        track.albumArtist = album.albumArtist;
+        track.composer = album.musicDirector;
+        track.musicDirector = album.musicDirector;
+        track.trackNumber = i;
+        track.totalTracks = 12;
+        track.discNumber = i > 6 ? 2 : 1;
+        track.totalDiscs = 2;
+        track.year = 1976;
+        track.durationSeconds = 180 + i * 17;
+        track.mbid = QStringLiteral("9e1c2d3f-0000-4000-8000-%1").arg(i, 12, 10, QLatin1Char('0'));
+        album.tracks.append(track);
+    }
+    album.candidates.append({QStringLiteral("Disc 1"), album.tracks.mid(0, 6)});
+    album.candidates.append({QString{}, album.tracks.mid(6)});
+    album.candidates.append({QStringLiteral("2×CD, IN"), {}, QStringLiteral("5c1d2e3f-0000-4000-8000-000000000001"),
+                             {7, 5}});
+    return album;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStandardPaths::setTestModeEnabled(true);
+
+    QTemporaryDir directory;
+    if(!directory.isValid()) {
+        return 1;
+    }
+    MetadataCache cache(directory.path());
+
+    const QString releaseKey = QStringLiteral("https://musicbrainz.org/ws/2/release/0f6a9c3e?fmt=json");
+    const Tagger::AlbumMetadata release = sampleRelease();
+
+    qInfo() << "Binary format";
+    {
+        const QByteArray data
+            = MetadataCache::encode({Tagger::SourceType::MusicBrainz, releaseKey, QStringLiteral("etag:1"), release});
+        const auto entry = MetadataCache::decode(data);
+        check(entry.has_value(), "decodes");
+        check(entry && entry->key == releaseKey && entry->revision == QLatin1String("etag:1"), "key and revision");
+        check(entry && sameAlbum(entry->metadata, release), "every field survives, candidates and Tamil included");
+        check(data.size() * 3 < dataStreamSize(release), "well under a third of the QDataStream size");
+        qInfo().noquote() << QStringLiteral("  %1 bytes, QDataStream %2").arg(data.size()).arg(dataStreamSize(release));
+
+        QByteArray truncated = data;
+        truncated.chop(1);
+        check(!MetadataCache::decode(truncated), "truncated data rejected");
+        check(!MetadataCache::decode(data + 'x'), "trailing data rejected");
+
+        QByteArray otherVersion = data;
+        otherVersion[4] = 1;
+        check(!MetadataCache::decode(otherVersion), "other format version rejected");
+
+        bool survived{true};
+        for(qsizetype i = 4; i < data.size(); ++i) {
+            QByteArray damaged = data;
+            damaged[i] = static_cast<char>(damaged[i] ^ 0xFF);
+            if(const auto decoded = MetadataCache::decode(damaged); decoded && decoded->metadata.tracks.size() > 1000) {
+                survived = false;
+            }
+        }
+        check(survived, "damaged bytes never decode into huge lists");
+    }
+
+    qInfo() << "Lookups";
+    {
+        cache.store(Tagger::SourceType::MusicBrainz, releaseKey, QStringLiteral("etag:1"), release);
+        const auto hit = cache.lookup(Tagger::SourceType::MusicBrainz, releaseKey, QStringLiteral("etag:1"));
+        check(hit && sameAlbum(*hit, release), "hit returns the stored album");
+        check(!cache.lookup(Tagger::SourceType::MusicBrainz, releaseKey, QStringLiteral("etag:2")),
+              "other revision misses");
+        check(!cache.lookup(Tagger::SourceType::Wikipedia, releaseKey, QStringLiteral("etag:1")),
+              "other source misses");
+
+        cache.store(Tagger::SourceType::MusicBrainz, releaseKey, QStringLiteral("etag:2"), release);
+        check(!cache.lookup(Tagger::SourceType::MusicBrainz, releaseKey, QStringLiteral("etag:1")),
+              "newer revision replaces it");
+
+        const QStringList files = QDir(directory.path()).entryList(QDir::Files);
+        for(const QString& file : files) {
+            QFile damaged(directory.filePath(file));
+            if(damaged.open(QIODevice::WriteOnly)) {
+                damaged.write("FTMC\x01garbage");
+            }
+        }
+        check(!cache.lookup(Tagger::SourceType::MusicBrainz, releaseKey, QStringLiteral("etag:2")),
+              "damaged file misses");
+
+        cache.clear();
+        check(QDir(directory.path()).entryList(QDir::Files).isEmpty(), "clear removes the files");
+    }
+
+    qInfo() << "Hit versus parse";
+    {
+        QFile file(QStringLiteral(TAGGER_SOURCE_DIR "/annakili.html"));
+        if(!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "Could not open" << file.fileName();
+            return 1;
+        }
+        const QByteArray page = file.readAll();
+        const QString url = QStringLiteral("https://en.wikipedia.org/wiki/Annakili_(soundtrack)");
+        const Tagger::AlbumMetadata parsed = WikipediaParser::parsePage(page, url);
+        cache.store(Tagger::SourceType::Wikipedia, url, QStringLiteral("rev:1"), parsed);
+
+        constexpr int rounds = 200;
+        QElapsedTimer timer;
+        timer.start();
+        bool allHits{true};
+        for(int i = 0; i < rounds; ++i) {
+            allHits &= cache.lookup(Tagger::SourceType::Wikipedia, url, QStringLiteral("rev:1")).has_value();
+        }
+        const double lookupUs = static_cast<double>(timer.nsecsElapsed()) / 1000.0 / rounds;
+
+        timer.restart();
+        for(int i = 0; i < rounds; ++i) {
+            WikipediaParser::parsePage(page, url);
+        }
+        const double parseUs = static_cast<double>(timer.nsecsElapsed()) / 1000.0 / rounds;
+
+        check(allHits, "every lookup hits");
+        check(lookupUs < 1000.0, "a hit takes well under a millisecond");
+        qInfo().noquote() << QStringLiteral("  cache hit %1 us, parsing the page %2 us")
+                                 .arg(lookupUs, 0, 'f', 1)
+                                 .arg(parseUs, 0, 'f', 1);
+    }
+
+    qInfo().noquote() << (failures == 0 ? "All checks passed" : QStringLiteral("%1 check(s) failed").arg(failures));
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+// Feeds hand-written MusicBrainz replies to the streaming parser: the
+// fields it maps, string escapes, members in any order, the artist
+// fallbacks, the releases of a group as candidates, and malformed JSON.
+
+#include "sources/jsonreader.h"
+#include "sources/musicbrainzparser.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+
+namespace {
+int failures{0};
+
+void check(bool condition, const char* what)
+{
+    qInfo().noquote() << (condition ? "  ok   " : "  FAIL ") << what;
+    if(!condition) {
+        ++failures;
+    }
+}
+
+const QByteArray Release = R"({
+    "id": "r1", "title": "Annakili", "country": "IN", "date": "1976-05-14",
+    "artist-credit": [{"name": "I.", "artist": {"id": "a1", "name": "Ilaiyaraaja"}},
+                      {"joinphrase": "", "artist": {"name": "Gangai Amaran"}}],
+    "label-info": [{"label": {"name": "EMI", "aliases": [{"name": "}]\"{["}]}}],
+    "media": [
+        {"position": 1, "tracks": [
+            {"position": 1, "title": "Machana Paatheengala", "length": 265000,
+             "artist-credit": [{"artist": {"name": "S. Janaki"}}],
+             "recording": {"id": "m1", "artist-credit": [{"artist": {"name": "Someone else"}}]}},
+            {"position": 2, "title": "Annakili Unnai Theduthe", "length": null,
+             "recording": {"id": "m2", "artist-credit": [{"artist": {"name": "S. Janaki"}},
+                                                         {"artist": {"name": "T. M. Soundararajan"}}]}}
+        ]},
+        {"position": 2, "tracks": [
+            {"position": 1.0, "title": "Suttum Vizhi", "length": 1.8e5, "recording": {"id": "m3"}}
+        ]}
+    ]
+})";
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    qInfo() << "Reader";
+    {
+        JsonReader reader(R"( {"a" : [1, -2.5e3, true, null, "x\"y"], "b": {}} )");
+        using T = JsonReader::TokenType;
+        const QList<T> expected{T::BeginObject, T::Key,      T::BeginArray, T::Number,      T::Number,
+                                T::Bool,        T::Null,     T::String,     T::EndArray,    T::Key,
+                                T::BeginObject, T::EndObject, T::EndObject, T::End};
+        QList<T> tokens;
+        for(T type = reader.next();; type = reader.next()) {
+            tokens.append(type);
+            if(type == T::End || type == T::Error) {
+                break;
+            }
+        }
+        check(tokens == expected, "tokens in document order");
+
+        check(JsonReader::unescape(R"(tab\there \"q\" \\ \/ é)") == QStringLiteral("tab\there \"q\" \\ / é"),
+              "escapes");
+        check(JsonReader::unescape(R"(\ud83c\udfb5)") == QStringLiteral("\U0001F3B5"), "surrogate pair");
+
+        JsonReader skipping(R"({"skip": {"x": ["]", "}", {"y": "\"]"}]}, "keep": 7})");
+        skipping.next();
+        skipping.next();
+        skipping.next();
+        skipping.skip();
+        check(skipping.next() == T::Key && skipping.raw() == "keep" && skipping.next() == T::Number
+                  && skipping.toInt() == 7,
+              "skip() passes brackets inside strings");
+    }
+
+    qInfo() << "Release";
+    {
+        const MusicBrainzParser::Result result = MusicBrainzParser::parseRelease(Release);
+        const Tagger::AlbumMetadata& album = result.metadata;
+        check(result.error.isEmpty(), "no error");
+        check(album.releaseId == QLatin1String("r1") && album.album == QLatin1String("Annakili")
+                  && album.country == QLatin1String("IN") && album.year == 1976,
+              "album fields");
+        check(album.albumArtist == QLatin1String("Ilaiyaraaja, Gangai Amaran"), "credited artist names joined");
+        check(album.sourceUrl == QLatin1String("https://musicbrainz.org/release/r1"), "source URL");
+        check(album.tracks.size() == 3, "tracks of both discs");
+        if(album.tracks.size() == 3) {
+            const Tagger::TrackMetadata& first = album.tracks.at(0);
+            const Tagger::TrackMetadata& second = album.tracks.at(1);
+            const Tagger::TrackMetadata& third = album.tracks.at(2);
+            check(first.title == QLatin1String("Machana Paatheengala") && first.trackNumber == 1
+                      && first.durationSeconds == 265 && first.mbid == QLatin1String("m1"),
+                  "track fields");
+            check(first.artist == QLatin1String("S. Janaki"), "track credit preferred over the recording's");
+            check(second.artist == QLatin1String("S. Janaki, T. M. Soundararajan") && second.durationSeconds == 0,
+                  "recording credit when the track has none");
+            check(third.artist == album.albumArtist, "album artist when neither has one");
+            check(third.trackNumber == 1 && third.durationSeconds == 180, "whole numbers written as doubles");
+            check(first.totalTracks == 2 && third.totalTracks == 1 && third.discNumber == 2 && third.totalDiscs == 2,
+                  "disc numbering");
+            check(third.album == album.album && third.albumArtist == album.albumArtist && third.year == 1976,
+                  "album fields copied to tracks filled in after the whole reply");
+        }
+    }
+
+    qInfo() << "Member order";
+    {
+        // Same release with the album's members after its media
+        const QByteArray reordered = R"({"media": [{"tracks": [{"recording": {"id": "m1"}, "title": "T"}]}],
+                                         "date": "1976", "title": "Annakili",
+                                         "artist-credit": [{"artist": {"name": "Ilaiyaraaja"}}], "id": "r1"})";
+        const Tagger::AlbumMetadata album = MusicBrainzParser::parseRelease(reordered).metadata;
+        check(album.tracks.size() == 1 && album.tracks.constFirst().album == QLatin1String("Annakili")
+                  && album.tracks.constFirst().artist == QLatin1String("Ilaiyaraaja")
+                  && album.tracks.constFirst().year == 1976,
+              "album fields reach tracks read before them");
+    }
+
+    qInfo() << "Release group";
+    {
+        const QByteArray group = R"json({"id": "g1", "title": "Annakili", "first-release-date": "1976-05",
+            "artist-credit": [{"artist": {"name": "Ilaiyaraaja"}}],
+            "releases": [
+                {"id": "empty", "media": [{"tracks": []}]},
+                {"id": "nomedia"},
+                {"id": "used", "country": "IN", "media": [{"tracks": []}, {"tracks": [{"title": "Second disc"}]}]},
+                {"id": "later", "media": [{"tracks": [{"title": "Not this"}]}]},
+                {"id": "listed", "title": "Annakili (Remastered)", "country": "IN", "date": "2010",
+                 "media": [{"format": "CD", "track-count": 7}, {"format": "CD", "track-count": 5},
+                           {"format": "DVD", "track-count": 2}]}
+            ]})json";
+        const MusicBrainzParser::Result result = MusicBrainzParser::parseReleaseGroup(group);
+        const Tagger::AlbumMetadata& album = result.metadata;
+        check(result.error.isEmpty(), "no error");
+        check(album.releaseId == QLatin1String("g1") && album.year == 1976 && album.country.isEmpty()
+                  && album.sourceUrl == QLatin1String("https://musicbrainz.org/release-group/g1"),
+              "group fields");
+        check(album.tracks.size() == 1 && album.tracks.constFirst().title == QLatin1String("Second disc"),
+              "first release with tracks");
+        check(!album.tracks.isEmpty() && album.tracks.constFirst().discNumber == 2
+                  && album.tracks.constFirst().totalDiscs == 2,
+              "all of its media counted");
+
+        check(album.candidates.size() == 5, "every release is a candidate");
+        if(album.candidates.size() == 5) {
+            const Tagger::TrackListCandidate& used = album.candidates.at(2);
+            const Tagger::TrackListCandidate& listed = album.candidates.at(4);
+            check(used.releaseId == QLatin1String("used") && used.tracks.size() == 1
+                      && used.discTrackCounts == QList<int>{0, 1},
+                  "candidate with its tracks and layout");
+            check(album.candidates.at(1).discTrackCounts.isEmpty() && album.candidates.at(1).tracks.isEmpty(),
+                  "nothing known of a release without media");
+            check(listed.tracks.isEmpty() && listed.discTrackCounts == QList<int>{7, 5, 2},
+                  "layout of a release listed without tracks");
+            check(listed.name == QStringLiteral("Annakili (Remastered), 2×CD + DVD, IN, 2010"), "candidate name");
+            check(used.name == QLatin1String("IN"), "group title left out of a release's name");
+        }
+
+        const Tagger::AlbumMetadata none
+            = MusicBrainzParser::parseReleaseGroup(R"({"id": "g2", "releases": []})").metadata;
+        check(none.releaseId == QLatin1String("g2") && none.tracks.isEmpty(), "group without releases");
+    }
+
+    qInfo() << "Malformed";
+    {
+        int accepted{0};
+        for(const char* json : {"", "{\"id\": \"r1\"", "{\"id\": \"r1\",}", "{\"id\": r1}", "{\"id\": \"r1\"} x",
+                                "{\"media\": [{\"tracks\": [}]}", "{\"title\": \"bad \\q escape\"}"}) {
+            const MusicBrainzParser::Result result = MusicBrainzParser::parseRelease(json);
+            if(result.error.isEmpty() || !result.metadata.releaseId.isEmpty()) {
+                qInfo() << "    accepted:" << json;
+                ++accepted;
+            }
+        }
+        check(accepted == 0, "rejected with empty metadata");
+
+        const MusicBrainzParser::Result skipped
+            = MusicBrainzParser::parseRelease(R"({"id": "r1", "label-info": [{"name": "unterminated)");
+        check(!skipped.error.isEmpty(), "a truncated subtree that is skipped is still an error");
+    }
+
+    qInfo().noquote() << (failures == 0 ? "All checks passed" : QStringLiteral("%1 check(s) failed").arg(failures));
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+// Checks the Lucene clauses of MusicBrainz searches, how artist/album
+// lookups are packed into combined queries within their bounds, and how
+// the combined results are handed back to the lookups they belong to.
+
+#include "sources/musicbrainzquery.h"
+
+#include <QCoreApplication>
+#include <QUrl>
+#include <QDebug>
+
+#include <algorithm>
+
+namespace {
+int failures{0};
+
+void check(bool condition, const char* what)
+{
+    qInfo().noquote() << (condition ? "  ok   " : "  FAIL ") << what;
+    if(!condition) {
+        ++failures;
+    }
+}
+
+using Lookup = MusicBrainzQuery::Lookup;
+
+Tagger::AlbumMetadata result(const char* album, const char* artist)
+{
+    Tagger::AlbumMetadata metadata;
+    metadata.album = QString::fromUtf8(album);
+    metadata.albumArtist = QString::fromUtf8(artist);
+    return metadata;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    qInfo() << "Clauses";
+    {
+        check(MusicBrainzQuery::clause({QStringLiteral("Ilaiyaraaja"), QStringLiteral("Annakili")})
+                  == QLatin1String(R"(artist:"Ilaiyaraaja" AND release:"Annakili")"),
+              "artist and release phrases");
+        check(MusicBrainzQuery::clause({{}, QStringLiteral(R"(Say "Hi" \o/)")})
+                  == QLatin1String(R"(release:"Say \"Hi\" \\o/")"),
+              "quotes and backslashes escaped");
+        check(MusicBrainzQuery::clause({}).isEmpty(), "nothing to search for");
+
+        const QList<Lookup> lookups{{QStringLiteral("A"), {}}, {{}, QStringLiteral("B")}};
+        check(MusicBrainzQuery::combine(lookups, {0, 1}) == QLatin1String(R"((artist:"A") OR (release:"B"))"),
+              "lookups OR-ed together");
+        check(MusicBrainzQuery::combine(lookups, {1}) == QLatin1String(R"(release:"B")"), "a single one as it is");
+    }
+
+    qInfo() << "Packing";
+    {
+        QList<Lookup> lookups;
+        for(int i = 0; i < 100; ++i) {
+            lookups.append({QStringLiteral("Artist %1").arg(i), QStringLiteral("Album %1").arg(i)});
+        }
+        lookups[5] = {};
+
+        const QList<QList<qsizetype>> groups = MusicBrainzQuery::pack(lookups);
+        qsizetype packed{0};
+        bool inOrder{true};
+        qsizetype last{-1};
+        for(const auto& group : groups) {
+            packed += group.size();
+            for(const qsizetype index : group) {
+                inOrder = inOrder && index > last;
+                last = index;
+            }
+        }
+        check(packed == 99 && inOrder, "every lookup but the empty one, in order");
+        check(std::all_of(groups.cbegin(), groups.cend(),
+                          [](const auto& group) { return group.size() <= MusicBrainzQuery::MaxLookupsPerQuery; }),
+              "no more lookups per query than allowed");
+        check(groups.size() == 13, "13 requests instead of 99");
+
+        QList<Lookup> longLookups;
+        for(int i = 0; i < 6; ++i) {
+            longLookups.append({QStringLiteral("Artist %1").arg(i), QString(200, QLatin1Char('x'))});
+        }
+        longLookups.append({{}, QString(MusicBrainzQuery::MaxQueryLength, QLatin1Char('y'))});
+        longLookups.append({QStringLiteral("Last"), {}});
+        const QList<QList<qsizetype>> longGroups = MusicBrainzQuery::pack(longLookups);
+        check(std::all_of(longGroups.cbegin(), longGroups.cend(),
+                          [&longLookups](const auto& group) {
+                              return group.size() == 1
+                                  || QUrl::toPercentEncoding(MusicBrainzQuery::combine(longLookups, group)).size()
+                                         <= MusicBrainzQuery::MaxQueryLength;
+                          }),
+              "combined queries stay under the length bound");
+        check(longGroups.size() >= 3 && longGroups[longGroups.size() - 2] == QList<qsizetype>{6},
+              "a lookup too long to share gets a query of its own");
+    }
+
+    qInfo() << "Handing results back";
+    {
+        const QList<Lookup> lookups{
+            {QStringLiteral("Ilaiyaraaja"), QStringLiteral("Annakili")},
+            {QStringLiteral("Ilaiyaraaja"), QStringLiteral("Thalapathi")},
+            {QStringLiteral("A. R. Rahman"), QStringLiteral("Roja")},
+            {{}, QStringLiteral("Annakili")},
+        };
+        const QList<Tagger::AlbumMetadata> results{
+            result("Thalapathi", "Ilaiyaraaja"),
+            result("Annakili (Original Soundtrack)", "Ilaiyaraaja"),
+            result("Roja", "A.R. Rahman"),
+            result("Unrelated", "Nobody"),
+        };
+
+        check(MusicBrainzQuery::assign(results, lookups, {0, 1, 2}) == QList<qsizetype>{1, 0, 2, -1},
+              "each result goes to the lookup it contains");
+        check(MusicBrainzQuery::assign(results, lookups, {3, 0}) == QList<qsizetype>{1, 0, -1, -1},
+              "ties go to the earlier lookup, indices are into the group");
+    }
+
+    qInfo().noquote() << (failures == 0 ? "All checks passed" : QStringLiteral("%1 check(s) failed").arg(failures));
+    return failures == 0 ? 0 : 1;
+}
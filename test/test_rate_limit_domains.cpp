@@ -0,0 +1,150 @@
+// Runs HttpClient against a local stand-in server reached under two host
+// names, 127.0.0.1 with a rate limit and localhost without one: requests to
+// the limited host are spaced by its interval, requests to the other host
+// never wait behind them, and queued requests can be cancelled or go away
+// with their requester.
+
+#include "standinserver.h"
+
+#include "core/httpclient.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QPointer>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QDebug>
+
+namespace {
+int failures{0};
+
+void check(bool condition, const char* what)
+{
+    qInfo().noquote() << (condition ? "  ok   " : "  FAIL ") << what;
+    if(!condition) {
+        ++failures;
+    }
+}
+
+constexpr int IntervalMs = 300;
+
+struct Sent
+{
+    qint64 startedAt{-1};  // ms on the test clock when the request left its queue
+    qint64 finishedAt{-1}; // ms on the test clock when its reply finished
+};
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStandardPaths::setTestModeEnabled(true);
+
+    StandInServer server;
+    if(!server.listen()) {
+        qWarning() << "Could not start the stand-in server";
+        return 1;
+    }
+    server.route(QStringLiteral("/release"), {}, {200, "application/json", "{}", {}, {}, {}});
+    server.route(QStringLiteral("/page"), {}, {200, "text/html", "<html></html>", {}, {}, {}});
+
+    QUrl limited = server.url();
+    limited.setPath(QStringLiteral("/release"));
+    QUrl other = server.url();
+    other.setHost(QStringLiteral("localhost"));
+    other.setPath(QStringLiteral("/page"));
+
+    HttpClient client;
+    client.setCacheDirectory({});
+    client.setRateLimit(limited.host(), 1000.0 / IntervalMs);
+
+    QElapsedTimer clock;
+    clock.start();
+    QEventLoop loop;
+    int pending{0};
+
+    auto send = [&](const QUrl& url, Sent& sent) {
+        ++pending;
+        HttpRequest* request = client.get(url, &loop);
+        QObject::connect(request, &HttpRequest::started, &loop, [&]() { sent.startedAt = clock.elapsed(); });
+        auto finish = [&]() {
+            sent.finishedAt = clock.elapsed();
+            if(--pending == 0) {
+                loop.quit();
+            }
+        };
+        QObject::connect(request, &HttpRequest::succeeded, &loop, finish);
+        QObject::connect(request, &HttpRequest::failed, &loop, finish);
+        return request;
+    };
+
+    qInfo() << "Independent domains";
+    {
+        Sent releases[3];
+        Sent cancelled;
+        Sent page;
+
+        send(limited, releases[0]);
+        send(limited, releases[1]);
+        send(limited, releases[2]);
+        QPointer<HttpRequest> dropped = send(limited, cancelled);
+        check(client.queuedRequests(limited.host()) == 4, "all wait for the event loop");
+
+        dropped->cancel();
+        --pending;
+        check(client.queuedRequests(limited.host()) == 3, "cancelled request left the queue");
+
+        send(other, page);
+        check(client.queuedRequests(other.host()) == 1, "other host has a queue of its own");
+
+        QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+        loop.exec();
+
+        check(releases[0].startedAt >= 0 && releases[0].startedAt < IntervalMs / 2,
+              "first request to the limited host sent right away");
+        check(page.startedAt >= 0 && page.startedAt < IntervalMs / 2, "other host sent right away");
+        check(page.finishedAt >= 0 && page.finishedAt < releases[1].startedAt,
+              "other host finished before the limited queue moved");
+        check(releases[1].startedAt - releases[0].startedAt >= IntervalMs - 5
+                  && releases[2].startedAt - releases[1].startedAt >= IntervalMs - 5,
+              "limited requests spaced by the interval");
+        check(releases[2].finishedAt >= 0, "every queued request completed");
+        check(cancelled.startedAt < 0, "cancelled request never sent");
+        check(server.requests().size() == 4, "server saw three releases and the page");
+    }
+
+    qInfo() << "Changing the limit";
+    {
+        client.setRateLimit(limited.host(), 0);
+        Sent a;
+        Sent b;
+        const qint64 start = clock.elapsed();
+        send(limited, a);
+        send(limited, b);
+        QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+        loop.exec();
+        check(b.startedAt >= 0 && b.startedAt - start < IntervalMs / 2, "no wait once the limit is removed");
+    }
+
+    qInfo() << "Destroyed requester";
+    {
+        client.setRateLimit(limited.host(), 1000.0 / IntervalMs);
+        server.clear();
+        server.route(QStringLiteral("/release"), {}, {200, "application/json", "{}", {}, {}, {}});
+
+        auto* requester = new QObject;
+        client.get(limited, requester);
+        client.get(limited, requester);
+        check(client.queuedRequests(limited.host()) == 2, "queued for the requester");
+        delete requester;
+        check(client.queuedRequests(limited.host()) == 0, "dropped with it");
+
+        QTimer::singleShot(IntervalMs * 2, &loop, &QEventLoop::quit);
+        loop.exec();
+        check(server.requests().isEmpty(), "never sent");
+    }
+
+    qInfo().noquote() << (failures == 0 ? "All checks passed" : QStringLiteral("%1 check(s) failed").arg(failures));
+    return failures == 0 ? 0 : 1;
+}
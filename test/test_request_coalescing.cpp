@@ -0,0 +1,219 @@
+// Runs identical HttpClient requests against a local stand-in server and
+// checks that they share one transfer: requests made while it is queued or
+// already running, URLs spelled differently, cancelling some of the
+// waiters or all of them, failures, a prefetch waiting on the idle lane
+// that the user then asks for, and the counters of requests saved.
+
+#include "standinserver.h"
+
+#include "core/httpclient.h"
+#include "core/httprequest.h"
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QPointer>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QDebug>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+int failures{0};
+
+void check(bool condition, const char* what)
+{
+    qInfo().noquote() << (condition ? "  ok   " : "  FAIL ") << what;
+    if(!condition) {
+        ++failures;
+    }
+}
+
+// Counts what reaches one requester
+class Requester : public QObject
+{
+public:
+    QPointer<HttpRequest> request(HttpClient& client, const QUrl& url,
+                                  HttpClient::Lane lane = HttpClient::Lane::Interactive)
+    {
+        HttpRequest* request = client.get(url, this, lane);
+        ++pending;
+        connect(request, &HttpRequest::started, this, [this]() { ++started; });
+        connect(request, &HttpRequest::succeeded, this, [this](const HttpResponse& response) {
+            responses.append(response);
+            --pending;
+        });
+        connect(request, &HttpRequest::failed, this, [this](const HttpError& error) {
+            errors.append(error);
+            --pending;
+        });
+        return request;
+    }
+
+    int pending{0};
+    int started{0};
+    QList<HttpResponse> responses;
+    QList<HttpError> errors;
+};
+
+void waitFor(const std::function<bool()>& done)
+{
+    QEventLoop loop;
+    QTimer poll;
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+        if(done()) {
+            loop.quit();
+        }
+    });
+    poll.start(5);
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+void settle(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStandardPaths::setTestModeEnabled(true);
+
+    StandInServer server;
+    if(!server.listen()) {
+        qWarning() << "Could not start the stand-in server";
+        return 1;
+    }
+    const QByteArray release = "{\"id\":\"a\",\"title\":\"Coalesced\"}";
+    server.route(QStringLiteral("/release/a"), {}, {200, "application/json", release, {}, {}, {}});
+    server.route(QStringLiteral("/release/b"), {}, {200, "application/json", "{\"id\":\"b\"}", {}, {}, {}});
+
+    auto at = [&server](const QString& pathAndQuery) {
+        return server.url().resolved(QUrl(pathAndQuery));
+    };
+
+    HttpClient client;
+    client.setCacheDirectory({});
+
+    qInfo() << "Requests while queued";
+    {
+        Requester first;
+        Requester second;
+        first.request(client, at(QStringLiteral("/release/a?inc=labels&fmt=json")));
+        second.request(client, at(QStringLiteral("/release/a?fmt=json&inc=labels#tracks")));
+        second.request(client, at(QStringLiteral("/release/b")));
+        waitFor([&]() { return first.pending == 0 && second.pending == 0; });
+
+        check(server.requests().size() == 2, "one transfer per distinct resource");
+        check(first.responses.size() == 1 && first.responses.constFirst().body == release, "first requester answered");
+        check(second.responses.size() == 2, "second requester got both of its replies");
+        check(first.started == 1 && second.started == 2, "each request started once");
+        check(std::any_of(second.responses.cbegin(), second.responses.cend(),
+                          [](const HttpResponse& r) { return r.url.fragment() == QLatin1String("tracks"); }),
+              "reply carries the URL as requested");
+
+        const HttpClient::CoalescingStats stats = client.coalescingStats();
+        check(stats.requests == 3 && stats.transfers == 2 && stats.joinedQueued == 1, "counted as joining a queue");
+    }
+
+    qInfo() << "Late subscriber";
+    {
+        server.clear();
+        server.route(QStringLiteral("/slow"), {}, {200, "application/json", release, {}, {}, {}, 300});
+
+        Requester first;
+        Requester late;
+        first.request(client, at(QStringLiteral("/slow")));
+        waitFor([&]() { return first.started == 1; });
+        settle(50);
+        late.request(client, at(QStringLiteral("/slow")));
+        waitFor([&]() { return first.pending == 0 && late.pending == 0; });
+
+        check(server.requests().size() == 1, "attached to the running transfer");
+        check(late.started == 1 && late.responses.size() == 1 && late.responses.constFirst().body == release,
+              "late subscriber got the whole body");
+        check(client.coalescingStats().joinedInFlight == 1, "counted as joining a running transfer");
+
+        late.request(client, at(QStringLiteral("/slow")));
+        waitFor([&]() { return late.pending == 0; });
+        check(server.requests().size() == 2, "a finished transfer is not reused");
+    }
+
+    qInfo() << "Cancellation";
+    {
+        server.clear();
+        server.route(QStringLiteral("/release/a"), {}, {200, "application/json", release, {}, {}, {}});
+
+        Requester kept;
+        Requester dropped;
+        kept.request(client, at(QStringLiteral("/release/a")));
+        dropped.request(client, at(QStringLiteral("/release/a")))->cancel();
+        waitFor([&]() { return kept.pending == 0; });
+        settle(50);
+        check(kept.responses.size() == 1, "the other waiter still gets its reply");
+        check(dropped.responses.isEmpty() && dropped.errors.isEmpty(), "no signals after cancel");
+        check(server.requests().size() == 1, "one transfer");
+
+        Requester both;
+        QPointer<HttpRequest> one = both.request(client, at(QStringLiteral("/release/a")));
+        QPointer<HttpRequest> two = both.request(client, at(QStringLiteral("/release/a")));
+        one->cancel();
+        two->cancel();
+        settle(100);
+        check(server.requests().size() == 1, "cancelling every waiter drops the transfer");
+        check(both.responses.isEmpty() && both.errors.isEmpty(), "nothing delivered");
+    }
+
+    qInfo() << "Failures";
+    {
+        server.clear();
+        const QByteArray notFound = "{\"error\":\"Not Found\"}";
+        server.route(QStringLiteral("/missing"), {}, {404, "application/json", notFound, {}, {}, {}});
+
+        Requester first;
+        Requester second;
+        first.request(client, at(QStringLiteral("/missing")));
+        second.request(client, at(QStringLiteral("/missing")));
+        waitFor([&]() { return first.pending == 0 && second.pending == 0; });
+        check(server.requests().size() == 1, "one transfer");
+        check(first.errors.size() == 1 && second.errors.size() == 1 && second.errors.constFirst().statusCode == 404,
+              "both waiters got the error");
+    }
+
+    qInfo() << "Prefetch picked up";
+    {
+        server.clear();
+        server.route(QStringLiteral("/release/a"), {}, {200, "application/json", release, {}, {}, {}});
+        server.route(QStringLiteral("/release/b"), {}, {200, "application/json", "{\"id\":\"b\"}", {}, {}, {}});
+        server.route(QStringLiteral("/release/c"), {}, {200, "application/json", "{\"id\":\"c\"}", {}, {}, {}});
+        client.setRateLimit(server.url().host(), 5.0);
+
+        Requester user;
+        Requester prefetch;
+        user.request(client, at(QStringLiteral("/release/b")));
+        user.request(client, at(QStringLiteral("/release/c")), HttpClient::Lane::Batch);
+        prefetch.request(client, at(QStringLiteral("/release/a")), HttpClient::Lane::Idle);
+        user.request(client, at(QStringLiteral("/release/a")));
+        waitFor([&]() { return user.pending == 0 && prefetch.pending == 0; });
+
+        const QList<QUrl> sent = server.requests();
+        check(sent.size() == 3, "the prefetch and the user's request shared a transfer");
+        check(sent.size() == 3 && sent[1].path() == QLatin1String("/release/a"),
+              "moved up from the idle lane ahead of the batch request");
+        check(prefetch.responses.size() == 1 && user.responses.size() == 3, "both got the reply");
+    }
+
+    const HttpClient::CoalescingStats stats = client.coalescingStats();
+    qInfo().noquote() << QStringLiteral("%1 requests, %2 transfers, %3 saved")
+                             .arg(stats.requests)
+                             .arg(stats.transfers)
+                             .arg(stats.saved());
+
+    qInfo().noquote() << (failures == 0 ? "All checks passed" : QStringLiteral("%1 check(s) failed").arg(failures));
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,308 @@
+// Drives RequestScheduler with a hand-moved clock: token bucket refill and
+// burst, interactive requests overtaking a batch backlog without exceeding
+// the host's budget, idle requests waiting for a slot nobody else wants
+// and holding up a search by one interval at most, independent hosts,
+// cancellation, hold-offs and wait percentiles.
+
+#include "core/requestscheduler.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+
+namespace {
+int failures{0};
+
+void check(bool condition, const char* what)
+{
+    qInfo().noquote() << (condition ? "  ok   " : "  FAIL ") << what;
+    if(!condition) {
+        ++failures;
+    }
+}
+
+using Lane = RequestScheduler::Lane;
+
+const QString MusicBrainz = QStringLiteral("musicbrainz.org");
+const QString Wikipedia = QStringLiteral("en.wikipedia.org");
+
+// Moves the clock to each moment the scheduler next has something to send, until it has sent count requests
+QList<RequestScheduler::Ready> drain(RequestScheduler& scheduler, qint64& now, qsizetype count)
+{
+    QList<RequestScheduler::Ready> sent;
+    while(sent.size() < count) {
+        const qint64 wait = scheduler.nextReadyIn();
+        if(wait < 0) {
+            break;
+        }
+        now += wait;
+        sent.append(scheduler.takeReady());
+    }
+    return sent;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    qInfo() << "Token bucket";
+    {
+        qint64 now{0};
+        RequestScheduler scheduler([&now]() { return now; });
+        scheduler.setRate(MusicBrainz, 1.0);
+
+        for(int i = 0; i < 3; ++i) {
+            scheduler.enqueue(MusicBrainz, Lane::Interactive);
+        }
+        check(scheduler.takeReady().size() == 1, "one request right away");
+        check(scheduler.nextReadyIn() == 1000, "next one in a second");
+        now = 999;
+        check(scheduler.takeReady().isEmpty(), "nothing a millisecond early");
+        check(scheduler.nextReadyIn() == 1, "one millisecond left");
+        now = 1000;
+        check(scheduler.takeReady().size() == 1, "second request on time");
+        now = 5000;
+        check(scheduler.takeReady().size() == 1, "an idle host does not save up beyond its burst");
+        check(scheduler.nextReadyIn() == -1, "nothing left to wait for");
+    }
+
+    qInfo() << "Burst";
+    {
+        qint64 now{0};
+        RequestScheduler scheduler([&now]() { return now; });
+        scheduler.setRate(MusicBrainz, 2.0, 3);
+
+        for(int i = 0; i < 6; ++i) {
+            scheduler.enqueue(MusicBrainz, Lane::Batch);
+        }
+        check(scheduler.takeReady().size() == 3, "a full bucket sends three back to back");
+        const auto rest = drain(scheduler, now, 3);
+        check(rest.size() == 3 && now == 1500, "then one every 500 ms");
+        check(scheduler.burst(MusicBrainz) == 3 && scheduler.rate(MusicBrainz) == 2.0, "budget reported");
+    }
+
+    qInfo() << "Priority lanes";
+    {
+        qint64 now{0};
+        RequestScheduler scheduler([&now]() { return now; });
+        scheduler.setRate(MusicBrainz, 1.0);
+
+        for(int i = 0; i < 200; ++i) {
+            scheduler.enqueue(MusicBrainz, Lane::Batch);
+        }
+        const auto batch = drain(scheduler, now, 5);
+        check(batch.size() == 5 && now == 4000, "batch drains at the host's rate");
+
+        now = 4500;
+        const quint64 search = scheduler.enqueue(MusicBrainz, Lane::Interactive);
+        check(scheduler.takeReady().isEmpty(), "interactive request still waits for a token");
+        check(scheduler.laneStats(MusicBrainz, Lane::Interactive).queued == 1, "interactive depth");
+        check(scheduler.laneStats(MusicBrainz, Lane::Batch).queued == 195, "batch depth");
+
+        now = 5000;
+        const auto next = scheduler.takeReady();
+        check(next.size() == 1 && next.constFirst().ticket == search, "interactive request jumps the batch queue");
+        check(next.constFirst().waitedMs == 500, "after waiting for the next token only");
+
+        now = 6000;
+        const auto after = scheduler.takeReady();
+        check(after.size() == 1 && after.constFirst().lane == Lane::Batch, "batch resumes afterwards");
+
+        // Both lanes full for a minute: the budget holds whatever the mix
+        for(int i = 0; i < 100; ++i) {
+            scheduler.enqueue(MusicBrainz, Lane::Interactive);
+        }
+        const qint64 start = now;
+        qsizetype sent{0};
+        while(now < start + 60000) {
+            now += 250;
+            sent += scheduler.takeReady().size();
+        }
+        check(sent == 60, "one request per second across both lanes");
+        check(scheduler.laneStats(MusicBrainz, Lane::Interactive).queued == 40, "interactive ones went first");
+    }
+
+    qInfo() << "Independent hosts";
+    {
+        qint64 now{0};
+        RequestScheduler scheduler([&now]() { return now; });
+        scheduler.setRate(MusicBrainz, 1.0);
+
+        for(int i = 0; i < 50; ++i) {
+            scheduler.enqueue(MusicBrainz, Lane::Interactive);
+        }
+        scheduler.takeReady();
+        const quint64 page = scheduler.enqueue(Wikipedia, Lane::Interactive);
+        const auto ready = scheduler.takeReady();
+        check(ready.size() == 1 && ready.constFirst().ticket == page && ready.constFirst().host == Wikipedia,
+              "unlimited host goes straight past the MusicBrainz backlog");
+        check(scheduler.queued(MusicBrainz) == 49 && scheduler.queued(Wikipedia) == 0, "queues kept apart");
+
+        scheduler.setRate(Wikipedia, 10.0);
+        scheduler.enqueue(Wikipedia, Lane::Batch);
+        scheduler.enqueue(Wikipedia, Lane::Batch);
+        const auto limited = scheduler.takeReady();
+        check(limited.size() == 1 && limited.constFirst().host == Wikipedia, "second host has its own bucket");
+        check(scheduler.nextReadyIn() == 100, "and its own refill time");
+
+        scheduler.setRate(MusicBrainz, 0);
+        check(scheduler.takeReady().size() == 49, "removing the limit releases the queue");
+    }
+
+    qInfo() << "Cancellation";
+    {
+        qint64 now{0};
+        RequestScheduler scheduler([&now]() { return now; });
+        scheduler.setRate(MusicBrainz, 1.0);
+
+        const quint64 first = scheduler.enqueue(MusicBrainz, Lane::Interactive);
+        const quint64 second = scheduler.enqueue(MusicBrainz, Lane::Interactive);
+        const quint64 third = scheduler.enqueue(MusicBrainz, Lane::Batch);
+        scheduler.takeReady();
+
+        check(!scheduler.cancel(first), "a sent request cannot be cancelled");
+        check(scheduler.cancel(second), "queued request cancelled");
+        check(!scheduler.cancel(second), "only once");
+        now = 1000;
+        const auto ready = scheduler.takeReady();
+        check(ready.size() == 1 && ready.constFirst().ticket == third, "the next one takes its place");
+    }
+
+    qInfo() << "Hold-off";
+    {
+        qint64 now{0};
+        RequestScheduler scheduler([&now]() { return now; });
+        scheduler.setRate(MusicBrainz, 2.0, 5);
+
+        for(int i = 0; i < 4; ++i) {
+            scheduler.enqueue(MusicBrainz, Lane::Interactive);
+        }
+        scheduler.enqueue(Wikipedia, Lane::Interactive);
+        scheduler.holdOff(MusicBrainz, 3000);
+        const auto ready = scheduler.takeReady();
+        check(ready.size() == 1 && ready.constFirst().host == Wikipedia, "held-off host sends nothing, others do");
+        check(scheduler.nextReadyIn() == 3000 && scheduler.heldOffFor(MusicBrainz) == 3000, "waits out the hold-off");
+
+        scheduler.holdOff(MusicBrainz, 1000);
+        check(scheduler.heldOffFor(MusicBrainz) == 3000, "a shorter hold-off does not cut it short");
+
+        now = 3000;
+        check(scheduler.takeReady().size() == 1, "resumes with a single token, not a full burst");
+        check(scheduler.nextReadyIn() == 500, "then at the host's rate");
+
+        scheduler.holdOff(Wikipedia, 200);
+        scheduler.enqueue(Wikipedia, Lane::Batch);
+        now = 3100;
+        check(scheduler.takeReady().isEmpty(), "unlimited host can be held off too");
+        now = 3200;
+        const auto resumed = scheduler.takeReady();
+        check(resumed.size() == 1 && resumed.constFirst().host == Wikipedia, "and resumes right after");
+    }
+
+    qInfo() << "Idle lane";
+    {
+        qint64 now{0};
+        RequestScheduler scheduler([&now]() { return now; });
+        scheduler.setRate(MusicBrainz, 1.0, 2);
+
+        const quint64 prefetch = scheduler.enqueue(MusicBrainz, Lane::Idle);
+        scheduler.enqueue(MusicBrainz, Lane::Batch);
+        scheduler.enqueue(MusicBrainz, Lane::Interactive);
+        auto ready = scheduler.takeReady();
+        check(ready.size() == 2 && ready.constLast().lane == Lane::Batch, "other lanes take the whole burst");
+        check(scheduler.queued(MusicBrainz) == 1, "idle request still queued");
+        check(scheduler.nextReadyIn() == 2000, "waits for a full bucket, not the next token");
+
+        now = 1000;
+        const quint64 interactive = scheduler.enqueue(MusicBrainz, Lane::Interactive);
+        ready = scheduler.takeReady();
+        check(ready.size() == 1 && ready.constFirst().ticket == interactive, "an interactive request goes first");
+
+        now = 2000;
+        check(scheduler.takeReady().isEmpty(), "not while the bucket refills");
+        now = 3000;
+        ready = scheduler.takeReady();
+        check(ready.size() == 1 && ready.constFirst().ticket == prefetch && ready.constFirst().lane == Lane::Idle,
+              "sent once the bucket is full");
+
+        // One idle request per full bucket, the other token stays for whatever comes next
+        scheduler.enqueue(MusicBrainz, Lane::Idle);
+        check(scheduler.takeReady().isEmpty() && scheduler.nextReadyIn() == 1000, "leaves a token for the others");
+        scheduler.enqueue(MusicBrainz, Lane::Interactive);
+        check(scheduler.takeReady().size() == 1, "which an interactive request gets at once");
+
+        const quint64 dropped = scheduler.enqueue(MusicBrainz, Lane::Idle);
+        check(scheduler.cancel(dropped) && scheduler.queued(MusicBrainz) == 1, "idle requests can be cancelled");
+
+        scheduler.enqueue(Wikipedia, Lane::Idle);
+        ready = scheduler.takeReady();
+        check(ready.size() == 1 && ready.constFirst().host == Wikipedia, "unlimited host sends idle requests at once");
+    }
+
+    qInfo() << "Idle lane, burst of one";
+    {
+        // MusicBrainz' budget: one request a second, never two back to back
+        qint64 now{0};
+        RequestScheduler scheduler([&now]() { return now; });
+        scheduler.setRate(MusicBrainz, 1.0);
+
+        const quint64 prefetch = scheduler.enqueue(MusicBrainz, Lane::Idle);
+        auto ready = scheduler.takeReady();
+        check(ready.size() == 1 && ready.constFirst().ticket == prefetch, "a full bucket sends the idle request");
+
+        now = 200;
+        const quint64 search = scheduler.enqueue(MusicBrainz, Lane::Interactive);
+        check(scheduler.takeReady().isEmpty() && scheduler.nextReadyIn() == 800,
+              "an interactive request right after it waits for the next token");
+        now = 1000;
+        ready = scheduler.takeReady();
+        check(ready.size() == 1 && ready.constFirst().ticket == search && ready.constFirst().waitedMs == 800,
+              "which is the longest a prefetch can hold it up");
+
+        // A steady stream of prefetches with a search every three seconds, half a second into a refill
+        for(int i = 0; i < 100; ++i) {
+            scheduler.enqueue(MusicBrainz, Lane::Idle);
+        }
+        qsizetype sent{0};
+        qint64 lastSent{-1000};
+        bool backToBack{false};
+        qint64 longestSearchWait{0};
+        for(now = 10000; now < 70000; now += 100) {
+            if(now % 3000 == 500) {
+                scheduler.enqueue(MusicBrainz, Lane::Interactive);
+            }
+            for(const auto& request : scheduler.takeReady()) {
+                if(request.lane == Lane::Interactive) {
+                    longestSearchWait = qMax(longestSearchWait, request.waitedMs);
+                }
+                backToBack = backToBack || now - lastSent < 1000;
+                lastSent = now;
+                ++sent;
+            }
+        }
+        check(!backToBack && sent <= 61, "prefetches and searches together keep to the host's budget");
+        check(longestSearchWait > 0 && longestSearchWait <= 1000, "a search waits at most one interval");
+    }
+
+    qInfo() << "Wait percentiles";
+    {
+        qint64 now{0};
+        RequestScheduler scheduler([&now]() { return now; });
+        scheduler.setRate(MusicBrainz, 10.0);
+
+        for(int i = 0; i < 100; ++i) {
+            scheduler.enqueue(MusicBrainz, Lane::Batch);
+        }
+        drain(scheduler, now, 100);
+
+        // Waits of 0, 100, ..., 9900 ms
+        const RequestScheduler::LaneStats stats = scheduler.laneStats(MusicBrainz, Lane::Batch);
+        check(stats.sent == 100 && stats.queued == 0, "all sent");
+        check(stats.waitP50Ms == 4900 && stats.waitP90Ms == 8900 && stats.waitP99Ms == 9800, "p50, p90, p99");
+        check(scheduler.laneStats(MusicBrainz, Lane::Interactive).waitP99Ms == 0, "empty lane reports zero");
+        check(qAbs(scheduler.effectiveRate(MusicBrainz) - 10.0) < 0.2, "effective rate matches the budget");
+    }
+
+    qInfo().noquote() << (failures == 0 ? "All checks passed" : QStringLiteral("%1 check(s) failed").arg(failures));
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+// Runs HttpClient with its response cache against a local stand-in server
+// that counts requests: fresh hits, ETag and Last-Modified revalidation,
+// replacement of changed bodies, persistence across clients and LRU
+// eviction under a size bound.
+
+#include "standinserver.h"
+
+#include "core/httpclient.h"
+#include "core/responsecache.h"
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QDebug>
+
+namespace {
+int failures{0};
+
+void check(bool condition, const char* what)
+{
+    qInfo().noquote() << (condition ? "  ok   " : "  FAIL ") << what;
+    if(!condition) {
+        ++failures;
+    }
+}
+
+QByteArray get(HttpClient& client, const QUrl& url)
+{
+    QEventLoop loop;
+    QByteArray body;
+    HttpRequest* request = client.get(url, &loop);
+    QObject::connect(request, &HttpRequest::succeeded, &loop, [&loop, &body](const HttpResponse& response) {
+        body = response.body;
+        loop.quit();
+    });
+    QObject::connect(request, &HttpRequest::failed, &loop, &QEventLoop::quit);
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+    loop.exec();
+    return body;
+}
+
+QUrl at(const StandInServer& server, const QString& path)
+{
+    QUrl url = server.url();
+    url.setPath(path);
+    return url;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStandardPaths::setTestModeEnabled(true);
+
+    StandInServer server;
+    QTemporaryDir directory;
+    if(!server.listen() || !directory.isValid()) {
+        qWarning() << "Could not start the stand-in server";
+        return 1;
+    }
+
+    const QByteArray release = QByteArray(4000, 'r');
+    const QByteArray changedRelease = QByteArray(4000, 'R');
+    const QByteArray page = QByteArray(3000, 'p');
+    server.route(QStringLiteral("/release"), {},
+                 {200, "application/json", release, "\"v1\"", {}, "private, must-revalidate, max-age=0"});
+    server.route(QStringLiteral("/page"), {}, {200, "text/html", page, {}, "Wed, 01 Oct 2025 10:00:00 GMT", {}});
+
+    const QUrl releaseUrl = at(server, QStringLiteral("/release"));
+    const QUrl pageUrl = at(server, QStringLiteral("/page"));
+
+    {
+        HttpClient client;
+        client.setCacheDirectory(directory.path());
+        ResponseCache* cache = client.cache();
+
+        qInfo() << "Fresh entries";
+        check(get(client, releaseUrl) == release, "first request downloads the body");
+        check(get(client, releaseUrl) == release, "second request returns the same body");
+        check(server.requests().size() == 1, "second request answered without the server");
+        check(cache->stats().hits == 1 && cache->stats().misses == 1, "one hit, one miss");
+
+        qInfo() << "Revalidation";
+        cache->setFreshFor(0);
+        check(!cache->isFresh(releaseUrl), "entry is stale without a fresh window");
+        check(get(client, releaseUrl) == release, "stale entry still returns the body");
+        check(server.requests().size() == 2, "stale entry asks the server");
+        check(server.requestHeaders().constLast().value("if-none-match") == "\"v1\"", "sent If-None-Match");
+        check(server.bytesServed() == release.size(), "304 carried no body");
+        check(cache->stats().revalidations == 1, "counted as revalidated");
+
+        check(get(client, pageUrl) == page && get(client, pageUrl) == page, "Last-Modified page read twice");
+        check(server.requestHeaders().constLast().value("if-modified-since") == "Wed, 01 Oct 2025 10:00:00 GMT",
+              "sent If-Modified-Since");
+        check(server.bytesServed() == release.size() + page.size(), "page body sent once");
+
+        qInfo() << "Changed body";
+        server.clear();
+        server.route(QStringLiteral("/release"), {}, {200, "application/json", changedRelease, "\"v2\"", {}, {}});
+        server.route(QStringLiteral("/page"), {}, {200, "text/html", page, {}, "Wed, 01 Oct 2025 10:00:00 GMT", {}});
+        check(get(client, releaseUrl) == changedRelease, "new ETag replaces the stored body");
+        check(cache->stats().misses == 3, "counted as a miss");
+    }
+
+    qInfo() << "Persistence";
+    {
+        server.clear();
+        HttpClient client;
+        client.setCacheDirectory(directory.path());
+        check(client.cache()->isFresh(releaseUrl), "entry survives a new client");
+        check(get(client, releaseUrl) == changedRelease, "body read back from disk");
+        check(server.requests().isEmpty(), "without asking the server");
+    }
+
+    qInfo() << "LRU eviction";
+    {
+        server.clear();
+        HttpClient client;
+        client.setCacheDirectory(directory.path());
+        ResponseCache* cache = client.cache();
+        cache->clear();
+        check(cache->cacheSize() == 0, "cleared");
+
+        QList<QUrl> urls;
+        for(int i = 0; i < 3; ++i) {
+            const QString path = QStringLiteral("/disc%1").arg(i);
+            server.route(path, {}, {200, "application/json", QByteArray(4000, char('a' + i)), {}, {}, {}});
+            urls.append(at(server, path));
+        }
+
+        // Room for two entries
+        cache->setMaximumSize(10000);
+        get(client, urls[0]);
+        get(client, urls[1]);
+        get(client, urls[0]); // Most recently used now
+        get(client, urls[2]);
+        check(cache->stats().evictions == 1, "one entry evicted");
+        check(cache->isFresh(urls[0]) && cache->isFresh(urls[2]), "recently used entries kept");
+        check(!cache->isFresh(urls[1]) && !cache->metaData(urls[1]).isValid(), "least recently used entry evicted");
+        check(cache->cacheSize() <= cache->maximumSize(), "size bound kept");
+    }
+
+    qInfo().noquote() << (failures == 0 ? "All checks passed" : QStringLiteral("%1 check(s) failed").arg(failures));
+    return failures == 0 ? 0 : 1;
+}
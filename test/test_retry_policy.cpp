@@ -0,0 +1,292 @@
+// Checks RetryPolicy's backoff and Retry-After parsing, then runs HttpClient
+// against a local stand-in server that answers 503: retries until the
+// server recovers, waits as long as Retry-After asks and holds the whole
+// host off meanwhile, gives up after the last attempt or at the deadline.
+// A body cut off partway is not sent again to whoever streamed part of it.
+
+#include "standinserver.h"
+
+#include "core/httpclient.h"
+#include "core/httprequest.h"
+#include "core/retrypolicy.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QStandardPaths>
+#include <QTimeZone>
+#include <QTimer>
+#include <QDebug>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+int failures{0};
+
+void check(bool condition, const char* what)
+{
+    qInfo().noquote() << (condition ? "  ok   " : "  FAIL ") << what;
+    if(!condition) {
+        ++failures;
+    }
+}
+
+// Counts what reaches one requester
+class Requester : public QObject
+{
+public:
+    void request(HttpClient& client, const QUrl& url)
+    {
+        HttpRequest* request = client.get(url, this);
+        ++pending;
+        if(stream) {
+            connect(request, &HttpRequest::readyRead, this,
+                    [this, request]() { streamed += request->readAvailable(); });
+        }
+        connect(request, &HttpRequest::succeeded, this, [this](const HttpResponse& response) {
+            responses.append(response);
+            --pending;
+        });
+        connect(request, &HttpRequest::failed, this, [this](const HttpError& error) {
+            errors.append(error);
+            --pending;
+        });
+    }
+
+    bool stream{false}; // Takes the body as it arrives
+    QByteArray streamed;
+    int pending{0};
+    QList<HttpResponse> responses;
+    QList<HttpError> errors;
+};
+
+void waitFor(const std::function<bool()>& done)
+{
+    QEventLoop loop;
+    QTimer poll;
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+        if(done()) {
+            loop.quit();
+        }
+    });
+    poll.start(5);
+    QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStandardPaths::setTestModeEnabled(true);
+
+    qInfo() << "Backoff";
+    {
+        RetryPolicy policy;
+        policy.baseDelayMs = 1000;
+        policy.maxDelayMs = 5000;
+        policy.jitter = 0.5;
+        check(policy.backoffMs(1, 0.0) == 1000 && policy.backoffMs(2, 0.0) == 2000 && policy.backoffMs(3, 0.0) == 4000,
+              "doubles with each retry");
+        check(policy.backoffMs(4, 0.0) == 5000 && policy.backoffMs(30, 0.0) == 5000, "capped");
+        check(policy.backoffMs(2, 0.999) > 1000 && policy.backoffMs(2, 0.5) == 1500, "jitter takes off up to half");
+
+        HttpError unavailable;
+        unavailable.kind = HttpError::Kind::Http;
+        unavailable.statusCode = 503;
+        HttpError notFound = unavailable;
+        notFound.statusCode = 404;
+        HttpError refused;
+        refused.code = QNetworkReply::ConnectionRefusedError;
+        HttpError dropped;
+        dropped.code = QNetworkReply::RemoteHostClosedError;
+        check(policy.shouldRetry(unavailable) && !policy.shouldRetry(notFound), "503 is retried, 404 is not");
+        check(policy.shouldRetry(dropped) && !policy.shouldRetry(refused),
+              "a dropped connection is retried, a refused one is not");
+    }
+
+    qInfo() << "Retry-After";
+    {
+        const QDateTime now(QDate(2024, 3, 1), QTime(12, 0, 0), QTimeZone::utc());
+        check(RetryPolicy::parseRetryAfter("120", now) == 120000, "delay in seconds");
+        check(RetryPolicy::parseRetryAfter("Fri, 01 Mar 2024 12:00:30 GMT", now) == 30000, "HTTP date");
+        check(RetryPolicy::parseRetryAfter("Fri, 01 Mar 2024 11:00:00 GMT", now) == 0, "date in the past");
+        check(!RetryPolicy::parseRetryAfter("", now) && !RetryPolicy::parseRetryAfter("soon", now)
+                  && !RetryPolicy::parseRetryAfter("-5", now),
+              "absent or malformed");
+    }
+
+    StandInServer server;
+    if(!server.listen()) {
+        qWarning() << "Could not start the stand-in server";
+        return 1;
+    }
+
+    const QByteArray release = "{\"id\":\"a\"}";
+    const StandInServer::Response ok{200, "application/json", release, {}, {}, {}};
+    const StandInServer::Response unavailable{503, "application/json", "{\"error\":\"Slow down\"}", {}, {}, {}};
+    StandInServer::Response unavailableFor1s = unavailable;
+    unavailableFor1s.retryAfter = "1";
+
+    // Fails the first `failing` requests to /release/a, then recovers
+    int failing{0};
+    const StandInServer::Response* failure{&unavailable};
+    auto serve = [&]() {
+        server.clear();
+        server.route([&](const QUrl& target) -> const StandInServer::Response* {
+            if(target.path() != QLatin1String("/release/a")) {
+                return nullptr;
+            }
+            if(failing > 0) {
+                --failing;
+                return failure;
+            }
+            return &ok;
+        });
+        server.route(QStringLiteral("/release/b"), {}, ok);
+        server.route(QStringLiteral("/slow"), {}, {200, "application/json", release, {}, {}, {}, 2000});
+    };
+
+    auto at = [&server](const QString& path) {
+        return server.url().resolved(QUrl(path));
+    };
+    auto sentTo = [&server](const QString& path) {
+        return std::count_if(server.requests().cbegin(), server.requests().cend(),
+                             [&path](const QUrl& url) { return url.path() == path; });
+    };
+
+    HttpClient client;
+    client.setCacheDirectory({});
+    const QString host = server.url().host();
+
+    RetryPolicy policy;
+    policy.maxAttempts = 4;
+    policy.baseDelayMs = 100;
+    policy.maxDelayMs = 1000;
+    client.setRetryPolicy(host, policy);
+
+    qInfo() << "Recovers after 503s";
+    {
+        serve();
+        failing = 2;
+        Requester requester;
+        requester.request(client, at(QStringLiteral("/release/a")));
+        waitFor([&]() { return requester.pending == 0; });
+
+        check(requester.responses.size() == 1 && requester.responses.constFirst().body == release,
+              "the third attempt succeeded");
+        check(requester.errors.isEmpty(), "no failure reported on the way");
+        check(sentTo(QStringLiteral("/release/a")) == 3, "three requests reached the server");
+    }
+
+    qInfo() << "Retry-After holds off the host";
+    {
+        serve();
+        failing = 1;
+        failure = &unavailableFor1s;
+
+        Requester retried;
+        Requester other;
+        QElapsedTimer timer;
+        timer.start();
+        retried.request(client, at(QStringLiteral("/release/a")));
+        waitFor([&]() { return server.requests().size() == 1; });
+        QTimer::singleShot(100, &other, [&]() { other.request(client, at(QStringLiteral("/release/b"))); });
+        waitFor([&]() { return other.responses.size() == 1; });
+        check(timer.elapsed() >= 1000, "another request to the host waited out the hold-off");
+
+        waitFor([&]() { return retried.pending == 0; });
+        check(retried.responses.size() == 1 && timer.elapsed() >= 1000, "retried no sooner than asked");
+    }
+
+    qInfo() << "Capped attempts";
+    {
+        serve();
+        failing = 100;
+        failure = &unavailable;
+
+        Requester requester;
+        requester.request(client, at(QStringLiteral("/release/a")));
+        waitFor([&]() { return requester.pending == 0; });
+
+        check(requester.errors.size() == 1 && requester.errors.constFirst().statusCode == 503, "503 after all");
+        check(requester.errors.constFirst().attempts == 4 && sentTo(QStringLiteral("/release/a")) == 4,
+              "gave up after the last attempt");
+    }
+
+    qInfo() << "Deadline";
+    {
+        serve();
+        failing = 100;
+        failure = &unavailableFor1s;
+        policy.deadlineMs = 500;
+        client.setRetryPolicy(host, policy);
+
+        Requester requester;
+        QElapsedTimer timer;
+        timer.start();
+        requester.request(client, at(QStringLiteral("/release/a")));
+        waitFor([&]() { return requester.pending == 0; });
+        check(requester.errors.size() == 1 && requester.errors.constFirst().statusCode == 503,
+              "a retry past the deadline is not attempted");
+        check(timer.elapsed() < 500 && sentTo(QStringLiteral("/release/a")) == 1, "failed at once");
+
+        timer.restart();
+        requester.request(client, at(QStringLiteral("/slow")));
+        waitFor([&]() { return requester.pending == 0; });
+        check(requester.errors.size() == 2 && requester.errors.constLast().code == QNetworkReply::TimeoutError,
+              "a transfer running past the deadline times out");
+        check(timer.elapsed() < 1500, "without waiting for the server");
+    }
+
+    qInfo() << "Body cut off mid-stream";
+    {
+        QByteArray page;
+        for(int i = 0; i < 4000; ++i) {
+            page += QByteArray::number(i) + ',';
+        }
+        const StandInServer::Response whole{200, "application/json", page, {}, {}, {}};
+        StandInServer::Response cut = whole;
+        cut.cutAfter = page.size() / 2;
+
+        server.clear();
+        int cuts{1};
+        server.route([&](const QUrl& target) -> const StandInServer::Response* {
+            if(target.path() != QLatin1String("/page")) {
+                return nullptr;
+            }
+            return cuts-- > 0 ? &cut : &whole;
+        });
+        policy.deadlineMs = 0;
+        client.setRetryPolicy(host, policy);
+
+        // Both share one transfer; only the first reads the body while it arrives
+        Requester streaming;
+        streaming.stream = true;
+        Requester waiting;
+        streaming.request(client, at(QStringLiteral("/page")));
+        waiting.request(client, at(QStringLiteral("/page")));
+        waitFor([&]() { return streaming.pending == 0 && waiting.pending == 0; });
+
+        check(streaming.errors.size() == 1 && streaming.responses.isEmpty()
+                  && streaming.errors.constFirst().code == QNetworkReply::RemoteHostClosedError,
+              "a request that streamed part of the body gets the failure");
+        check(!streaming.streamed.isEmpty() && page.startsWith(streaming.streamed), "having read no byte twice");
+        check(waiting.responses.size() == 1 && waiting.responses.constFirst().body == page,
+              "a request that read none of it gets the whole body of the next attempt");
+        check(sentTo(QStringLiteral("/page")) == 2, "retried once");
+
+        // Alone, the streaming request is not retried at all
+        cuts = 1;
+        Requester alone;
+        alone.stream = true;
+        alone.request(client, at(QStringLiteral("/page")));
+        waitFor([&]() { return alone.pending == 0; });
+        check(alone.errors.size() == 1 && page.startsWith(alone.streamed) && sentTo(QStringLiteral("/page")) == 3,
+              "a request that streamed alone fails without a retry");
+    }
+
+    qInfo().noquote() << (failures == 0 ? "All checks passed" : QStringLiteral("%1 check(s) failed").arg(failures));
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+// Checks that rowspan and colspan keep every value under its own column,
+// on a small grid and on saved soundtrack sections that use them.
+
+#include "sources/wikipediaparser.h"
+#include "sources/wikitablegrid.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QDebug>
+
+#include <algorithm>
+
+namespace {
+int failures{0};
+
+void check(bool condition, const char* what)
+{
+    qInfo().noquote() << (condition ? "  ok   " : "  FAIL ") << what;
+    if(!condition) {
+        ++failures;
+    }
+}
+
+Tagger::AlbumMetadata parseFile(const QString& name)
+{
+    QFile file(QStringLiteral(TAGGER_SOURCE_DIR "/") + name);
+    if(!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open" << file.fileName();
+        return {};
+    }
+    return WikipediaParser::parsePage(file.readAll(), QStringLiteral("https://en.wikipedia.org/wiki/Example"));
+}
+
+bool hasTrack(const Tagger::AlbumMetadata& album, int index, const char* title, const char* artist)
+{
+    const Tagger::TrackMetadata track = album.tracks.value(index);
+    return track.title == QLatin1String(title) && track.artist == QLatin1String(artist);
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    qInfo() << "Grid layout";
+    {
+        // A B B      A spans two rows, B two columns
+        // A C D
+        // E F F      F spans two columns, rowspan="0" runs to the last row
+        WikiTableGrid grid;
+        grid.startRow();
+        grid.addCell(0, 1, true, R"( rowspan="2")");
+        grid.addCell(1, 1, true, R"( colspan=2)");
+        grid.startRow();
+        grid.addCell(2, 1, false, {});
+        grid.addCell(3, 1, false, {});
+        grid.startRow();
+        grid.addCell(4, 1, false, {});
+        grid.addCell(5, 1, false, R"( colspan="2" rowspan="0")");
+        grid.build();
+
+        check(grid.rowCount() == 3 && grid.columnCount() == 3, "3 x 3 slots");
+        check(grid.at(1, 0) == grid.at(0, 0) && grid.at(1, 0)->row == 0, "rowspan reaches into the next row");
+        check(grid.at(0, 2) == grid.at(0, 1) && grid.at(0, 2)->column == 1, "colspan covers the next column");
+        check(grid.at(1, 1)->start == 2 && grid.at(1, 2)->start == 3, "cells after a rowspan move right");
+        check(grid.at(2, 2)->start == 5 && grid.at(2, 2)->rowSpan == 1, "spans are cut off at the last row");
+        check(grid.rowStartsCell(1, false) && !grid.rowStartsCell(1, true), "row 2 starts only data cells");
+        check(grid.at(3, 0) == nullptr && grid.at(0, 3) == nullptr, "slots outside the table are empty");
+        check(WikiTableGrid::span(R"(colspan="3px")", "colspan") == 3, "leading digits of a span are used");
+        check(WikiTableGrid::span(R"(colspan="x")", "colspan") == 1, "invalid spans count as 1");
+    }
+
+    qInfo() << "Tracklist template total length (annakili.html)";
+    {
+        const Tagger::AlbumMetadata album = parseFile(QStringLiteral("annakili.html"));
+        check(album.tracks.size() == 5, "5 tracks");
+        check(std::none_of(album.tracks.cbegin(), album.tracks.cend(),
+                           [](const Tagger::TrackMetadata& track) { return track.title == QLatin1String("20:45"); }),
+              "no track made from the Total length row");
+        check(album.tracks.value(4).totalTracks == 5, "total counts only the tracks");
+    }
+
+    qInfo() << "Shared singer and lyricist (spans/shared_lyricist.html)";
+    {
+        const Tagger::AlbumMetadata album = parseFile(QStringLiteral("test/data/wikipedia/spans/shared_lyricist.html"));
+        check(album.tracks.size() == 4, "4 tracks");
+        check(hasTrack(album, 1, "Kaalai Nera", "Singer A"), "singer carried down to track 2");
+        check(album.tracks.value(1).durationSeconds == 252, "track 2 length read from its own column");
+        check(album.tracks.value(2).lyricist == QLatin1String("Lyricist X"), "lyricist carried down two rows");
+        check(hasTrack(album, 2, "Thendral Vanthu", "Singer B"), "track 3 singer after the rowspan ends");
+        check(album.tracks.value(3).lyricist == QLatin1String("Lyricist Y"), "track 4 has its own lyricist");
+    }
+
+    qInfo() << "Shared composer and instrumental (spans/shared_composer.html)";
+    {
+        const Tagger::AlbumMetadata album = parseFile(QStringLiteral("test/data/wikipedia/spans/shared_composer.html"));
+        check(album.tracks.size() == 4, "4 tracks, no Total length row");
+        check(hasTrack(album, 1, "Theme (instrumental)", ""), "instrumental title does not become its singer");
+        check(album.tracks.value(1).composer == QLatin1String("Composer X"), "composer carried down");
+        check(album.tracks.value(1).durationSeconds == 130, "instrumental length read from its own column");
+        check(album.tracks.value(3).composer == QLatin1String("Composer Y"), "second composer block");
+    }
+
+    qInfo() << "Grouped header and merged versions (spans/grouped_header.html)";
+    {
+        const Tagger::AlbumMetadata album = parseFile(QStringLiteral("test/data/wikipedia/spans/grouped_header.html"));
+        check(album.tracks.size() == 3, "3 tracks, second version row not a track");
+        check(hasTrack(album, 0, "Oru Naal", "Singer A"), "grouped singer header names its first column");
+        check(album.tracks.value(0).durationSeconds == 284, "length column after the grouped header");
+        check(hasTrack(album, 1, "Iru Vizhi", "Singer C") && album.tracks.value(1).trackNumber == 2,
+              "merged title read once");
+        check(hasTrack(album, 2, "Moondru", "Chorus") && album.tracks.value(2).durationSeconds == 183,
+              "singer spanning both columns");
+    }
+
+    qInfo().noquote() << (failures == 0 ? "All checks passed" : QStringLiteral("%1 check(s) failed").arg(failures));
+    return failures == 0 ? 0 : 1;
+}
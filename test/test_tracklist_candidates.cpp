@@ -0,0 +1,126 @@
+// Checks that every tracklist table of a soundtrack section is collected
+// and that the best-fitting one is picked for a set of local durations,
+// that releases of a group are weighed by durations and disc layout, and
+// that search results are ranked by title and track count.
+
+#include "models/albummetadata.h"
+#include "sources/wikipediaparser.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QDebug>
+
+namespace {
+int failures{0};
+
+void check(bool condition, const char* what)
+{
+    qInfo().noquote() << (condition ? "  ok   " : "  FAIL ") << what;
+    if(!condition) {
+        ++failures;
+    }
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QFile file(QStringLiteral(TAGGER_SOURCE_DIR "/test/data/wikipedia/multi_version.html"));
+    if(!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open" << file.fileName();
+        return 1;
+    }
+    const QByteArray html = file.readAll();
+
+    const Tagger::AlbumMetadata album = WikipediaParser::parsePage(html, QStringLiteral("https://en.wikipedia.org/wiki/Example"));
+
+    qInfo() << "Candidates";
+    check(album.candidates.size() == 2, "both language versions found, chart table skipped");
+    check(album.candidates.value(0).name == QLatin1String("Tamil version"), "first named after its sub-heading");
+    check(album.candidates.value(1).name == QLatin1String("Telugu track listing"), "second named after its caption");
+    check(album.tracks.size() == 3 && album.tracks.constFirst().title == QLatin1String("Malare"),
+          "first tracklist active by default");
+    check(album.candidates.value(1).tracks.value(2).totalTracks == 3, "totals set per tracklist");
+
+    qInfo() << "Best fit";
+    // Telugu durations, slightly off as ripped files are
+    check(Tagger::bestTrackListCandidate(album, {251, 319, 211}) == 1, "durations select the Telugu version");
+    check(Tagger::bestTrackListCandidate(album, {253, 300, 226}) == 0, "durations select the Tamil version");
+    check(Tagger::bestTrackListCandidate(album, {0, 0, 0}) == 0, "without durations the first table wins a tie");
+
+    Tagger::AlbumMetadata chosen = album;
+    Tagger::useTrackListCandidate(chosen, 1);
+    check(chosen.tracks.constFirst().title == QLatin1String("Puvvulaa"), "switching the active tracklist");
+
+    qInfo() << "Releases of a group";
+    {
+        auto release = [](const char* id, const QList<int>& durations, const QList<int>& discs) {
+            Tagger::TrackListCandidate candidate;
+            candidate.releaseId = QString::fromLatin1(id);
+            candidate.discTrackCounts = discs;
+            int disc{1};
+            int onDisc{0};
+            for(const int duration : durations) {
+                Tagger::TrackMetadata track;
+                track.durationSeconds = duration;
+                if(++onDisc > discs.value(disc - 1)) {
+                    ++disc;
+                    onDisc = 1;
+                }
+                track.discNumber = disc;
+                candidate.tracks.append(track);
+            }
+            return candidate;
+        };
+
+        QList<int> standard;
+        for(int i = 0; i < 10; ++i) {
+            standard.append(200 + i * 10);
+        }
+        const QList<int> deluxe = standard + QList<int>{410, 420, 430};
+
+        Tagger::AlbumMetadata group;
+        group.candidates.append(release("standard", standard, {10}));
+        group.candidates.append(release("deluxe", deluxe, {13}));
+        // Listed with its layout only
+        group.candidates.append(release("two-disc", {}, {6, 4}));
+
+        check(Tagger::bestTrackListCandidate(group, deluxe) == 1, "bonus tracks select the deluxe edition");
+        check(Tagger::bestTrackListCandidate(group, standard) == 0,
+              "a release without tracks is not worth fetching when it can at best tie");
+        check(Tagger::bestTrackListCandidate(group, standard, {6, 4}) == 2,
+              "it is when only its disc layout fits the files");
+
+        group.candidates[2] = release("two-disc", QList<int>(10, 400), {6, 4});
+        check(Tagger::bestTrackListCandidate(group, standard, {6, 4}) == 0,
+              "once fetched, durations that do not fit lose to a single disc that does");
+    }
+
+    qInfo() << "Search result ranking";
+    {
+        QList<Tagger::AlbumMetadata> results;
+        for(const char* title : {"Annakili (Live)", "Annakili", "Annakili: Songs", "Something Else"}) {
+            Tagger::AlbumMetadata result;
+            result.album = QString::fromLatin1(title);
+            results.append(result);
+        }
+        const QList<int> trackCounts{20, 12, 0, 12};
+
+        const QList<qsizetype> order = Tagger::rankSearchResults(results, trackCounts, QStringLiteral("annakili"), 12);
+        check(order == QList<qsizetype>{1, 0, 2, 3}, "title and track count both fitting come first");
+        check(Tagger::rankSearchResults(results, trackCounts, {}, 0) == QList<qsizetype>{0, 1, 2, 3},
+              "nothing to go by keeps the server's order");
+        check(Tagger::rankSearchResults(results, {}, QStringLiteral("Something Else"), 12).constFirst() == 3,
+              "unknown track counts rank by title alone");
+
+        // What TaggingManager::setLocalTrackCount() hands the sources for their prefetches
+        check(Tagger::rankSearchResults(results, trackCounts, {}, 12) == QList<qsizetype>{1, 3, 0, 2},
+              "twelve local tracks put the twelve-track releases first");
+        check(Tagger::rankSearchResults(results, trackCounts, {}, 20) == QList<qsizetype>{0, 1, 3, 2},
+              "twenty put the twenty-track release first");
+    }
+
+    qInfo().noquote() << (failures == 0 ? "All checks passed" : QStringLiteral("%1 check(s) failed").arg(failures));
+    return failures == 0 ? 0 : 1;
+}
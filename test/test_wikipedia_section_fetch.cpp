@@ -0,0 +1,225 @@
+// Runs WikipediaSource against a local stand-in for Wikipedia that serves
+// recorded parse API responses (test/data/wikipedia) and the saved
+// annakili.html page, and checks both the section-only path and the
+// fallback to the full page.
+
+#include "standinserver.h"
+
+#include "core/httpclient.h"
+#include "core/metadatacache.h"
+#include "sources/wikipediaparser.h"
+#include "sources/wikipediasource.h"
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QDebug>
+
+namespace {
+const QString PageUrl = QStringLiteral("https://en.wikipedia.org/wiki/Annakili_(soundtrack)");
+const QString PagePath = QStringLiteral("/wiki/Annakili_(soundtrack)");
+const QString ApiPath = QStringLiteral("/w/api.php");
+
+QByteArray readFile(const QString& path)
+{
+    QFile file(QStringLiteral(TAGGER_SOURCE_DIR "/") + path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open" << file.fileName();
+        return {};
+    }
+    return file.readAll();
+}
+
+struct Outcome
+{
+    bool completed{false};
+    Tagger::AlbumMetadata metadata;
+    QString error;
+};
+
+Outcome fetch(WikipediaSource& source, const QString& url)
+{
+    Outcome outcome;
+    QEventLoop loop;
+
+    QObject::connect(&source, &MetadataSource::fetchCompleted, &loop, [&](const Tagger::AlbumMetadata& metadata) {
+        outcome.completed = true;
+        outcome.metadata = metadata;
+        loop.quit();
+    });
+    QObject::connect(&source, &MetadataSource::fetchFailed, &loop, [&](const QString& error) {
+        outcome.error = error;
+        loop.quit();
+    });
+    QTimer::singleShot(10000, &loop, [&]() {
+        outcome.error = QStringLiteral("timed out");
+        loop.quit();
+    });
+
+    source.fetchFromUrl(url);
+    loop.exec();
+    source.disconnect(&loop);
+    return outcome;
+}
+
+bool sameTracks(const Tagger::AlbumMetadata& a, const Tagger::AlbumMetadata& b)
+{
+    if(a.album != b.album || a.tracks.size() != b.tracks.size()) {
+        return false;
+    }
+    for(qsizetype i = 0; i < a.tracks.size(); ++i) {
+        const auto& x = a.tracks[i];
+        const auto& y = b.tracks[i];
+        if(x.title != y.title || x.artist != y.artist || x.trackNumber != y.trackNumber
+           || x.durationSeconds != y.durationSeconds) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool requested(const StandInServer& server, const QString& path)
+{
+    for(const QUrl& url : server.requests()) {
+        if(url.path() == path) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int failures{0};
+
+void check(bool condition, const char* what)
+{
+    qInfo().noquote() << (condition ? "  ok   " : "  FAIL ") << what;
+    if(!condition) {
+        ++failures;
+    }
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const QByteArray page = readFile(QStringLiteral("annakili.html"));
+    const QByteArray sections = readFile(QStringLiteral("test/data/wikipedia/annakili_sections.json"));
+    const QByteArray section = readFile(QStringLiteral("test/data/wikipedia/annakili_section3.json"));
+    if(page.isEmpty() || sections.isEmpty() || section.isEmpty()) {
+        return 1;
+    }
+
+    const Tagger::AlbumMetadata expected = WikipediaParser::parsePage(page, PageUrl);
+
+    StandInServer server;
+    if(!server.listen()) {
+        qWarning() << "Could not start the stand-in server";
+        return 1;
+    }
+
+    // Keeps the default response cache out of the real config directory
+    QStandardPaths::setTestModeEnabled(true);
+    HttpClient client;
+    // Every fetch below has to reach the server
+    client.setCacheDirectory({});
+    MetadataSource::metadataCache()->setDirectory({});
+    WikipediaSource source(&client);
+    source.setServerOverride(server.url());
+
+    const StandInServer::Response pageResponse{200, "text/html; charset=UTF-8", page};
+    const StandInServer::Response sectionsResponse{200, "application/json; charset=utf-8", sections};
+    const StandInServer::Response sectionResponse{200, "application/json; charset=utf-8", section};
+
+    qInfo() << "Section-only fetch";
+    {
+        server.route(ApiPath, {{QStringLiteral("prop"), QStringLiteral("sections|revid")}}, sectionsResponse);
+        server.route(ApiPath, {{QStringLiteral("section"), QStringLiteral("3")}}, sectionResponse);
+        server.route(PagePath, {}, pageResponse);
+
+        const Outcome outcome = fetch(source, PageUrl);
+        check(outcome.completed, "fetch completed");
+        check(sameTracks(outcome.metadata, expected), "tracks match the full-page parse");
+        check(server.requests().size() == 2, "two API requests");
+        check(!requested(server, PagePath), "full page not downloaded");
+        qInfo().noquote() << QStringLiteral("  %1 bytes transferred instead of %2 (%3%)")
+                                 .arg(server.bytesServed())
+                                 .arg(page.size())
+                                 .arg(100.0 * static_cast<double>(server.bytesServed()) / static_cast<double>(page.size()), 0, 'f', 1);
+    }
+
+    qInfo() << "Section chosen by URL fragment";
+    {
+        server.clear();
+        server.route(ApiPath, {{QStringLiteral("prop"), QStringLiteral("sections|revid")}}, sectionsResponse);
+        server.route(ApiPath, {{QStringLiteral("section"), QStringLiteral("3")}}, sectionResponse);
+
+        const Outcome outcome = fetch(source, PageUrl + QStringLiteral("#Track_listing"));
+        check(outcome.completed && sameTracks(outcome.metadata, expected), "fetch completed");
+    }
+
+    qInfo() << "Fallback when the API fails";
+    {
+        server.clear();
+        server.route(ApiPath, {}, {503, "text/plain", "Service unavailable"});
+        server.route(PagePath, {}, pageResponse);
+
+        const Outcome outcome = fetch(source, PageUrl);
+        check(outcome.completed, "fetch completed");
+        check(sameTracks(outcome.metadata, expected), "tracks match the full-page parse");
+        check(requested(server, PagePath), "full page downloaded");
+    }
+
+    qInfo() << "Fallback on an API error reply";
+    {
+        server.clear();
+        server.route(ApiPath, {},
+                     {200, "application/json; charset=utf-8",
+                      R"({"error":{"code":"missingtitle","info":"The page you specified doesn't exist."}})"});
+        server.route(PagePath, {}, pageResponse);
+
+        const Outcome outcome = fetch(source, PageUrl);
+        check(outcome.completed && sameTracks(outcome.metadata, expected), "fetch completed from the full page");
+    }
+
+    qInfo() << "Fallback when the section request fails";
+    {
+        server.clear();
+        server.route(ApiPath, {{QStringLiteral("prop"), QStringLiteral("sections|revid")}}, sectionsResponse);
+        server.route(ApiPath, {{QStringLiteral("section"), QStringLiteral("3")}}, {500, "text/plain", "Internal error"});
+        server.route(PagePath, {}, pageResponse);
+
+        const Outcome outcome = fetch(source, PageUrl);
+        check(outcome.completed && sameTracks(outcome.metadata, expected), "fetch completed from the full page");
+    }
+
+    qInfo() << "Parsed album from the metadata cache";
+    {
+        QTemporaryDir cacheDir;
+        MetadataSource::metadataCache()->setDirectory(cacheDir.path());
+
+        server.clear();
+        server.route(ApiPath, {{QStringLiteral("prop"), QStringLiteral("sections|revid")}}, sectionsResponse);
+        server.route(ApiPath,
+                     {{QStringLiteral("section"), QStringLiteral("3")},
+                      {QStringLiteral("oldid"), QStringLiteral("1245508841")}},
+                     sectionResponse);
+
+        const Outcome first = fetch(source, PageUrl);
+        check(first.completed && server.requests().size() == 2, "first fetch parses the section of that revision");
+
+        server.clear();
+        server.route(ApiPath, {{QStringLiteral("prop"), QStringLiteral("sections|revid")}}, sectionsResponse);
+        const Outcome second = fetch(source, PageUrl);
+        check(second.completed && sameTracks(second.metadata, expected), "second fetch completed");
+        check(server.requests().size() == 1, "section neither downloaded nor parsed again");
+
+        MetadataSource::metadataCache()->setDirectory({});
+    }
+
+    qInfo().noquote() << (failures == 0 ? "All checks passed" : QStringLiteral("%1 check(s) failed").arg(failures));
+    return failures == 0 ? 0 : 1;
+}